@@ -0,0 +1,733 @@
+#include "graphics.h"
+#include "headless_platform.h"
+#include "font.h"
+#include "modern_gui.h"
+#include "worker_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+// Микробенчмарки примитивов GraphicsManager на хосте.
+//
+// Каждый случай - один примитив с параметрами (размер, альфа, отсечение)
+// или целый кадр с настройками рендера. Вызовы повторяются, пока не наберется
+// заданное время; результат - нс на вызов и мегапиксели в секунду, где пиксели -
+// площадь рамки примитива после отсечения (так же их считает FrameStats).
+// JSON пишется по случаю на строку, чтобы прогоны разных коммитов сравнивались diff'ом.
+// Кадры отложенного режима дополнительно меряются на 1..3 потоках, и для них
+// печатается эффективность масштабирования относительно одного потока.
+// Случаи reference.* - заливки до перехода на отрезки, для сравнения "до/после".
+
+namespace {
+
+    typedef std::chrono::steady_clock Clock;
+    
+    const int FRAME_WIDTH = 1280;
+    const int FRAME_HEIGHT = 720;
+    
+    // Положение отсечения относительно примитива
+    enum class ClipMode {
+        NONE,       // Примитив целиком виден
+        PARTIAL,    // Видна левая половина
+        OUTSIDE     // Примитив целиком отсечен
+    };
+    
+    const char* clipName(ClipMode clip) {
+        switch (clip) {
+            case ClipMode::NONE: return "none";
+            case ClipMode::PARTIAL: return "partial";
+            case ClipMode::OUTSIDE: return "outside";
+        }
+        return "";
+    }
+    
+    // Настройки рендера для случаев-кадров
+    struct RenderMode {
+        const char* name;
+        bool deferred;
+        bool backBuffer;
+        bool lowPower;
+    };
+    
+    const RenderMode RENDER_MODES[] = {
+        { "immediate", false, true, false },
+        { "immediate-direct", false, false, false },
+        { "immediate-rgb565", false, true, true },
+        { "deferred", true, true, false },
+        { "deferred-direct", true, false, false },
+        { "deferred-rgb565", true, true, true }
+    };
+    
+    struct Case {
+        std::string name;
+        std::string primitive;
+        int size;
+        int alpha;
+        ClipMode clip;
+        const RenderMode* mode;     // Для кадров; у примитивов - nullptr
+        bool ownsFrame;             // draw сам вызывает beginFrame/endFrame
+        int threads;                // Потоки рендера; 0 - как задано --threads
+        int64_t pixels;             // Площадь вызова, если draw рисует мимо GFX; иначе 0
+        int x, y, w, h;             // Рамка примитива (для отсечения)
+        std::function<void()> draw;
+    };
+    
+    struct Measurement {
+        std::string name;
+        long iterations;
+        double nsPerCall;
+        double megapixelsPerSecond;
+        double efficiency;          // Для случаев с threads: t1 / (threads * t), иначе 0
+    };
+    
+    struct Options {
+        double minSeconds;
+        std::string filter;
+        std::string jsonPath;
+        std::string baselinePath;
+        int threads;
+    };
+    
+    void applyRenderMode(const RenderMode* mode) {
+        RenderMode defaults = { "", false, true, false };
+        if (!mode) mode = &defaults;
+        GFX->setDeferred(mode->deferred);
+        GFX->setBackBuffer(mode->backBuffer);
+        if (GFX->isLowPowerMode() != mode->lowPower) GFX->setLowPowerMode(mode->lowPower);
+    }
+    
+    void pushCaseClip(const Case& c) {
+        switch (c.clip) {
+            case ClipMode::NONE:
+                break;
+            case ClipMode::PARTIAL:
+                GFX->pushClip(c.x, c.y, c.w / 2, c.h);
+                break;
+            case ClipMode::OUTSIDE:
+                GFX->pushClip(c.x + c.w + 16, c.y + c.h + 16, 8, 8);
+                break;
+        }
+    }
+    
+    void popCaseClip(const Case& c) {
+        if (c.clip != ClipMode::NONE) GFX->popClip();
+    }
+    
+    // Закрашенная площадь одного вызова: счетчик кадра без очистки фоном
+    int64_t paintedPerCall(const Case& c) {
+        GFX->beginFrame();
+        GFX->endFrame();
+        int64_t background = GFX->getFrameStats().paintedPixels;
+        
+        GFX->beginFrame();
+        pushCaseClip(c);
+        c.draw();
+        popCaseClip(c);
+        GFX->endFrame();
+        return GFX->getFrameStats().paintedPixels - background;
+    }
+    
+    // Примитивы рисуются сразу в задний буфер; кадр вызывается
+    // целиком, вместе с очисткой и выводом
+    Measurement measure(const Case& c, const Options& options) {
+        applyRenderMode(c.mode);
+        int threads = c.threads ? c.threads : options.threads;
+        if (GFX->getRenderThreads() != threads) GFX->setRenderThreads(threads);
+        
+        double minSeconds = options.minSeconds;
+        Measurement result;
+        result.name = c.name;
+        result.efficiency = 0;
+        int64_t pixels = c.mode ? 0 : c.pixels ? c.pixels : paintedPerCall(c);
+        
+        long iterations = 1;
+        double seconds = 0;
+        while (true) {
+            Clock::time_point start;
+            if (c.mode) {
+                start = Clock::now();
+                for (long i = 0; i < iterations; i++) {
+                    if (c.ownsFrame) {
+                        c.draw();
+                        continue;
+                    }
+                    GFX->beginFrame();
+                    c.draw();
+                    GFX->endFrame();
+                }
+                pixels = GFX->getFrameStats().paintedPixels;
+            } else {
+                GFX->beginFrame();
+                pushCaseClip(c);
+                c.draw();
+                start = Clock::now();
+                for (long i = 0; i < iterations; i++) {
+                    c.draw();
+                }
+            }
+            seconds = std::chrono::duration<double>(Clock::now() - start).count();
+            if (!c.mode) {
+                popCaseClip(c);
+                GFX->endFrame();
+            }
+            
+            if (seconds >= minSeconds || iterations >= (1L << 30)) break;
+            // Следующая попытка с запасом на все оставшееся время
+            double scale = seconds > 0 ? minSeconds / seconds * 1.2 : 16;
+            iterations = (long)(iterations * std::min(16.0, std::max(2.0, scale)));
+        }
+        
+        result.iterations = iterations;
+        result.nsPerCall = seconds * 1e9 / iterations;
+        result.megapixelsPerSecond = pixels * (double)iterations / seconds / 1e6;
+        return result;
+    }
+    
+    std::string caseName(const std::string& primitive, int size, int alpha, ClipMode clip) {
+        char name[128];
+        snprintf(name, sizeof(name), "%s/size=%d/alpha=%d/clip=%s", primitive.c_str(), size, alpha, clipName(clip));
+        return name;
+    }
+    
+    void addPrimitive(std::vector<Case>& cases, const std::string& primitive, int size, int alpha, ClipMode clip,
+                      int w, int h, const std::function<void(int x, int y, const Color& color)>& draw) {
+        Case c;
+        c.name = caseName(primitive, size, alpha, clip);
+        c.primitive = primitive;
+        c.size = size;
+        c.alpha = alpha;
+        c.clip = clip;
+        c.mode = nullptr;
+        c.ownsFrame = false;
+        c.threads = 0;
+        c.pixels = 0;
+        c.x = 100;
+        c.y = 60;
+        c.w = w;
+        c.h = h;
+        
+        Color color(40, 200, 255, alpha);
+        int x = c.x, y = c.y;
+        c.draw = [=]() { draw(x, y, color); };
+        cases.push_back(c);
+    }
+    
+    // Полупрозрачный спрайт для drawImage, растягиваемый до размера случая
+    const int SPRITE_SIZE = 64;
+    
+    const std::vector<uint32_t>& sprite() {
+        static std::vector<uint32_t> pixels;
+        if (pixels.empty()) {
+            for (int y = 0; y < SPRITE_SIZE; y++) {
+                for (int x = 0; x < SPRITE_SIZE; x++) {
+                    pixels.push_back(Color(x * 4, y * 4, 255 - x * 2, 128 + x + y).toPremultiplied());
+                }
+            }
+        }
+        return pixels;
+    }
+    
+    // Заливки до перехода на отрезки: каждый пиксель - отдельный drawPixel
+    // с проверкой границ и смешиванием во float. Код перенесен без изменений,
+    // рисует в свой буфер размером с кадр.
+    namespace Reference {
+        
+        std::vector<uint32_t> framebuffer(FRAME_WIDTH * FRAME_HEIGHT, 0x101018FF);
+        
+        void drawPixel(int x, int y, const Color& color) {
+            if (x < 0 || x >= FRAME_WIDTH || y < 0 || y >= FRAME_HEIGHT) return;
+            
+            uint32_t* pixel = framebuffer.data() + y * FRAME_WIDTH + x;
+            if (color.a == 255) {
+                *pixel = color.toRGBA();
+            } else {
+                uint32_t existing = *pixel;
+                uint8_t er = (existing >> 24) & 0xFF;
+                uint8_t eg = (existing >> 16) & 0xFF;
+                uint8_t eb = (existing >> 8) & 0xFF;
+                
+                float alpha = color.a / 255.0f;
+                uint8_t nr = (uint8_t)(color.r * alpha + er * (1.0f - alpha));
+                uint8_t ng = (uint8_t)(color.g * alpha + eg * (1.0f - alpha));
+                uint8_t nb = (uint8_t)(color.b * alpha + eb * (1.0f - alpha));
+                
+                *pixel = (nr << 24) | (ng << 16) | (nb << 8) | 0xFF;
+            }
+        }
+        
+        void drawRect(float x, float y, float width, float height, const Color& color) {
+            int ix = (int)x, iy = (int)y;
+            int iw = (int)width, ih = (int)height;
+            
+            for (int py = iy; py < iy + ih; py++) {
+                for (int px = ix; px < ix + iw; px++) {
+                    drawPixel(px, py, color);
+                }
+            }
+        }
+        
+        void drawRoundedRect(float x, float y, float width, float height, float radius, const Color& color) {
+            int ix = (int)x, iy = (int)y;
+            int iw = (int)width, ih = (int)height;
+            int ir = (int)radius;
+            
+            drawRect(x + radius, y, width - 2 * radius, height, color);
+            drawRect(x, y + radius, width, height - 2 * radius, color);
+            
+            for (int py = 0; py < ir; py++) {
+                for (int px = 0; px < ir; px++) {
+                    float dist = sqrt((px - ir) * (px - ir) + (py - ir) * (py - ir));
+                    if (dist <= ir) {
+                        drawPixel(ix + px, iy + py, color);
+                        drawPixel(ix + iw - ir + px, iy + py, color);
+                        drawPixel(ix + px, iy + ih - ir + py, color);
+                        drawPixel(ix + iw - ir + px, iy + ih - ir + py, color);
+                    }
+                }
+            }
+        }
+        
+        void drawCircle(float x, float y, float radius, const Color& color) {
+            int ix = (int)x, iy = (int)y;
+            int ir = (int)radius;
+            
+            for (int py = -ir; py <= ir; py++) {
+                for (int px = -ir; px <= ir; px++) {
+                    if (px * px + py * py <= ir * ir) {
+                        drawPixel(ix + px, iy + py, color);
+                    }
+                }
+            }
+        }
+        
+        void drawGradient(float x, float y, float width, float height,
+                          const Color& startColor, const Color& endColor, bool vertical) {
+            int ix = (int)x, iy = (int)y;
+            int iw = (int)width, ih = (int)height;
+            
+            for (int py = 0; py < ih; py++) {
+                for (int px = 0; px < iw; px++) {
+                    float t = vertical ? (float)py / ih : (float)px / iw;
+                    
+                    uint8_t r = (uint8_t)(startColor.r + t * (endColor.r - startColor.r));
+                    uint8_t g = (uint8_t)(startColor.g + t * (endColor.g - startColor.g));
+                    uint8_t b = (uint8_t)(startColor.b + t * (endColor.b - startColor.b));
+                    uint8_t a = (uint8_t)(startColor.a + t * (endColor.a - startColor.a));
+                    
+                    drawPixel(ix + px, iy + py, Color(r, g, b, a));
+                }
+            }
+        }
+    }
+    
+    // Те же размеры и цвета, что у drawRect и др.; отсечения у старого кода не было
+    void addReferenceCases(std::vector<Case>& cases) {
+        const int SIZES[] = { 8, 32, 128, 512 };
+        const int ALPHAS[] = { 255, 128 };
+        
+        for (int size : SIZES) {
+            for (int alpha : ALPHAS) {
+                size_t first = cases.size();
+                addPrimitive(cases, "reference.drawRect", size, alpha, ClipMode::NONE, size, size,
+                             [=](int x, int y, const Color& color) {
+                    Reference::drawRect(x, y, size, size, color);
+                });
+                addPrimitive(cases, "reference.drawRoundedRect", size, alpha, ClipMode::NONE, size, size,
+                             [=](int x, int y, const Color& color) {
+                    Reference::drawRoundedRect(x, y, size, size, size / 4, color);
+                });
+                addPrimitive(cases, "reference.drawCircle", size, alpha, ClipMode::NONE, size, size,
+                             [=](int x, int y, const Color& color) {
+                    Reference::drawCircle(x + size / 2, y + size / 2, size / 2, color);
+                });
+                addPrimitive(cases, "reference.drawGradient", size, alpha, ClipMode::NONE, size, size,
+                             [=](int x, int y, const Color& color) {
+                    Reference::drawGradient(x, y, size, size, color, Color(255, 60, 120, color.a), true);
+                });
+                for (size_t i = first; i < cases.size(); i++) {
+                    cases[i].pixels = (int64_t)size * size;
+                }
+            }
+        }
+    }
+    
+    // Ускорение относительно старых заливок: reference.X против X с теми же параметрами
+    void reportReference(const std::vector<Measurement>& results) {
+        std::map<std::string, double> current;
+        for (const Measurement& r : results) {
+            current[r.name] = r.nsPerCall;
+        }
+        
+        bool header = false;
+        for (const Measurement& r : results) {
+            if (r.name.compare(0, 10, "reference.") != 0) continue;
+            auto now = current.find(r.name.substr(10));
+            if (now == current.end() || now->second <= 0) continue;
+            
+            if (!header) {
+                printf("\nBefore/after: per-pixel reference against the span fill\n");
+                header = true;
+            }
+            printf("%-52s %12.1f -> %10.1f ns/call %8.1fx\n", now->first.c_str(), r.nsPerCall, now->second,
+                   r.nsPerCall / now->second);
+        }
+    }
+    
+    // Случаи-примитивы: каждый метод по размерам, альфе и отсечению
+    void addPrimitiveCases(std::vector<Case>& cases) {
+        const int SIZES[] = { 8, 32, 128, 512 };
+        const int ALPHAS[] = { 255, 128 };
+        const ClipMode CLIPS[] = { ClipMode::NONE, ClipMode::PARTIAL, ClipMode::OUTSIDE };
+        
+        for (int size : SIZES) {
+            for (int alpha : ALPHAS) {
+                for (ClipMode clip : CLIPS) {
+                    addPrimitive(cases, "drawRect", size, alpha, clip, size, size,
+                                 [=](int x, int y, const Color& color) {
+                        GFX->drawRect(x, y, size, size, color);
+                    });
+                    addPrimitive(cases, "drawRoundedRect", size, alpha, clip, size, size,
+                                 [=](int x, int y, const Color& color) {
+                        GFX->drawRoundedRect(x, y, size, size, size / 4, color);
+                    });
+                    addPrimitive(cases, "drawCircle", size, alpha, clip, size, size,
+                                 [=](int x, int y, const Color& color) {
+                        GFX->drawCircle(x + size / 2, y + size / 2, size / 2, color);
+                    });
+                    addPrimitive(cases, "drawLine", size, alpha, clip, size + 2, size / 2 + 2,
+                                 [=](int x, int y, const Color& color) {
+                        GFX->drawLine(x + 1, y + 1, x + 1 + size, y + 1 + size / 2, color, 1.0f);
+                    });
+                    addPrimitive(cases, "drawLineThick", size, alpha, clip, size + 4, size / 2 + 4,
+                                 [=](int x, int y, const Color& color) {
+                        GFX->drawLine(x + 2, y + 2, x + 2 + size, y + 2 + size / 2, color, 3.0f);
+                    });
+                    addPrimitive(cases, "drawGradient", size, alpha, clip, size, size,
+                                 [=](int x, int y, const Color& color) {
+                        GFX->drawGradient(x, y, size, size, color, Color(255, 60, 120, color.a), true);
+                    });
+                    addPrimitive(cases, "drawShadow", size, alpha, clip, size + 24, size + 24,
+                                 [=](int x, int y, const Color& color) {
+                        GFX->drawShadow(x, y, size, size, 12, color.a / 255.0f);
+                    });
+                    addPrimitive(cases, "drawGlow", size, alpha, clip, size + 10, size + 10,
+                                 [=](int x, int y, const Color& color) {
+                        GFX->drawGlow(x + 5, y + 5, size, size, color, color.a / 255.0f);
+                    });
+                    
+                    // Спрайт size x size; повернутый занимает квадрат со стороной size * 3 / 2
+                    float scale = (float)size / SPRITE_SIZE;
+                    addPrimitive(cases, "drawImage", size, alpha, clip, size, size,
+                                 [=](int x, int y, const Color& color) {
+                        GFX->drawImage(sprite().data(), SPRITE_SIZE, SPRITE_SIZE, SPRITE_SIZE, x, y,
+                                       scale, scale, 0.0f, color.a / 255.0f);
+                    });
+                    addPrimitive(cases, "drawImageRotated", size, alpha, clip, size * 3 / 2, size * 3 / 2,
+                                 [=](int x, int y, const Color& color) {
+                        GFX->drawImage(sprite().data(), SPRITE_SIZE, SPRITE_SIZE, SPRITE_SIZE, x + size / 4, y + size / 4,
+                                       scale, scale, 0.5f, color.a / 255.0f);
+                    });
+                    
+                    // Размер текста - высота шрифта, строка фиксированной длины
+                    std::string text = "NEOVIA benchmark";
+                    int fontSize = std::min(size, 64);
+                    addPrimitive(cases, "drawText", size, alpha, clip, FONTS->get(fontSize)->measure(text), fontSize + 1,
+                                 [=](int x, int y, const Color& color) {
+                        GFX->drawText(text, x, y, color, fontSize);
+                    });
+                    
+                    // Заливка и свечение по полю расстояний; отступ под свечение - треть размера
+                    int pad = fontSize / 3;
+                    addPrimitive(cases, "drawStyledText", size, alpha, clip,
+                                 FONTS->get(fontSize)->measure(text) + 2 * pad, fontSize + 2 * pad,
+                                 [=](int x, int y, const Color& color) {
+                        TextStyle style = { color, Color(0, 0, 0, 0), Color(255, 60, 120, color.a / 2), 0.0f, pad * 0.8f };
+                        GFX->drawStyledText(text, x + pad, y + pad, fontSize, style);
+                    });
+                }
+            }
+        }
+    }
+    
+    // Облако частиц: пакет кругов, как фон ModernGUI
+    struct Particles {
+        std::vector<float> x, y, radius;
+        std::vector<uint32_t> colors;
+        std::vector<Color> tints;       // Те же цвета для поштучных вызовов drawCircle
+        
+        explicit Particles(int count) {
+            std::mt19937 random(42);
+            std::uniform_real_distribution<float> px(0, FRAME_WIDTH), py(0, FRAME_HEIGHT), pr(1, 4);
+            for (int i = 0; i < count; i++) {
+                x.push_back(px(random));
+                y.push_back(py(random));
+                radius.push_back(pr(random));
+                tints.push_back(Color(0, 200, 255, 60 + random() % 160));
+                colors.push_back(tints.back().toRGBA());
+            }
+        }
+    };
+    
+    // Кадр, похожий на экран настроек: панель с тенью и рамкой, кнопки и текст
+    void drawUiFrame() {
+        GFX->drawShadow(204, 108, 880, 520, 12, 0.4f);
+        GFX->drawGradient(200, 100, 880, 520, Colors::SURFACE, Color(22, 22, 30), true);
+        GFX->drawRoundedRect(199, 99, 882, 522, 17, Color(0, 200, 255, 100));
+        for (int i = 0; i < 6; i++) {
+            float y = 160 + i * 70;
+            GFX->drawGlow(260, y, 400, 56, Colors::PRIMARY, 0.3f);
+            GFX->drawRoundedRect(260, y, 400, 56, 12, Colors::PRIMARY);
+            GFX->drawTextCentered("Setting", 260, y + 20, 400, Colors::TEXT, 16);
+        }
+        for (int i = 0; i < 24; i++) {
+            GFX->drawLine(700, 160 + i * 18, 1040, 180 + i * 18, Color(255, 255, 255, 40));
+        }
+    }
+    
+    void addFrameCases(std::vector<Case>& cases) {
+        static Particles particles(10000);
+        
+        for (const RenderMode& mode : RENDER_MODES) {
+            Case c;
+            c.size = 0;
+            c.alpha = 0;
+            c.clip = ClipMode::NONE;
+            c.mode = &mode;
+            c.ownsFrame = false;
+            c.threads = 0;
+            c.pixels = 0;
+            c.x = c.y = 0;
+            c.w = FRAME_WIDTH;
+            c.h = FRAME_HEIGHT;
+            size_t first = cases.size();
+            
+            c.primitive = "frame.particles10k";
+            c.name = c.primitive + "/" + mode.name;
+            c.draw = []() {
+                GFX->drawCircles(particles.x.data(), particles.y.data(), particles.radius.data(),
+                                 particles.colors.data(), (int)particles.colors.size());
+            };
+            cases.push_back(c);
+            
+            // Те же частицы по одной: базовая линия для пакета
+            c.primitive = "frame.particles10k.single";
+            c.name = c.primitive + "/" + mode.name;
+            c.draw = []() {
+                for (size_t i = 0; i < particles.tints.size(); i++) {
+                    GFX->drawCircle(particles.x[i], particles.y[i], particles.radius[i], particles.tints[i]);
+                }
+            };
+            cases.push_back(c);
+            
+            c.primitive = "frame.ui";
+            c.name = c.primitive + "/" + mode.name;
+            c.draw = drawUiFrame;
+            cases.push_back(c);
+            
+            c.primitive = "frame.empty";
+            c.name = c.primitive + "/" + mode.name;
+            c.draw = []() {};
+            cases.push_back(c);
+            
+            // Главное меню приложения целиком: фон с эффектами, неоновый
+            // заголовок, панель с кнопками и значки; анимации идут шагом 1/60 с
+            c.primitive = "frame.mainmenu";
+            c.name = c.primitive + "/" + mode.name;
+            c.ownsFrame = true;
+            c.draw = []() { g_modernGui.render(); };
+            cases.push_back(c);
+            
+            // Масштабирование тайлового рендера: те же кадры на 1..MAX_WORKERS потоках
+            if (mode.deferred && mode.backBuffer && !mode.lowPower) {
+                size_t last = cases.size();
+                for (size_t i = first; i < last; i++) {
+                    for (int threads = 1; threads <= WorkerPool::MAX_WORKERS; threads++) {
+                        Case scaled = cases[i];
+                        scaled.threads = threads;
+                        scaled.name += "/threads=" + std::to_string(threads);
+                        cases.push_back(scaled);
+                    }
+                }
+            }
+        }
+    }
+    
+    // Эффективность случаев с threads = N относительно того же случая на одном
+    // потоке: t1 / (N * tN), 100% - идеальное ускорение
+    void reportScaling(const std::vector<Case>& cases, std::vector<Measurement>& results) {
+        std::map<std::string, double> single;
+        for (size_t i = 0; i < results.size(); i++) {
+            if (cases[i].threads == 1) single[results[i].name] = results[i].nsPerCall;
+        }
+        
+        bool header = false;
+        for (size_t i = 0; i < results.size(); i++) {
+            const Case& c = cases[i];
+            Measurement& r = results[i];
+            if (c.threads == 0) continue;
+            
+            std::string base = r.name.substr(0, r.name.rfind("/threads="));
+            auto t1 = single.find(base + "/threads=1");
+            if (t1 == single.end() || r.nsPerCall <= 0) continue;
+            
+            double speedup = t1->second / r.nsPerCall;
+            r.efficiency = speedup / c.threads;
+            if (!header) {
+                printf("\nScaling, %d core(s): speedup and efficiency against threads=1\n", WorkerPool::getCoreCount());
+                header = true;
+            }
+            printf("%-52s %8.2fx %8.0f%%\n", r.name.c_str(), speedup, r.efficiency * 100.0);
+        }
+    }
+    
+    // Пакет частиц против тех же кругов по одному в каждом режиме и на том же числе потоков
+    void reportBatch(const std::vector<Measurement>& results) {
+        const std::string BATCH = "frame.particles10k/", SINGLE = "frame.particles10k.single/";
+        std::map<std::string, double> single;
+        for (const Measurement& r : results) {
+            if (r.name.compare(0, SINGLE.size(), SINGLE) == 0) single[r.name.substr(SINGLE.size())] = r.nsPerCall;
+        }
+        
+        bool header = false;
+        for (const Measurement& r : results) {
+            if (r.name.compare(0, BATCH.size(), BATCH) != 0 || r.nsPerCall <= 0) continue;
+            auto one = single.find(r.name.substr(BATCH.size()));
+            if (one == single.end()) continue;
+            
+            if (!header) {
+                printf("\nBatch: drawCircles against 10k drawCircle calls\n");
+                header = true;
+            }
+            printf("%-52s %12.1f -> %10.1f ns/call %8.2fx\n", r.name.c_str(), one->second, r.nsPerCall,
+                   one->second / r.nsPerCall);
+        }
+    }
+    
+    // Строки JSON вида {"name": "...", ..., "ns_per_call": N, ...}
+    std::map<std::string, double> loadBaseline(const std::string& path) {
+        std::map<std::string, double> baseline;
+        std::ifstream file(path);
+        std::string line;
+        while (std::getline(file, line)) {
+            size_t name = line.find("\"name\": \"");
+            size_t ns = line.find("\"ns_per_call\": ");
+            if (name == std::string::npos || ns == std::string::npos) continue;
+            name += 9;
+            baseline[line.substr(name, line.find('"', name) - name)] = atof(line.c_str() + ns + 15);
+        }
+        return baseline;
+    }
+    
+    bool writeJson(const std::string& path, const Options& options, const std::vector<Case>& cases,
+                   const std::vector<Measurement>& results) {
+        FILE* file = fopen(path.c_str(), "w");
+        if (!file) return false;
+        
+        fprintf(file, "{\n  \"suite\": \"raster\",\n  \"frame\": [%d, %d],\n  \"threads\": %d,\n  \"cases\": [\n",
+                FRAME_WIDTH, FRAME_HEIGHT, options.threads);
+        for (size_t i = 0; i < results.size(); i++) {
+            const Case& c = cases[i];
+            const Measurement& r = results[i];
+            int threads = c.threads ? c.threads : options.threads;
+            fprintf(file, "    {\"name\": \"%s\", \"primitive\": \"%s\", \"size\": %d, \"alpha\": %d, \"clip\": \"%s\", "
+                    "\"mode\": \"%s\", \"threads\": %d, \"iterations\": %ld, \"ns_per_call\": %.1f, \"mpix_per_s\": %.2f, "
+                    "\"efficiency\": %.3f}%s\n",
+                    r.name.c_str(), c.primitive.c_str(), c.size, c.alpha, clipName(c.clip),
+                    c.mode ? c.mode->name : "immediate", threads, r.iterations, r.nsPerCall, r.megapixelsPerSecond,
+                    r.efficiency, i + 1 < results.size() ? "," : "");
+        }
+        fprintf(file, "  ]\n}\n");
+        fclose(file);
+        return true;
+    }
+    
+    void usage(const char* program) {
+        printf("usage: %s [--filter TEXT] [--min-time MS] [--threads N] [--json FILE] [--baseline FILE]\n", program);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    options.minSeconds = 0.05;
+    options.threads = 0;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--filter" && hasValue) {
+            options.filter = argv[++i];
+        } else if (arg == "--min-time" && hasValue) {
+            options.minSeconds = atof(argv[++i]) / 1000.0;
+        } else if (arg == "--json" && hasValue) {
+            options.jsonPath = argv[++i];
+        } else if (arg == "--baseline" && hasValue) {
+            options.baselinePath = argv[++i];
+        } else if (arg == "--threads" && hasValue) {
+            options.threads = std::max(1, std::min(atoi(argv[++i]), WorkerPool::MAX_WORKERS));
+        } else {
+            usage(argv[0]);
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+    
+    // Время кадра не влияет на примитивы, но фиксированный шаг
+    // делает прогон воспроизводимым
+    HeadlessPlatform* platform = new HeadlessPlatform();
+    platform->setFixedTimestep(1.0 / 60);
+    Platform::setInstance(platform);
+    
+    // Графику инициализирует интерфейс, как в приложении: его главное меню -
+    // один из кадров, а режим рендера каждый случай выставляет сам
+    Config config = {};
+    if (!g_modernGui.initialize(&config)) {
+        printf("Graphics initialization failed\n");
+        return 1;
+    }
+    // Без --threads - столько потоков, сколько выбрала графика
+    if (options.threads == 0) options.threads = GFX->getRenderThreads();
+    
+    std::vector<Case> all;
+    addPrimitiveCases(all);
+    addReferenceCases(all);
+    addFrameCases(all);
+    
+    std::vector<Case> cases;
+    for (const Case& c : all) {
+        if (c.name.find(options.filter) != std::string::npos) cases.push_back(c);
+    }
+    
+    std::map<std::string, double> baseline;
+    if (!options.baselinePath.empty()) baseline = loadBaseline(options.baselinePath);
+    
+    std::vector<Measurement> results;
+    for (const Case& c : cases) {
+        Measurement r = measure(c, options);
+        results.push_back(r);
+        
+        printf("%-52s %12.1f ns/call %10.1f Mpix/s", r.name.c_str(), r.nsPerCall, r.megapixelsPerSecond);
+        auto old = baseline.find(r.name);
+        if (old != baseline.end() && old->second > 0) {
+            printf(" %+7.1f%%", (r.nsPerCall / old->second - 1.0) * 100.0);
+        }
+        printf("\n");
+    }
+    reportScaling(cases, results);
+    reportReference(results);
+    reportBatch(results);
+    
+    if (!options.jsonPath.empty() && !writeJson(options.jsonPath, options, cases, results)) {
+        printf("Cannot write %s\n", options.jsonPath.c_str());
+        return 1;
+    }
+    
+    GFX->cleanup();
+    return 0;
+}
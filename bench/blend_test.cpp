@@ -0,0 +1,184 @@
+#include "blend.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+// Сверка ядер Blend с эталоном Blend::Scalar.
+//
+// Каждое ядро вызывается на случайных отрезках рядом со скалярной версией,
+// результаты должны совпасть побитово. Длины покрывают пустой отрезок,
+// хвосты короче векторного шага и границы шага (15, 16, 17, ...), начало
+// отрезка сдвигается, чтобы попасть на невыровненные адреса. Собирается
+// под тем, что видит компилятор: SSE2 на x86-хосте, NEON на aarch64.
+
+namespace {
+
+    const int ROUNDS = 2000;
+    const int MAX_LENGTH = 300;
+    const int MAX_SHIFT = 3;
+    
+    // Исходная ширина и высота для sampleBilinear
+    const int IMAGE_SIZE = 128;
+    
+    std::mt19937 rng(12345);
+    
+    int randomInt(int lo, int hi) {
+        return std::uniform_int_distribution<int>(lo, hi)(rng);
+    }
+    
+    // Байт с перекосом к краям: 0 и 255 - особые случаи ядер
+    uint32_t randomByte() {
+        switch (randomInt(0, 7)) {
+            case 0: return 0;
+            case 1: return 255;
+            default: return randomInt(0, 255);
+        }
+    }
+    
+    // Корректный предумноженный пиксель: каналы не больше альфы
+    uint32_t randomPixel() {
+        uint32_t a = randomByte();
+        uint32_t r = randomInt(0, a), g = randomInt(0, a), b = randomInt(0, a);
+        return (r << 24) | (g << 16) | (b << 8) | a;
+    }
+    
+    // Длина отрезка: сначала все короткие подряд, затем случайные
+    int spanLength(int round) {
+        if (round <= 64) return round;
+        return randomInt(0, MAX_LENGTH);
+    }
+    
+    struct Spans {
+        std::vector<uint32_t> dst, expected, src;
+        std::vector<uint8_t> mask;
+        int shift, count;
+        
+        explicit Spans(int length) : shift(randomInt(0, MAX_SHIFT)), count(length) {
+            int size = length + MAX_SHIFT + 1;
+            dst.resize(size);
+            src.resize(size);
+            mask.resize(size);
+            for (int i = 0; i < size; i++) {
+                dst[i] = randomPixel();
+                src[i] = randomPixel();
+                mask[i] = (uint8_t)randomByte();
+            }
+            expected = dst;
+        }
+        
+        uint32_t* out() { return dst.data() + shift; }
+        uint32_t* reference() { return expected.data() + shift; }
+        const uint32_t* source() const { return src.data() + shift; }
+        const uint8_t* coverage() const { return mask.data() + shift; }
+    };
+    
+    int failures = 0;
+    
+    // Сравнение всего буфера: ядро не должно писать за концом отрезка
+    void check(const char* kernel, int round, const std::vector<uint32_t>& got, const std::vector<uint32_t>& expected, int count) {
+        for (size_t i = 0; i < got.size(); i++) {
+            if (got[i] != expected[i]) {
+                if (failures < 20) {
+                    printf("FAIL %s: round %d, count %d, index %d: %08X != %08X\n",
+                           kernel, round, count, (int)i, got[i], expected[i]);
+                }
+                failures++;
+                return;
+            }
+        }
+    }
+    
+    void testBlendColor(int round) {
+        Spans s(spanLength(round));
+        uint32_t color = randomPixel();
+        Blend::blendColor(s.out(), s.count, color);
+        Blend::Scalar::blendColor(s.reference(), s.count, color);
+        check("blendColor", round, s.dst, s.expected, s.count);
+    }
+    
+    void testBlendPixels(int round) {
+        Spans s(spanLength(round));
+        Blend::blendPixels(s.out(), s.source(), s.count);
+        Blend::Scalar::blendPixels(s.reference(), s.source(), s.count);
+        check("blendPixels", round, s.dst, s.expected, s.count);
+    }
+    
+    void testBlendPixelsOpacity(int round) {
+        Spans s(spanLength(round));
+        uint32_t opacity = randomByte();
+        Blend::blendPixelsOpacity(s.out(), s.source(), s.count, opacity);
+        Blend::Scalar::blendPixelsOpacity(s.reference(), s.source(), s.count, opacity);
+        check("blendPixelsOpacity", round, s.dst, s.expected, s.count);
+    }
+    
+    void testBlendMask(int round) {
+        Spans s(spanLength(round));
+        uint32_t color = randomPixel();
+        Blend::blendMask(s.out(), s.coverage(), s.count, color);
+        Blend::Scalar::blendMask(s.reference(), s.coverage(), s.count, color);
+        check("blendMask", round, s.dst, s.expected, s.count);
+    }
+    
+    void testCopyPixels(int round) {
+        Spans s(spanLength(round));
+        Blend::copyPixels(s.out(), s.source(), s.count);
+        Blend::Scalar::copyPixels(s.reference(), s.source(), s.count);
+        check("copyPixels", round, s.dst, s.expected, s.count);
+    }
+    
+    // Начало и шаг по оси, при которых все выборки отрезка
+    // и их правые (нижние) соседи лежат внутри источника
+    void randomAxis(int count, int32_t& origin, int32_t& step) {
+        const int32_t limit = (IMAGE_SIZE - 1) << 16;     // t < limit: сосед t + 1 внутри
+        int32_t maxStep = count > 1 ? (limit - 1) / (count - 1) : limit;
+        maxStep = std::min(maxStep, 3 << 16);
+        step = randomInt(-maxStep, maxStep);
+        int64_t span = (int64_t)step * (count > 0 ? count - 1 : 0);
+        int64_t lo = span < 0 ? -span : 0;
+        int64_t hi = limit - 1 - (span > 0 ? span : 0);
+        origin = (int32_t)std::uniform_int_distribution<int64_t>(lo, hi)(rng);
+    }
+    
+    void testSampleBilinear(int round, const std::vector<uint32_t>& image) {
+        Spans s(spanLength(round));
+        int32_t u, v, du, dv;
+        randomAxis(s.count, u, du);
+        randomAxis(s.count, v, dv);
+        if (randomInt(0, 3) == 0) dv = 0;       // Строка источника - частый случай
+        Blend::sampleBilinear(s.out(), image.data(), IMAGE_SIZE, u, v, du, dv, s.count);
+        Blend::Scalar::sampleBilinear(s.reference(), image.data(), IMAGE_SIZE, u, v, du, dv, s.count);
+        check("sampleBilinear", round, s.dst, s.expected, s.count);
+    }
+}
+
+int main() {
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    const char* variant = "NEON";
+#elif defined(__SSE2__)
+    const char* variant = "SSE2";
+#else
+    const char* variant = "scalar";
+#endif
+
+    std::vector<uint32_t> image(IMAGE_SIZE * IMAGE_SIZE);
+    for (uint32_t& pixel : image) pixel = randomPixel();
+    
+    for (int round = 0; round < ROUNDS; round++) {
+        testBlendColor(round);
+        testBlendPixels(round);
+        testBlendPixelsOpacity(round);
+        testBlendMask(round);
+        testCopyPixels(round);
+        testSampleBilinear(round, image);
+    }
+    
+    if (failures) {
+        printf("%s: %d of %d spans differ from Blend::Scalar\n", variant, failures, ROUNDS * 6);
+        return 1;
+    }
+    printf("%s: %d spans match Blend::Scalar\n", variant, ROUNDS * 6);
+    return 0;
+}
@@ -0,0 +1,108 @@
+#pragma once
+#include <cstdint>
+
+// Ядра альфа-смешивания для пикселей RGBA8 (формат Color::toRGBA: r в старшем байте)
+//
+// Все пиксели, попадающие в ядра, хранятся с предумноженной альфой:
+// каналы r, g, b уже умножены на a / 255. Тогда наложение источника
+// поверх приемника - одно умножение со сложением на канал:
+//     out = s + (((255 - a) * d + 128) * 257 >> 16)
+// и альфа обрабатывается так же, как цветовые каналы. Сумма насыщается
+// до 255, поэтому все варианты дают побитово одинаковый результат.
+namespace Blend {
+
+    // Точное округленное x * y / 255 для x, y в диапазоне 0..255
+    inline uint32_t mul255(uint32_t x, uint32_t y) {
+        return ((x * y + 128) * 257) >> 16;
+    }
+    
+    // Перевод упакованного цвета с обычной альфой в предумноженный
+    inline uint32_t premultiply(uint32_t rgba) {
+        uint32_t a = rgba & 0xFF;
+        if (a == 255) return rgba;
+        uint32_t r = mul255(rgba >> 24, a);
+        uint32_t g = mul255((rgba >> 16) & 0xFF, a);
+        uint32_t b = mul255((rgba >> 8) & 0xFF, a);
+        return (r << 24) | (g << 16) | (b << 8) | a;
+    }
+    
+    // Прозрачность 0.0..1.0 в байт 0..255
+    inline uint32_t opacityByte(float opacity) {
+        if (opacity <= 0.0f) return 0;
+        if (opacity >= 1.0f) return 255;
+        return (uint32_t)(opacity * 255 + 0.5f);
+    }
+    
+    // Глобальная прозрачность для предумноженного пикселя - масштаб всех четырех каналов
+    inline uint32_t scalePixel(uint32_t pixel, uint32_t opacity) {
+        if (opacity >= 255) return pixel;
+        return (mul255(pixel >> 24, opacity) << 24) |
+               (mul255((pixel >> 16) & 0xFF, opacity) << 16) |
+               (mul255((pixel >> 8) & 0xFF, opacity) << 8) |
+                mul255(pixel & 0xFF, opacity);
+    }
+    
+    // Наложение одного канала: s + d * (255 - a) / 255
+    inline uint32_t overChannel(uint32_t s, uint32_t d, uint32_t ia) {
+        uint32_t v = s + mul255(d, ia);
+        return v > 255 ? 255 : v;
+    }
+    
+    // Наложение одного предумноженного пикселя (используется в drawPixel)
+    inline uint32_t blendPixel(uint32_t dst, uint32_t src) {
+        uint32_t ia = 255 - (src & 0xFF);
+        return (overChannel(src >> 24, dst >> 24, ia) << 24) |
+               (overChannel((src >> 16) & 0xFF, (dst >> 16) & 0xFF, ia) << 16) |
+               (overChannel((src >> 8) & 0xFF, (dst >> 8) & 0xFF, ia) << 8) |
+                overChannel(src & 0xFF, dst & 0xFF, ia);
+    }
+    
+    // Интерполяция a -> b с весом t / 256 (t = 0..255), два канала за одно умножение.
+    // Все каналы смешиваются с одним весом и одним округлением, поэтому
+    // предумноженный результат остается корректным (канал не больше альфы).
+    inline uint32_t lerpPixel(uint32_t a, uint32_t b, uint32_t t) {
+        uint32_t rb = (((a & 0x00FF00FF) * (256 - t) + (b & 0x00FF00FF) * t + 0x00800080) >> 8) & 0x00FF00FF;
+        uint32_t ag = (((a >> 8) & 0x00FF00FF) * (256 - t) + ((b >> 8) & 0x00FF00FF) * t + 0x00800080) & 0xFF00FF00;
+        return rb | ag;
+    }
+    
+    // Билинейная выборка четырех соседей: fx, fy - доли 0..255 по осям.
+    // Сначала по вертикали, затем по горизонтали - в том же порядке, что и векторные ядра.
+    inline uint32_t bilinearPixel(uint32_t p00, uint32_t p01, uint32_t p10, uint32_t p11,
+                                  uint32_t fx, uint32_t fy) {
+        return lerpPixel(lerpPixel(p00, p10, fy), lerpPixel(p01, p11, fy), fx);
+    }
+    
+    // Постоянный предумноженный цвет поверх отрезка из count пикселей
+    void blendColor(uint32_t* dst, int count, uint32_t color);
+    
+    // Попиксельный предумноженный источник поверх отрезка
+    void blendPixels(uint32_t* dst, const uint32_t* src, int count);
+    
+    // То же с глобальной прозрачностью opacity (0..255), применяемой к источнику
+    void blendPixelsOpacity(uint32_t* dst, const uint32_t* src, int count, uint32_t opacity);
+    
+    // Постоянный предумноженный цвет с покрытием mask[i] (0..255) поверх отрезка (глифы)
+    void blendMask(uint32_t* dst, const uint8_t* mask, int count, uint32_t color);
+    
+    // Копирование строки готовых пикселей в память дисплея: только запись,
+    // без чтения приемника (на хосте - записи в обход кэша)
+    void copyPixels(uint32_t* dst, const uint32_t* src, int count);
+    
+    // Билинейная выборка count пикселей вдоль шага (du, dv): точка i - (u + i * du, v + i * dv)
+    // в 16.16 относительно центра пикселя src[0]. Вызывающий гарантирует, что все четыре
+    // соседа каждой точки лежат внутри источника с шагом строки stride.
+    void sampleBilinear(uint32_t* dst, const uint32_t* src, int stride,
+                        int32_t u, int32_t v, int32_t du, int32_t dv, int count);
+    
+    // Эталонная скалярная реализация, с которой сверяются векторные варианты
+    namespace Scalar {
+        void blendColor(uint32_t* dst, int count, uint32_t color);
+        void blendPixels(uint32_t* dst, const uint32_t* src, int count);
+        void blendPixelsOpacity(uint32_t* dst, const uint32_t* src, int count, uint32_t opacity);
+        void blendMask(uint32_t* dst, const uint8_t* mask, int count, uint32_t color);
+        void copyPixels(uint32_t* dst, const uint32_t* src, int count);
+        void sampleBilinear(uint32_t* dst, const uint32_t* src, int stride,
+                            int32_t u, int32_t v, int32_t du, int32_t dv, int count);
+    }
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Покрытие четверти круга радиуса r для сглаженных кругов и скругленных углов.
+// Центр круга лежит в углу пикселя; coverage(i, j) - точная доля площади
+// пикселя [i, i + 1] x [j, j + 1] внутри круга, 0..255, при 0 <= i, j < r.
+// Перед каждой строкой лежит она же задом наперед (левый угол), поэтому
+// строка круга диаметром 2r целиком - это 2r подряд идущих байт.
+struct CornerMask {
+    int radius;
+    std::vector<uint8_t> coverage;  // 2 * radius^2: по строкам j зеркальная строка, затем прямая
+    std::vector<uint16_t> solid;    // Число полностью закрытых пикселей строки от центра
+    std::vector<uint16_t> extent;   // Число пикселей строки с ненулевым покрытием
+    
+    // Круг диаметром 2r целиком - только у малых радиусов (частицы): строки
+    // сверху вниз подряд, от каждой лишь ненулевая часть [r - extent, r + extent)
+    static const int DISC_RADIUS = 4;
+    std::vector<uint8_t> disc;
+    std::vector<uint16_t> discRow;  // Начало строки j в disc, 2 * radius + 1 значений
+    
+    const uint8_t* row(int j) const { return coverage.data() + (2 * j + 1) * radius; }
+    const uint8_t* mirroredRow(int j) const { return coverage.data() + 2 * j * radius; }
+};
+
+// Маски по радиусам. Малые радиусы (частицы, искры, скругления кнопок) лежат
+// в прямой таблице: маска строится один раз, не вытесняется и читается без
+// блокировки. Остальные - в маленькой LRU-таблице под мьютексом (растеризация
+// тайлов идет из нескольких потоков), маска отдается через shared_ptr
+// и переживает вытеснение из таблицы.
+class CornerMaskCache {
+public:
+    static const int MAX_ENTRIES = 32;
+    static const int DIRECT_RADIUS = 32;
+    
+    static CornerMaskCache* getInstance();
+    
+    // Маска радиуса radius; для больших радиусов holder держит ее на время рисования
+    const CornerMask* get(int radius, std::shared_ptr<const CornerMask>& holder);
+
+private:
+    CornerMaskCache();
+    
+    const CornerMask* getDirect(int radius);
+    std::shared_ptr<const CornerMask> getShared(int radius);
+    static std::shared_ptr<const CornerMask> build(int radius);
+    
+    struct Entry {
+        std::shared_ptr<const CornerMask> mask;
+        unsigned lastUse;
+    };
+    
+    std::atomic<const CornerMask*> direct[DIRECT_RADIUS + 1];
+    std::shared_ptr<const CornerMask> directMasks[DIRECT_RADIUS + 1];
+    Entry entries[MAX_ENTRIES];
+    unsigned clock;
+    std::mutex mutex;
+};
+
+#define CORNER_MASKS CornerMaskCache::getInstance()
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+
+// Прямоугольник повреждения [x0, x1) x [y0, y1) в экранных координатах
+struct DirtyRect {
+    int x0, y0, x1, y1;
+    
+    int area() const { return (x1 - x0) * (y1 - y0); }
+    bool empty() const { return x0 >= x1 || y0 >= y1; }
+};
+
+// Поврежденная область кадра: небольшой список прямоугольников.
+// Пересекающиеся и соприкасающиеся прямоугольники сливаются сразу,
+// а при переполнении сливается пара с наименьшим приростом площади.
+class DirtyRegion {
+public:
+    static const int MAX_RECTS = 8;
+    
+    DirtyRegion(int width = 1280, int height = 720);
+    
+    void setBounds(int width, int height);
+    
+    void add(int x, int y, int w, int h);
+    void add(const DirtyRect& rect);
+    void add(const DirtyRegion& other);
+    void addAll();
+    void clear() { count = 0; }
+    
+    bool empty() const { return count == 0; }
+    int size() const { return count; }
+    const DirtyRect& operator[](int index) const { return rects[index]; }
+    
+    // Суммарная площадь (пиксели, которые придется перерисовать)
+    int area() const;
+
+private:
+    void mergeAt(int index);
+    
+    DirtyRect rects[MAX_RECTS + 1];
+    int count;
+    int width, height;
+};
@@ -0,0 +1,126 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "graphics.h"
+#include "rasterizer.h"
+#include "surface.h"
+#include "worker_pool.h"
+
+struct TextLayout;
+
+// Команда отложенного рендера. Параметры уже переведены в целые экранные
+// координаты, цвета - в предумноженный формат (кроме градиента).
+struct DrawCommand {
+    enum Type : uint8_t {
+        PIXEL,
+        LINE,                   // x1, y1, x2, y2 в 24.8, толщина в 1/256 пикселя
+        RECT,                   // x, y, w, h в 24.8
+        ROUNDED_RECT,           // x, y в 24.8, w, h, радиус
+        CIRCLE,                 // cx, cy в 24.8, радиус
+        GRADIENT,
+        RADIAL_GRADIENT,        // cx, cy, radius
+        POLYGON,                // число вершин, смещение вершин (24.8) в пуле, сглаживание
+        IMAGE_SPAN,
+        BLIT,                   // x, y, индекс области поверхности, w, h
+        IMAGE_AFFINE,           // индекс изображения с отображением, билинейная выборка
+        TEXT,                   // x, y, индекс раскладки
+        TEXT_FIELD,             // смещение и число глифов поля, смещение таблицы цветов в пуле, сторона текселя в 16.16
+        CIRCLES                 // смещение пакета кругов в пуле, число кругов
+    };
+    
+    Type type;
+    bool vertical;              // Направление градиента
+    bool dither;                // Сглаживание градиента
+    int16_t x0, y0, x1, y1;     // Ограничивающий прямоугольник [x0, x1) x [y0, y1)
+    int32_t p[5];               // Параметры примитива
+    uint32_t color;             // Предумноженный цвет / прозрачность для IMAGE_SPAN и BLIT
+    Color startColor, endColor; // Цвета градиента
+};
+
+// Список команд кадра с разбиением на тайлы 64x64.
+// Каждый тайл растеризуется целиком в буфер, который помещается в L1,
+// и записывается в кадровый буфер один раз. Тайлы не пересекаются, а команды
+// внутри тайла выполняются в порядке записи, поэтому результат не зависит
+// от числа потоков.
+class DisplayList {
+public:
+    static const int TILE_SIZE = 64;
+    
+    DisplayList();
+    
+    // Начало нового кадра для экрана заданного размера
+    void reset(int width, int height);
+    
+    // Добавление команды с ограничивающим прямоугольником [x0, x1) x [y0, y1);
+    // прямоугольник обрезается по экрану, команды вне экрана отбрасываются
+    void add(const DrawCommand& cmd, int x0, int y0, int x1, int y1);
+    
+    // Копирование пикселей для IMAGE_SPAN (и вершин POLYGON); возвращает смещение в пуле
+    int32_t storePixels(const uint32_t* pixels, int count);
+    
+    // Ссылка на область поверхности для BLIT; возвращает ее индекс.
+    // Поверхность не копируется: она должна жить и не меняться до render().
+    int32_t storeSurface(const Surface* surface, int sx, int sy, int sw, int sh);
+    
+    // Ссылка на изображение и его отображение для IMAGE_AFFINE; возвращает индекс.
+    // Пиксели, как и у BLIT, не копируются.
+    int32_t storeImage(const uint32_t* pixels, int stride, int width, int height, const Raster::AffineMap& map);
+    
+    // Ссылка на раскладку для TEXT; возвращает ее индекс.
+    // Раскладки живут в кэше GraphicsManager до начала следующего кадра.
+    int32_t storeLayout(const TextLayout* layout);
+    
+    // Копирование глифов поля расстояний для TEXT_FIELD; возвращает смещение.
+    // Поля глифов живут в FontCache и не копируются.
+    int32_t storeFieldGlyphs(const Raster::FieldGlyph* glyphs, int count);
+    
+    // Копирование пакета кругов для CIRCLES (центры в 24.8, радиусы, предумноженные
+    // цвета) вместе со списками кругов каждого тайла; возвращает смещение в пуле.
+    // Тайл рисует только свои круги, в порядке пакета.
+    int32_t storeCircles(const Raster::Fixed* cx, const Raster::Fixed* cy, const int32_t* radius,
+                         const uint32_t* pixels, int count);
+    
+    // Растеризация всех команд в буфер и очистка списка.
+    // С пулом потоков тайлы распределяются между ядрами. Тайлы всегда рисуются
+    // в RGBA8, а при загрузке и записи переводятся в формат буфера F.
+    template<class F>
+    void render(const Raster::BasicTarget<F>& target, WorkerPool* workers = nullptr);
+    
+    size_t size() const { return commands.size(); }
+    bool empty() const { return commands.empty(); }
+    
+    // Выполнение одной команды в произвольную цель (CIRCLES - только в тайл или его часть)
+    void execute(const Raster::Target& target, const DrawCommand& cmd) const;
+
+private:
+    // Область поверхности, которая повторяется по прямоугольнику команды BLIT
+    struct SurfaceRef {
+        const Surface* surface;
+        int sx, sy, sw, sh;
+    };
+    
+    struct ImageRef {
+        const uint32_t* pixels;
+        int stride, width, height;
+        Raster::AffineMap map;
+    };
+    
+    void bin();
+    template<class F>
+    void renderTile(int tx, int ty, const Raster::BasicTarget<F>& target, uint32_t* tileBuffer);
+    bool coversTile(const DrawCommand& cmd, int x0, int y0, int x1, int y1) const;
+    
+    std::vector<DrawCommand> commands;
+    std::vector<uint32_t> pixelPool;
+    std::vector<SurfaceRef> surfaces;
+    std::vector<ImageRef> images;
+    std::vector<const TextLayout*> layouts;
+    std::vector<Raster::FieldGlyph> fieldGlyphs;
+    std::vector<std::vector<uint32_t>> bins;
+    std::vector<uint32_t> tileCursor;   // Заполнение списков тайлов в storeCircles
+    int width, height;
+    int tilesX, tilesY;
+    
+    // Свой тайловый буфер у каждого потока
+    alignas(64) uint32_t tileBuffers[WorkerPool::MAX_WORKERS][TILE_SIZE * TILE_SIZE];
+};
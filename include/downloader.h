@@ -1,7 +1,7 @@
 #pragma once
 
 #include "neovia.h"
-#include <switch.h>
+#include "platform.h"
 #include <string>
 
 // Функции загрузки
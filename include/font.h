@@ -0,0 +1,146 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "rasterizer.h"
+
+// Глиф начертания: прямоугольник 8-битного покрытия в атласе и метрики в пикселях
+struct Glyph {
+    int32_t offset;         // Начало покрытия в атласе, строки по width байт
+    uint8_t width, height;
+    uint8_t top;            // Верх прямоугольника от верха строки
+    uint8_t advance;        // Сдвиг пера (без кернинга); прямоугольник начинается у пера
+};
+
+// Номера глифов по коду символа основной плоскости: двухуровневая таблица.
+// Старший байт кода выбирает страницу в каталоге, младший - место на ней.
+// Пустые места и отсутствующие страницы указывают на глиф замены, поэтому
+// поиск - два чтения без ветвлений. Таблица строится при компиляции.
+struct GlyphMap {
+    static const int PAGE_BITS = 8;
+    static const int PAGE_SIZE = 1 << PAGE_BITS;
+    static const int MAX_PAGES = 8;             // Пустая страница и страницы с глифами
+    static const uint32_t MAX_CODE = 0xFFFF;
+    
+    uint8_t directory[(MAX_CODE + 1) >> PAGE_BITS];
+    uint16_t pages[MAX_PAGES][PAGE_SIZE];
+    
+    uint16_t find(uint32_t c) const {
+        return c <= MAX_CODE ? pages[directory[c >> PAGE_BITS]][c & (PAGE_SIZE - 1)] : pages[0][0];
+    }
+};
+
+// Растровый шрифт одного размера. Глифы растеризуются один раз при создании
+// в общий атлас покрытия; строка рисуется заливкой через маски глифов
+// и ничего не выделяет.
+class FontFace {
+public:
+    // Латиница ASCII, кириллица с украинскими буквами, кавычки-елочки и многоточие
+    static const int GLYPH_COUNT = 172;
+    
+    explicit FontFace(int size);
+    
+    int getSize() const { return size; }
+    // Базовая линия от верха строки; высота строки равна размеру
+    int getAscent() const { return ascent; }
+    
+    // Глиф по коду символа; отсутствующие символы рисуются как '?'
+    const Glyph& glyph(uint32_t c) const { return glyphs[charMap.find(c)]; }
+    // Номер глифа для раскладок, которые хранят глифы, а не коды
+    static uint16_t glyphIndex(uint32_t c) { return charMap.find(c); }
+    const Glyph& glyphAt(int index) const { return glyphs[index]; }
+    const uint8_t* coverage(const Glyph& g) const { return atlas.data() + g.offset; }
+    size_t atlasBytes() const { return atlas.size(); }
+    
+    // Ширина строки UTF-8 - сумма сдвигов пера по символам, а не по байтам
+    int measure(const char* text, size_t length) const;
+    int measure(const std::string& text) const { return measure(text.data(), text.size()); }
+    
+    // Строка UTF-8 с верхом в y и пером в x; pixel - предумноженный цвет
+    template<class F>
+    void draw(const Raster::BasicTarget<F>& target, const char* text, size_t length,
+              int x, int y, uint32_t pixel) const;
+
+private:
+    void rasterize(int index, const uint8_t* rows);
+    
+    static const GlyphMap charMap;
+    
+    int size;
+    int ascent;
+    Glyph glyphs[GLYPH_COUNT];
+    std::vector<uint8_t> atlas;
+};
+
+// Глиф поля расстояний: тексели по TEXELS_PER_CELL на клетку мастер-глифа
+// с полями SPREAD текселей вокруг закрашенной части
+struct DistanceGlyph {
+    int32_t offset;         // Начало поля в атласе, строки по width байт
+    uint8_t width, height;
+    int8_t left;            // Левый край поля от пера, тексели
+    int8_t top;             // Верх поля от верха клетки мастера, тексели
+    uint8_t advance;        // Сдвиг пера в клетках мастера
+};
+
+// Поле расстояний для всех глифов, одно на все размеры: строка любого
+// размера выбирается из него билинейно, без новой растеризации. Номера
+// глифов и сдвиги пера совпадают с FontFace, так что надпись с эффектами
+// ложится на то же место, что и обычная.
+class DistanceFont {
+public:
+    static const int TEXELS_PER_CELL = 4;
+    static const int SPREAD = 16;       // Наибольшее расстояние снаружи, тексели
+    static const int DEPTH = 4;         // Наибольшая глубина внутри, тексели
+    
+    DistanceFont();
+    
+    const DistanceGlyph& glyph(uint32_t c) const { return glyphs[FontFace::glyphIndex(c)]; }
+    size_t atlasBytes() const { return atlas.size(); }
+    
+    // Расстояние до контура в текселях (отрицательное внутри) по значению поля 0..255
+    static float decode(float value) { return SPREAD - value * (SPREAD + DEPTH) / 255.0f; }
+    
+    // Размещение строки UTF-8 размера size с пером в x и верхом строки в y:
+    // глифы добавляются в out, texelSize - сторона текселя в пикселях (16.16).
+    // Возвращает ширину строки.
+    int place(const char* text, size_t length, float size, int x, int y,
+              std::vector<Raster::FieldGlyph>& out, int32_t& texelSize) const;
+
+private:
+    void build(int index, const uint8_t* rows);
+    
+    DistanceGlyph glyphs[FontFace::GLYPH_COUNT];
+    std::vector<uint8_t> atlas;
+};
+
+// Начертания по размерам в таблице с прямым доступом.
+// Размеры интерфейса строятся заранее, остальные - при первом обращении;
+// начертания не вытесняются, поэтому отложенный список команд может
+// ссылаться на них до конца кадра.
+class FontCache {
+public:
+    static const int MIN_SIZE = 6;
+    static const int MAX_SIZE = 96;
+    
+    static FontCache* getInstance();
+    
+    // Начертание размера size (приводится к [MIN_SIZE, MAX_SIZE]), строится при необходимости
+    const FontFace* get(int size);
+    
+    // Только уже построенное начертание: для потоков рендера, которые ничего не строят
+    const FontFace* find(int size) const { return faces[clampSize(size)].get(); }
+    
+    // Поле расстояний строится при первом обращении
+    const DistanceFont* distanceField();
+    
+    static int clampSize(int size) { return size < MIN_SIZE ? MIN_SIZE : size > MAX_SIZE ? MAX_SIZE : size; }
+
+private:
+    FontCache();
+    
+    std::unique_ptr<FontFace> faces[MAX_SIZE + 1];
+    std::unique_ptr<DistanceFont> field;
+};
+
+#define FONTS FontCache::getInstance()
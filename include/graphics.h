@@ -1,10 +1,13 @@
 #pragma once
-#include <switch.h>
+#include "platform.h"
 #include <vector>
 #include <string>
 #include <memory>
 #include <functional>
 #include <cmath>
+#include "blend.h"
+#include "rasterizer.h"
+#include "dirty_region.h"
 
 // Цветовая схема NEOVIA
 struct Color {
@@ -16,6 +19,11 @@ struct Color {
     uint32_t toRGBA() const {
         return (r << 24) | (g << 16) | (b << 8) | a;
     }
+    
+    // Пиксель с предумноженной альфой - формат всех буферов рендера
+    uint32_t toPremultiplied() const {
+        return Blend::premultiply(toRGBA());
+    }
 };
 
 // Цветовая палитра
@@ -91,6 +99,9 @@ public:
     virtual void render(float deltaTime) = 0;
     virtual void update(float deltaTime) {}
     virtual bool handleInput(u64 kDown, float touchX = -1, float touchY = -1) { return false; }
+    // Непрозрачные прямоугольники элемента (в координатах экрана) для отбрасывания
+    // того, что нарисовано под ним раньше
+    virtual void collectOccluders(std::vector<DirtyRect>& out) const {}
     
     bool isPointInside(float px, float py) const {
         return px >= x && px <= x + width && py >= y && py <= y + height;
@@ -126,6 +137,8 @@ public:
     void render(float deltaTime) override;
     void update(float deltaTime) override;
     bool handleInput(u64 kDown, float touchX = -1, float touchY = -1) override;
+    void collectOccluders(std::vector<DirtyRect>& out) const override;
+    // Позиция child - относительно левого верхнего угла панели
     void addChild(std::unique_ptr<UIElement> child);
 };
 
@@ -156,6 +169,43 @@ public:
     void setProgress(float value, bool animate = true);
 };
 
+// Отрезок для пакетного рисования линий
+struct LineSegment {
+    float x1, y1, x2, y2;
+    Color color;
+};
+
+// Оформление надписи по полю расстояний. Слой с прозрачным цветом
+// не рисуется; ширина обводки и радиус свечения - в пикселях экрана.
+struct TextStyle {
+    Color fill;
+    Color outline;
+    Color glow;
+    float outlineWidth;
+    float glowRadius;       // От внешнего края обводки
+};
+
+// Счетчики последнего кадра. Закраска считается по прямоугольникам примитивов,
+// поэтому у кругов и линий в нее входят и углы их рамки.
+struct FrameStats {
+    int drawn;                  // Нарисовано примитивов
+    int culled;                 // Отброшено целиком под перекрытием
+    int trimmed;                // Укорочено перекрытием
+    int64_t paintedPixels;      // Сумма площадей закрасок
+    int64_t overdrawPixels;     // Закрасок сверх первой на пиксель (при setOverdrawTracking)
+    int textLayoutHits;         // Надписи, взятые из кэша раскладок
+    int textLayoutMisses;       // Надписи, разложенные заново
+    int64_t textLayoutBytes;    // Память кэша раскладок в конце кадра
+};
+
+struct DrawCommand;
+class DisplayList;
+class WorkerPool;
+class Surface;
+class ShadowCache;
+class TextLayoutCache;
+struct NinePatch;
+
 // Менеджер графики
 class GraphicsManager {
 private:
@@ -164,6 +214,106 @@ private:
     uint32_t width, height;
     float lastFrameTime;
     
+    // Текущая цель растеризации: задний буфер кадра или поверхность
+    Raster::Target target;
+    Surface* renderTarget;
+    
+    // Кадр собирается в кэшируемом заднем буфере и в endFrame копируется
+    // в память дисплея; фон кадра берется из готовой поверхности
+    Surface* backBuffer;
+    Surface* background;
+    bool backBuffered;
+    bool backgroundDithered;
+    DirtyRegion presentedDamage;    // Что было скопировано в прошлом кадре
+    
+    // Стек отсечения: каждый элемент - уже пересечение со всеми внешними
+    std::vector<DirtyRect> clipStack;
+    
+    // Непрозрачные прямоугольники, которые будут нарисованы поверх
+    // всего, что рисуется между beginOcclusion и endOcclusion
+    std::vector<DirtyRect> occluders;
+    
+    // Статистика текущего и прошлого кадра; отметки закрашенных
+    // пикселей - только при подсчете перерисовки
+    FrameStats stats;
+    FrameStats frameStats;
+    std::vector<uint8_t> paintedMask;
+    
+    // Экономичный режим: задний буфер и фон в RGB565, вдвое меньше трафика памяти.
+    // Кадр переводится в RGBA8 при копировании в дисплей.
+    bool lowPower;
+    uint16_t* lowBuffer;
+    uint16_t* lowBackground;
+    Raster::BasicTarget<PixelFormat::RGB565> lowTarget;
+    
+    // Отложенный режим: примитивы записываются в список команд
+    // и растеризуются по тайлам в endFrame
+    DisplayList* displayList;
+    bool deferred;
+    bool recording;
+    bool recordingSuspended;    // Запись кадра прервана рисованием в поверхность
+    
+    // Упорядоченное сглаживание градиентов
+    bool dithering;
+    
+    // Координаты всех примитивов и изображений в 24.8 (иначе - до целых пикселей)
+    bool subpixel;
+    
+    // Потоки для растеризации тайлов
+    WorkerPool* workers;
+    
+    // Готовые размытые тени и свечения
+    ShadowCache* shadows;
+    
+    // Раскладки надписей по строке и размеру шрифта
+    TextLayoutCache* layouts;
+    
+    // Глифы поля расстояний для drawStyledText; память переиспользуется
+    std::vector<Raster::FieldGlyph> fieldGlyphs;
+    
+    void resetTarget();
+    void buildBackground();
+    void present(const DirtyRegion* damage);
+    void releaseLowPower();
+    
+    // Вызов растеризатора для текущей цели: формат буфера выбирается
+    // один раз на примитив, а не на пиксель
+    template<class Fn>
+    void rasterize(const Fn& fn) {
+        if (lowPower && !renderTarget) {
+            fn(lowTarget);
+        } else {
+            fn(target);
+        }
+    }
+    // То же, но примитив рисуется только внутри box (после перекрытия)
+    template<class Fn>
+    void rasterize(const DirtyRect& box, const Fn& fn) {
+        if (lowPower && !renderTarget) {
+            fn(lowTarget.clip(box.x0, box.y0, box.x1, box.y1));
+        } else {
+            fn(target.clip(box.x0, box.y0, box.x1, box.y1));
+        }
+    }
+    bool visibleArea(DirtyRect& box, DirtyRect& visible) const;
+    bool visibleBounds(DirtyRect& box, bool trim = true);
+    bool shapeVisible(int x, int y, int w, int h, int pad);
+    void countPaint(const DirtyRect& box);
+    void drawNinePatch(const NinePatch& patch, int x, int y, int w, int h);
+    void drawLineSegment(Raster::Fixed x1, Raster::Fixed y1, Raster::Fixed x2, Raster::Fixed y2,
+                         uint32_t pixel, int width);
+    // Координата в 24.8; без субпиксельной точности - целый пиксель:
+    // round округляет (круги, линии), иначе дробная часть отбрасывается
+    Raster::Fixed fixedCoordinate(float v, bool round) const;
+    // Координата центра круга радиуса radius: мелкие круги - в ближайший угол пикселя
+    Raster::Fixed circleCoordinate(float v, int radius) const;
+    void record(const DrawCommand& cmd, const DirtyRect& box);
+    
+    // Промежуточные массивы пакетов, переиспользуются между кадрами
+    std::vector<int32_t> batchX, batchY, batchRadius;
+    std::vector<uint32_t> batchPixels;
+    Raster::BatchScratch batchScratch;
+
 public:
     static GraphicsManager* getInstance();
     
@@ -171,20 +321,114 @@ public:
     void cleanup();
     
     void beginFrame();
-    void endFrame();
+    // damage - измененная за кадр область; без нее в дисплей копируется весь кадр
+    void endFrame(const DirtyRegion* damage = nullptr);
     float getDeltaTime() const { return lastFrameTime; }
     
+    // Отложенный рендер с разбиением на тайлы
+    void setDeferred(bool enabled);
+    bool isDeferred() const { return deferred; }
+    void flush();
+    
+    // Рисование через задний буфер (по умолчанию) или прямо в память дисплея
+    void setBackBuffer(bool enabled);
+    bool isBackBuffered() const { return backBuffered; }
+    
+    // 16-битный задний буфер (RGB565): для непрозрачного кадра без потери
+    // альфы, ценой точности цвета; поверхности остаются в RGBA8
+    void setLowPowerMode(bool enabled);
+    bool isLowPowerMode() const { return lowPower; }
+    
+    // Число потоков рендера (1 - однопоточный режим, максимум 3)
+    void setRenderThreads(int count);
+    int getRenderThreads() const;
+    
+    // Рисование в поверхность (nullptr - обратно в кадровый буфер).
+    // В поверхность примитивы всегда рисуются сразу, без списка команд.
+    void setTarget(Surface* surface);
+    Surface* getTarget() const { return renderTarget; }
+    
+    // Отсечение: все примитивы до popClip обрезаются по прямоугольнику
+    // (вложенные прямоугольники пересекаются). Стек сбрасывается в beginFrame.
+    void pushClip(int x, int y, int w, int h);
+    void popClip();
+    // Прямоугольник целиком вне текущего отсечения - его можно не рисовать
+    bool isClipped(float x, float y, float w, float h) const;
+    
+    // Перекрытие: rects будут нарисованы позже непрозрачными, и примитивы
+    // кадра под ними до endOcclusion не рисуются (или укорачиваются).
+    // Сбрасывается в beginFrame.
+    void beginOcclusion(const std::vector<DirtyRect>& rects);
+    void endOcclusion();
+    
+    // Счетчики прошлого кадра; подсчет перерисовки отмечает каждый
+    // закрашенный пиксель, поэтому включается отдельно
+    const FrameStats& getFrameStats() const { return frameStats; }
+    void setOverdrawTracking(bool enabled);
+    bool isOverdrawTracking() const { return !paintedMask.empty(); }
+    
+    // Вывод поверхности в текущую цель
+    void drawSurface(const Surface& surface, int x, int y, float opacity = 1.0f);
+    
+    // Область (sx, sy, sw, sh) поверхности, повторенная по прямоугольнику (x, y, w, h)
+    void drawSurfaceRegion(const Surface& surface, int sx, int sy, int sw, int sh,
+                           int x, int y, int w, int h, float opacity = 1.0f);
+    
+    // Изображение width x height из предумноженных пикселей с шагом строки stride:
+    // до поворота левый верхний угол в (x, y), масштаб по осям, поворот (радианы)
+    // вокруг центра. Рисуется одним проходом по пикселям приемника с ближайшей
+    // или билинейной выборкой. В отложенном режиме пиксели не копируются
+    // и должны жить до конца кадра.
+    void drawImage(const uint32_t* pixels, int stride, int width, int height, float x, float y,
+                   float scaleX = 1.0f, float scaleY = 1.0f, float rotation = 0.0f,
+                   float opacity = 1.0f, bool bilinear = true);
+    
     // Базовые примитивы
     void drawPixel(int x, int y, const Color& color);
-    void drawLine(int x1, int y1, int x2, int y2, const Color& color, float thickness = 1.0f);
+    void drawPremultipliedPixel(int x, int y, uint32_t pixel);
+    void drawPremultipliedSpan(int x, int y, const uint32_t* pixels, int count, float opacity = 1.0f);
+    // Линия толщиной до 1 пикселя сглаживается, толще - заливается прямоугольником.
+    // Целые координаты концов - центры пикселей.
+    void drawLine(float x1, float y1, float x2, float y2, const Color& color, float thickness = 1.0f);
+    void drawLines(const LineSegment* segments, int count, float thickness = 1.0f);
     void drawRect(float x, float y, float width, float height, const Color& color);
     void drawRoundedRect(float x, float y, float width, float height, float radius, const Color& color);
     void drawCircle(float x, float y, float radius, const Color& color);
+    
+    // Пакеты для частиц и облаков точек: координаты отдельными массивами,
+    // цвета в формате Color::toRGBA. Круги размещаются так же, как в drawCircle.
+    void drawCircles(const float* xs, const float* ys, const float* radii, const uint32_t* rgba, int count);
+    void drawPoints(const float* xs, const float* ys, const uint32_t* rgba, int count);
+    
+    // Выпуклые многоугольники: заливка по строкам, сглаживание по покрытию краев
+    void drawTriangle(float x1, float y1, float x2, float y2, float x3, float y3,
+                      const Color& color, bool antialias = true);
+    void drawPolygon(const float* xs, const float* ys, int count, const Color& color, bool antialias = true);
+    
+    // Субпиксельная точность (по умолчанию включена): прямоугольники, круги, линии
+    // и многоугольники идут в растеризатор в координатах 24.8 и сдвигаются на доли
+    // пикселя через покрытие краев, drawImage ставит изображение с дробным сдвигом.
+    // Круги радиусом до Raster::SNAP_RADIUS всегда ставятся в угол пикселя.
+    // Без нее координаты привязываются к целым пикселям.
+    void setSubpixelPrecision(bool enabled) { subpixel = enabled; }
+    bool isSubpixelPrecision() const { return subpixel; }
+    
     void drawGradient(float x, float y, float width, float height, const Color& startColor, const Color& endColor, bool vertical = true);
+    void drawRadialGradient(float x, float y, float radius, const Color& innerColor, const Color& outerColor);
+    
+    // Сглаживание градиентов матрицей Байера (по умолчанию включено)
+    void setDithering(bool enabled) { dithering = enabled; }
+    bool isDithering() const { return dithering; }
     
     // Текст
     void drawText(const std::string& text, float x, float y, const Color& color, int fontSize = 16);
     void drawTextCentered(const std::string& text, float x, float y, float width, const Color& color, int fontSize = 16);
+    void getTextSize(const std::string& text, int fontSize, int& width, int& height);
+    // Строка по полю расстояний: заливка, обводка и свечение за один проход
+    // по пикселям, размер любой и без растеризации начертания. Сдвиги пера
+    // те же, что у drawText. Свечение и обводка вместе ограничены полем
+    // (DistanceFont::SPREAD текселей).
+    void drawStyledText(const std::string& text, float x, float y, float fontSize, const TextStyle& style);
     
     // Эффекты
     void drawShadow(float x, float y, float width, float height, float radius = 8, float opacity = 0.3f);
@@ -0,0 +1,70 @@
+#pragma once
+#include "platform.h"
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+
+// Платформа без дисплея: кадр рисуется в память хоста, время берется
+// из steady_clock (или идет фиксированным шагом), ввод - из сценария.
+// Два буфера чередуются, как у libnx, чтобы частичная перерисовка
+// вела себя так же, как на консоли.
+class HeadlessPlatform : public Platform {
+public:
+    HeadlessPlatform();
+    
+    bool initialize(uint32_t width, uint32_t height) override;
+    void shutdown() override;
+    
+    uint32_t* getFramebuffer(uint32_t* width, uint32_t* height) override;
+    void present() override;
+    // Кадр без смены буферов (интерфейсу нечего перерисовывать): время,
+    // сценарий ввода и счетчик кадров идут так же, как после present
+    void waitForVsync() override;
+    
+    uint64_t getTicks() override;
+    uint64_t getTickFrequency() override { return 1000000000ull; }
+    
+    bool mainLoop() override;
+    u64 pollButtonsDown() override;
+    // SD-карты нет: папки не создаются
+    Result createDirectory(const std::string& path) override;
+    
+    // Число кадров до завершения (0 - без ограничения)
+    void setFrameLimit(int frames) { frameLimit = frames; }
+    // Фиксированный шаг времени на кадр: анимации воспроизводимы
+    // от запуска к запуску (0 - реальное время)
+    void setFixedTimestep(double seconds) { timestep = seconds; }
+    
+    // Сценарий ввода: кнопки, нажатые в кадре frame
+    void pressAt(int frame, u64 buttons);
+    // Сценарий из файла: строки "кадр кнопка[+кнопка...]", # - комментарий
+    bool loadInputScript(const std::string& path);
+    
+    // Сохранение каждого every-го показанного кадра в prefix00042.ppm
+    // (или .png, если extension = ".png")
+    void setFrameDump(const std::string& prefix, int every, const std::string& extension = ".ppm");
+    // Последний показанный кадр; формат по расширению пути (.png или .ppm)
+    bool dumpFrame(const std::string& path) const;
+    // Последний показанный кадр в памяти (после present он в другом буфере)
+    const uint32_t* getPresentedFrame() const { return buffers[current ^ 1].get(); }
+    
+    int getFrameCount() const { return frame; }
+
+private:
+    uint32_t width, height;
+    std::unique_ptr<uint32_t[]> buffers[2];
+    int current;
+    int frame;
+    int frameLimit;
+    double timestep;
+    std::chrono::steady_clock::time_point start;
+    std::map<int, u64> script;
+    
+    std::string dumpPrefix;
+    std::string dumpExtension;
+    int dumpEvery;
+    
+    // Сохранение кадра по настройкам dump и переход к следующему
+    void finishFrame();
+};
@@ -1,8 +1,9 @@
 #pragma once
-#include <switch.h>
+#include "platform.h"
 #include <string>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 #include "graphics.h"
 
 // Simple JPEG decoder for Nintendo Switch
@@ -21,7 +22,7 @@ private:
     
     JPEGInfo parseJPEGHeader(const uint8_t* data, size_t size);
     std::unique_ptr<uint32_t[]> decodeJPEG(const uint8_t* data, size_t size, int& width, int& height);
-    
+
 public:
     static IconLoader* getInstance();
     
@@ -31,7 +32,7 @@ public:
     // Load icon from memory
     bool loadIconFromMemory(const uint8_t* data, size_t size, const std::string& name);
     
-    // Get icon data
+    // Get icon data (pixels are stored with premultiplied alpha)
     uint32_t* getIcon(const std::string& name, int& width, int& height);
     
     // Check if icon exists
@@ -45,6 +45,13 @@ private:
     };
     std::vector<Particle> particles;
     
+    // Буферы пакетной отрисовки частиц (структура массивов)
+    std::vector<float> particleX, particleY, particleSize;
+    std::vector<uint32_t> particleColors;
+    
+    // Непрозрачные области текущего экрана, переиспользуются между кадрами
+    std::vector<DirtyRect> occluders;
+
 public:
     ModernGUI();
     ~ModernGUI();
@@ -55,7 +62,7 @@ public:
     bool handleInput(u64 kDown);
     
     void switchScreen(Screen newScreen);
-    
+
 private:
     void createMainMenu();
     void createSettingsMenu();
@@ -63,6 +70,7 @@ private:
     void createEnhancementMenu();
     void createLoadingMenu();
     
+    Panel* getScreenPanel() const;
     void renderBackground(float deltaTime);
     void renderParticles(float deltaTime);
     void updateParticles(float deltaTime);
@@ -87,4 +95,7 @@ private:
     void drawNeoviaBranding(float x, float y, float scale = 1.0f);
     void drawAnimatedLogo(float x, float y, float time);
     void drawStatusIndicator(float x, float y, bool active);
-};
\ No newline at end of file
+};
+
+// Глобальный GUI
+extern ModernGUI g_modernGui;
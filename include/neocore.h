@@ -1,5 +1,6 @@
 #pragma once
-#include <switch.h>
+#include "platform.h"
+#include "neovia.h"
 #include <string>
 #include <vector>
 
@@ -61,7 +62,7 @@ struct NeoCoreConfig {
     std::string quality_preset; // ultra, high, medium, low
 };
 
-// GameInfo уже определена в neovia.h, используем её
+// GameInfo определена в neovia.h
 
 // Класс управления NeoCore
 class NeoCoreManager {
@@ -1,6 +1,6 @@
 #pragma once
 
-#include <switch.h>
+#include "platform.h"
 #include <string>
 #include <vector>
 
@@ -38,6 +38,8 @@ struct GameInfo {
     bool hasIcon;
     u8* iconData;
     size_t iconSize;
+    bool hasCustomProfile;                  // Профиль NeoCore для игры
+    std::vector<std::string> activeMods;    // Модули NeoCore, включенные для игры
 };
 
 // Структура информации о моде
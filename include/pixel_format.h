@@ -0,0 +1,158 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include "blend.h"
+
+// Форматы пикселей буферов рендера.
+//
+// Примитивы всегда получают цвет в предумноженном RGBA8 (формат Color::toRGBA),
+// а политика формата знает, как упаковать его в пиксель буфера и наложить
+// на уже лежащий там пиксель. Формат - параметр шаблона растеризатора,
+// поэтому во внутренних циклах нет ни одного ветвления по формату.
+namespace PixelFormat {
+
+    // Матрица Байера 4x4 для упорядоченного сглаживания, привязанная к экранным координатам
+    inline uint32_t bayer(int x, int y) {
+        static const uint8_t BAYER[4][4] = {
+            {  0,  8,  2, 10 },
+            { 12,  4, 14,  6 },
+            {  3, 11,  1,  9 },
+            { 15,  7, 13,  5 }
+        };
+        return BAYER[y & 3][x & 3];
+    }
+    
+    // Операции над отрезками через pack/unpack: наложение всегда идет в RGBA8
+    // кусками по CHUNK пикселей векторными ядрами Blend, результат упаковывается
+    // обратно. Форматы переопределяют то, что умеют быстрее.
+    template<class F, class P>
+    struct Spans {
+        typedef P Pixel;
+        static const int CHUNK = 64;
+        
+        static void plot(Pixel* dst, uint32_t color) {
+            *dst = (color & 0xFF) == 255 ? F::pack(color) : F::pack(Blend::blendPixel(F::unpack(*dst), color));
+        }
+        
+        static void fill(Pixel* dst, int count, uint32_t color) {
+            if ((color & 0xFF) == 255) {
+                std::fill(dst, dst + count, F::pack(color));
+                return;
+            }
+            uint32_t buffer[CHUNK];
+            for (int i = 0; i < count; i += CHUNK) {
+                int n = std::min(CHUNK, count - i);
+                F::load(buffer, dst + i, n);
+                Blend::blendColor(buffer, n, color);
+                F::copy(dst + i, buffer, n);
+            }
+        }
+        
+        // Замена пикселей готовыми (непрозрачный источник)
+        static void copy(Pixel* dst, const uint32_t* src, int count) {
+            for (int i = 0; i < count; i++) {
+                dst[i] = F::pack(src[i]);
+            }
+        }
+        
+        // Предумноженный источник поверх отрезка с общей прозрачностью opacity (0..255)
+        static void blend(Pixel* dst, const uint32_t* src, int count, uint32_t opacity) {
+            uint32_t buffer[CHUNK];
+            for (int i = 0; i < count; i += CHUNK) {
+                int n = std::min(CHUNK, count - i);
+                F::load(buffer, dst + i, n);
+                Blend::blendPixelsOpacity(buffer, src + i, n, opacity);
+                F::copy(dst + i, buffer, n);
+            }
+        }
+        
+        // Постоянный цвет с покрытием coverage (0..255) на пиксель
+        static void mask(Pixel* dst, const uint8_t* coverage, int count, uint32_t color) {
+            uint32_t buffer[CHUNK];
+            for (int i = 0; i < count; i += CHUNK) {
+                int n = std::min(CHUNK, count - i);
+                F::load(buffer, dst + i, n);
+                Blend::blendMask(buffer, coverage + i, n, color);
+                F::copy(dst + i, buffer, n);
+            }
+        }
+        
+        // Распаковка отрезка буфера в RGBA8 (загрузка тайла, вывод на дисплей)
+        static void load(uint32_t* dst, const Pixel* src, int count) {
+            for (int i = 0; i < count; i++) {
+                dst[i] = F::unpack(src[i]);
+            }
+        }
+    };
+    
+    // Основной формат: r в старшем байте слова. Отрезки идут через векторные ядра Blend.
+    struct RGBA8888 : Spans<RGBA8888, uint32_t> {
+        static uint32_t pack(uint32_t rgba) { return rgba; }
+        static uint32_t unpack(uint32_t pixel) { return pixel; }
+        
+        static void plot(Pixel* dst, uint32_t color) {
+            *dst = (color & 0xFF) == 255 ? color : Blend::blendPixel(*dst, color);
+        }
+        
+        static void fill(Pixel* dst, int count, uint32_t color) {
+            if ((color & 0xFF) == 255) {
+                std::fill(dst, dst + count, color);
+            } else if (color & 0xFF) {
+                Blend::blendColor(dst, count, color);
+            }
+        }
+        
+        static void copy(Pixel* dst, const uint32_t* src, int count) {
+            memcpy(dst, src, count * sizeof(uint32_t));
+        }
+        
+        static void blend(Pixel* dst, const uint32_t* src, int count, uint32_t opacity) {
+            Blend::blendPixelsOpacity(dst, src, count, opacity);
+        }
+        
+        static void mask(Pixel* dst, const uint8_t* coverage, int count, uint32_t color) {
+            Blend::blendMask(dst, coverage, count, color);
+        }
+        
+        static void load(uint32_t* dst, const Pixel* src, int count) {
+            memcpy(dst, src, count * sizeof(uint32_t));
+        }
+    };
+    
+    // Байты в памяти b, g, r, a: на little-endian альфа оказывается в старшем байте слова
+    struct BGRA8888 : Spans<BGRA8888, uint32_t> {
+        static uint32_t pack(uint32_t rgba) { return (rgba << 24) | (rgba >> 8); }
+        static uint32_t unpack(uint32_t pixel) { return (pixel << 8) | (pixel >> 24); }
+    };
+    
+    // 16 бит без альфы - только для непрозрачных буферов (задний буфер
+    // в экономичном режиме). Каналы округляются до 5/6/5 бит.
+    struct RGB565 : Spans<RGB565, uint16_t> {
+        static uint16_t pack(uint32_t rgba) {
+            uint32_t r = rgba >> 24, g = (rgba >> 16) & 0xFF, b = (rgba >> 8) & 0xFF;
+            return (uint16_t)((((r * 249 + 1014) >> 11) << 11) |
+                              (((g * 253 + 505) >> 10) << 5) |
+                               ((b * 249 + 1014) >> 11));
+        }
+        
+        static uint32_t unpack(uint16_t pixel) {
+            uint32_t r = pixel >> 11, g = (pixel >> 5) & 0x3F, b = pixel & 0x1F;
+            return (((r << 3) | (r >> 2)) << 24) | (((g << 2) | (g >> 4)) << 16) |
+                   (((b << 3) | (b >> 2)) << 8) | 0xFF;
+        }
+        
+        // Упаковка со сглаживанием: вместо округления - порог из матрицы Байера,
+        // чтобы плавные градиенты фона не распадались на полосы
+        static uint16_t packDithered(uint32_t rgba, int x, int y) {
+            uint32_t t = bayer(x, y) * 16 + 8;
+            uint32_t r = rgba >> 24, g = (rgba >> 16) & 0xFF, b = (rgba >> 8) & 0xFF;
+            return (uint16_t)((((r * 31 * 256 / 255 + t) >> 8) << 11) |
+                              (((g * 63 * 256 / 255 + t) >> 8) << 5) |
+                               ((b * 31 * 256 / 255 + t) >> 8));
+        }
+    };
+}
+
+// Форматы, для которых инстанцируются шаблоны растеризатора
+#define PIXEL_FORMATS(X) X(PixelFormat::RGBA8888) X(PixelFormat::BGRA8888) X(PixelFormat::RGB565)
@@ -0,0 +1,88 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+#ifdef __SWITCH__
+#include <switch.h>
+#else
+// На хосте от libnx нужны только базовые типы и коды кнопок
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int32_t s32;
+typedef uint32_t Result;
+
+#define R_SUCCEEDED(rc) ((rc) == 0)
+#define R_FAILED(rc) ((rc) != 0)
+#define MAKERESULT(module, description) (((module) & 0x1FF) | ((description) & 0x1FFF) << 9)
+
+enum {
+    Module_Libnx = 345
+};
+
+enum {
+    LibnxError_NotFound = 9,
+    LibnxError_IoError = 10,
+    LibnxError_BadInput = 11
+};
+
+enum {
+    HidNpadButton_A      = 1u << 0,
+    HidNpadButton_B      = 1u << 1,
+    HidNpadButton_X      = 1u << 2,
+    HidNpadButton_Y      = 1u << 3,
+    HidNpadButton_StickL = 1u << 4,
+    HidNpadButton_StickR = 1u << 5,
+    HidNpadButton_L      = 1u << 6,
+    HidNpadButton_R      = 1u << 7,
+    HidNpadButton_ZL     = 1u << 8,
+    HidNpadButton_ZR     = 1u << 9,
+    HidNpadButton_Plus   = 1u << 10,
+    HidNpadButton_Minus  = 1u << 11,
+    HidNpadButton_Left   = 1u << 12,
+    HidNpadButton_Up     = 1u << 13,
+    HidNpadButton_Right  = 1u << 14,
+    HidNpadButton_Down   = 1u << 15
+};
+#endif
+
+// Платформа: дисплей, часы и ввод. Графика и интерфейсы работают только
+// через нее, поэтому на консоли это libnx, а на хосте - headless-реализация,
+// которая рисует в память и берет ввод из сценария.
+class Platform {
+public:
+    virtual ~Platform() = default;
+    
+    virtual bool initialize(uint32_t width, uint32_t height) = 0;
+    virtual void shutdown() = 0;
+    
+    // Буфер, в который рисуется следующий кадр (меняется после present)
+    virtual uint32_t* getFramebuffer(uint32_t* width, uint32_t* height) = 0;
+    // Показ кадра: сброс кэшей, смена буферов и ожидание vsync
+    virtual void present() = 0;
+    virtual void waitForVsync() = 0;
+    
+    // Монотонные часы
+    virtual uint64_t getTicks() = 0;
+    virtual uint64_t getTickFrequency() = 0;
+    
+    // false - приложению пора завершаться
+    virtual bool mainLoop() = 0;
+    // Кнопки, нажатые с прошлого опроса
+    virtual u64 pollButtonsDown() = 0;
+    
+    // Папка на SD-карте; уже существующая папка - не ошибка
+    virtual Result createDirectory(const std::string& path) = 0;
+    
+    // Платформа по умолчанию: libnx на консоли, headless на хосте
+    static Platform* getInstance();
+    // Подмена платформы; вызывается до инициализации графики
+    static void setInstance(Platform* platform);
+
+private:
+    static Platform* instance;
+};
+
+// Макросы для удобства
+#define PLATFORM Platform::getInstance()
@@ -0,0 +1,204 @@
+#pragma once
+#include <cstdint>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+#include "pixel_format.h"
+
+struct Color;
+struct CornerMask;
+
+// Программный растеризатор отрезками строк.
+// Все функции работают в экранных координатах и принимают предумноженные
+// цвета RGBA8; все, что вне границ цели, отсекается один раз на вызов.
+// Функции - шаблоны по формату цели, инстанцированные для PIXEL_FORMATS.
+namespace Raster {
+
+    // Координаты с фиксированной точкой 24.8: старшие биты - пиксель, младшие 8 -
+    // доли пикселя. Вещественные координаты переводятся в них один раз на входе,
+    // дальше края и покрытие считаются в целых числах.
+    typedef int32_t Fixed;
+    const int FIXED_SHIFT = 8;
+    const Fixed FIXED_ONE = 1 << FIXED_SHIFT;
+    
+    inline Fixed toFixed(float v) { return (Fixed)floorf(v * FIXED_ONE + 0.5f); }
+    inline Fixed toFixed(int v) { return v * FIXED_ONE; }
+    inline int fixedFloor(Fixed v) { return v >> FIXED_SHIFT; }
+    inline int fixedCeil(Fixed v) { return (v + FIXED_ONE - 1) >> FIXED_SHIFT; }
+    inline int fixedRound(Fixed v) { return (v + FIXED_ONE / 2) >> FIXED_SHIFT; }
+    
+    // Область пикселей, в которую идет рисование: весь кадровый буфер
+    // или отдельный тайл. Границы [x0, x1) x [y0, y1) - в экранных координатах.
+    // Формат F задает упаковку и наложение пикселей (pixel_format.h).
+    template<class F>
+    struct BasicTarget {
+        typedef typename F::Pixel Pixel;
+        
+        Pixel* pixels;
+        int stride;
+        int x0, y0, x1, y1;
+        
+        BasicTarget() : pixels(nullptr), stride(0), x0(0), y0(0), x1(0), y1(0) {}
+        BasicTarget(Pixel* buffer, int pitch, int left, int top, int right, int bottom)
+            : pixels(buffer), stride(pitch), x0(left), y0(top), x1(right), y1(bottom) {}
+        
+        // Указатель на начало экранной строки y (индексируется экранным x)
+        Pixel* row(int y) const { return pixels + (y - y0) * stride - x0; }
+        bool contains(int x, int y) const { return x >= x0 && x < x1 && y >= y0 && y < y1; }
+        bool valid() const { return pixels != nullptr && x0 < x1 && y0 < y1; }
+        
+        // Часть цели внутри [left, right) x [top, bottom): те же пиксели с более узкими
+        // границами, поэтому все функции растеризатора сразу отсекают по ней
+        BasicTarget clip(int left, int top, int right, int bottom) const {
+            BasicTarget result = *this;
+            result.x0 = std::max(x0, left);
+            result.y0 = std::max(y0, top);
+            result.x1 = std::min(x1, right);
+            result.y1 = std::min(y1, bottom);
+            if (result.x0 >= result.x1 || result.y0 >= result.y1) {
+                result.x1 = result.x0;
+                result.y1 = result.y0;
+                return result;
+            }
+            result.pixels = row(result.y0) + result.x0;
+            return result;
+        }
+    };
+    
+    // Основная цель: RGBA8 с предумноженной альфой
+    typedef BasicTarget<PixelFormat::RGBA8888> Target;
+    
+    template<class F>
+    void plot(const BasicTarget<F>& target, int x, int y, uint32_t pixel);
+    template<class F>
+    void fillSpan(const BasicTarget<F>& target, int y, int x0, int x1, uint32_t pixel);
+    template<class F>
+    void blendSpan(const BasicTarget<F>& target, int x, int y, const uint32_t* pixels, int count, uint32_t opacity);
+    
+    template<class F>
+    void fillRect(const BasicTarget<F>& target, int x, int y, int w, int h, uint32_t pixel);
+    // Прямоугольник в 24.8: краевые пиксели получают закрытую долю площади
+    template<class F>
+    void fillRectFixed(const BasicTarget<F>& target, Fixed x, Fixed y, Fixed w, Fixed h, uint32_t pixel);
+    
+    // Скругленный прямоугольник и круг: положение в 24.8, размеры и радиус -
+    // в целых пикселях (маски покрытия строятся по целым радиусам)
+    template<class F>
+    void fillRoundedRect(const BasicTarget<F>& target, Fixed x, Fixed y, int w, int h, int radius, uint32_t pixel);
+    // То же с уже полученной маской: радиус - mask.radius (пакеты кругов)
+    template<class F>
+    void fillRoundedRectWithMask(const BasicTarget<F>& target, Fixed x, Fixed y, int w, int h,
+                                 const CornerMask& mask, uint32_t pixel);
+    template<class F>
+    void fillCircle(const BasicTarget<F>& target, Fixed cx, Fixed cy, int radius, uint32_t pixel);
+    // Круги до этого радиуса (частицы, искры) ставятся в угол пикселя: дробный
+    // сдвиг на них почти не виден, а смесь покрытий стоит дороже самого круга
+    const int SNAP_RADIUS = 4;
+    
+    // Линейный и радиальный градиенты (gradient.cpp); dither включает
+    // упорядоченное сглаживание против полос
+    template<class F>
+    void fillGradient(const BasicTarget<F>& target, int x, int y, int w, int h,
+                      const Color& startColor, const Color& endColor, bool vertical, bool dither);
+    template<class F>
+    void fillRadialGradient(const BasicTarget<F>& target, int cx, int cy, int radius,
+                            const Color& innerColor, const Color& outerColor, bool dither);
+    
+    // Линии (line.cpp) с концами в 24.8, целые координаты - центры пикселей:
+    // тонкие - сглаженные по Ву, толстые - залитый прямоугольник
+    template<class F>
+    void drawLineAA(const BasicTarget<F>& target, Fixed x1, Fixed y1, Fixed x2, Fixed y2, uint32_t pixel);
+    template<class F>
+    void drawLine(const BasicTarget<F>& target, Fixed x1, Fixed y1, Fixed x2, Fixed y2, uint32_t pixel, float width);
+    
+    // Насколько линия толщиной width выходит за прямоугольник своих концов
+    int linePadding(float width);
+    
+    // Выпуклые многоугольники (polygon.cpp). Вершины - пары (x, y) в 24.8,
+    // обход в любую сторону. Для невыпуклых многоугольников результат не определен.
+    const int MAX_POLYGON_VERTICES = 16;
+    
+    template<class F>
+    void fillPolygon(const BasicTarget<F>& target, const Fixed* points, int count, uint32_t pixel, bool antialias);
+    template<class F>
+    void fillTriangle(const BasicTarget<F>& target, const Fixed* points, uint32_t pixel, bool antialias);
+    
+    // Рабочие массивы пакетов. Принадлежат вызывающему и переиспользуются
+    // между вызовами, поэтому пакет не выделяет память на каждом кадре.
+    struct BatchScratch {
+        std::vector<int> items, rows, start, next, order, active, merged;
+        std::vector<const CornerMask*> masks;
+        std::vector<std::shared_ptr<const CornerMask>> holders;
+    };
+    
+    // Пакеты кругов и точек (batch.cpp): массивы одной длины count, пиксели предумножены,
+    // центры кругов в 24.8.
+    // Видимые элементы раскладываются по строкам (круги - по полосам из нескольких
+    // строк) один раз и рисуются сверху вниз; пересекающиеся элементы накладываются
+    // в порядке массива.
+    template<class F>
+    void fillCircles(const BasicTarget<F>& target, const Fixed* cx, const Fixed* cy, const int32_t* radius,
+                     const uint32_t* pixels, int count, BatchScratch& scratch);
+    template<class F>
+    void plotPoints(const BasicTarget<F>& target, const int32_t* x, const int32_t* y,
+                    const uint32_t* pixels, int count, BatchScratch& scratch);
+    
+    // Вывод прямоугольника пикселей w x h с шагом srcStride в точку (x, y).
+    // Непрозрачный источник без общей прозрачности копируется построчно,
+    // остальное смешивается векторными ядрами Blend.
+    template<class F>
+    void blit(const BasicTarget<F>& target, const uint32_t* pixels, int srcStride, int w, int h,
+              int x, int y, uint32_t opacity, bool opaque);
+    
+    // То же, но источник srcW x srcH повторяется, заполняя прямоугольник w x h.
+    // Источник шириной в один пиксель растягивается заливкой отрезков строк.
+    template<class F>
+    void tile(const BasicTarget<F>& target, const uint32_t* pixels, int srcStride, int srcW, int srcH,
+              int x, int y, int w, int h, uint32_t opacity, bool opaque);
+    
+    // Заливка цветом через маску покрытия w x h (0..255, шаг строки maskStride)
+    // в точке (x, y): глифы шрифта и другие сглаженные маски
+    template<class F>
+    void fillMask(const BasicTarget<F>& target, const uint8_t* mask, int maskStride, int w, int h,
+                  int x, int y, uint32_t pixel);
+    
+    // Обратное аффинное отображение приемника в источник: центр пикселя (x, y)
+    // берется из точки (u, v), центр пикселя (x + i, y + j) - из
+    // (u + i * dudx + j * dudy, v + i * dvdx + j * dvdy). Все в 16.16,
+    // целые u, v - левые верхние углы пикселей источника.
+    struct AffineMap {
+        int x, y;
+        int64_t u, v;
+        int32_t dudx, dvdx, dudy, dvdy;
+    };
+    
+    // Аффинный вывод изображения srcW x srcH (transform.cpp): проход по пикселям
+    // приемника, для каждой строки видимый отрезок находится аналитически,
+    // координаты источника идут приращениями. Выборка ближайшая или билинейная
+    // (края источника плавно уходят в прозрачность), затем общая прозрачность.
+    template<class F>
+    void blitAffine(const BasicTarget<F>& target, const uint32_t* pixels, int srcStride, int srcW, int srcH,
+                    const AffineMap& map, uint32_t opacity, bool bilinear);
+    
+    // Поле расстояний глифа width x height текселей (0 - далеко снаружи,
+    // 255 - глубоко внутри), размещенное на экране: левый верхний угол
+    // текселя (0, 0) в точке (x, y) в 16.16
+    struct FieldGlyph {
+        const uint8_t* texels;
+        int width, height;
+        int32_t x, y;
+    };
+    
+    // Размер таблицы цветов поля: индекс - значение поля с двумя дробными битами
+    const int FIELD_LUT_SIZE = 1024;
+    
+    // Строка по полям расстояний (distance_field.cpp). В каждом пикселе поля
+    // глифов выбираются билинейно и объединяются максимумом, затем цвет
+    // пикселя один раз берется из lut - заливка, обводка и свечение
+    // перекрывающихся глифов не складываются. texelSize - сторона текселя
+    // в пикселях, 16.16.
+    template<class F>
+    void fillDistanceField(const BasicTarget<F>& target, const FieldGlyph* glyphs, int count,
+                           int32_t texelSize, const uint32_t* lut);
+}
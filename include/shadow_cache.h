@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+#include "surface.h"
+
+// Размытая тень или свечение скругленного прямоугольника в виде nine-patch.
+// Углы corner x corner берутся как есть, центральные строка и столбец
+// растягиваются вдоль сторон, центральный пиксель заливает середину.
+struct NinePatch {
+    Surface surface;
+    int corner;     // Размер угла
+    int pad;        // Насколько тень выходит за фигуру
+};
+
+// Кэш nine-patch по ключу (радиус скругления, размытие, предумноженный цвет).
+// Каждый патч строится один раз настоящим раздельным гауссовым размытием.
+class ShadowCache {
+public:
+    static const int MAX_ENTRIES = 16;
+    
+    ShadowCache();
+    
+    // Начало кадра: патчи, использованные в прошлых кадрах, можно вытеснять
+    void beginFrame() { frame++; }
+    
+    // Патч для ключа; nullptr, если все записи заняты текущим кадром
+    // (отложенный список команд еще ссылается на их поверхности)
+    const NinePatch* get(int radius, int blur, uint32_t color);
+
+private:
+    struct Entry {
+        int radius, blur;
+        uint32_t color;
+        unsigned lastUse;
+        unsigned lastFrame;
+        bool used;
+        NinePatch patch;
+    };
+    
+    static bool build(NinePatch& patch, int radius, int blur, uint32_t color);
+    
+    Entry entries[MAX_ENTRIES];
+    unsigned clock;
+    unsigned frame;
+};
@@ -1,7 +1,10 @@
 #pragma once
-#include <switch.h>
+#include "platform.h"
 #include <string>
 #include <functional>
+#include "dirty_region.h"
+
+class TextLayoutCache;
 
 // Простые цвета Switch
 struct Color {
@@ -39,6 +42,14 @@ private:
     uint32_t* framebuffer;
     uint32_t width, height;
     
+    // Частичная перерисовка: повреждения текущего и предыдущего кадра
+    DirtyRegion damage;
+    DirtyRegion previousDamage;
+    int clipX0, clipY0, clipX1, clipY1;
+    
+    // Раскладки надписей: кнопки меряются и рисуются по готовой раскладке
+    TextLayoutCache* layouts;
+
 public:
     SimpleInterface();
     ~SimpleInterface();
@@ -49,7 +60,15 @@ public:
     void render();
     bool handleInput(u64 kDown);
     
+    // Пометить область экрана для перерисовки в следующем кадре
+    void invalidate(int x, int y, int w, int h);
+    void invalidateAll();
+
 private:
+    void renderScreen();
+    void invalidateItem(Screen screen, int item);
+    void setClip(const DirtyRect& rect);
+    
     void renderMainScreen();
     void renderMenu();
     void renderSettings();
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include "rasterizer.h"
+
+// Внеэкранная поверхность: собственный буфер пикселей RGBA8 с предумноженной альфой.
+// Начало буфера выровнено на 64 байта, шаг строки кратен 16 пикселям,
+// поэтому каждая строка начинается с новой кэш-линии.
+class Surface {
+public:
+    Surface();
+    Surface(int width, int height);
+    ~Surface();
+    
+    Surface(const Surface&) = delete;
+    Surface& operator=(const Surface&) = delete;
+    
+    bool create(int width, int height);
+    void release();
+    
+    // Заливка всей поверхности (по умолчанию - полностью прозрачная)
+    void clear(uint32_t pixel = 0);
+    
+    bool valid() const { return pixels != nullptr; }
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    int getStride() const { return stride; }
+    uint32_t* getPixels() { return pixels; }
+    const uint32_t* getPixels() const { return pixels; }
+    uint32_t* row(int y) { return pixels + y * stride; }
+    const uint32_t* row(int y) const { return pixels + y * stride; }
+    
+    // Цель растеризации в координатах поверхности
+    Raster::Target target() const { return Raster::Target(pixels, stride, 0, 0, width, height); }
+    
+    // Непрозрачная поверхность копируется без смешивания
+    void setOpaque(bool value) { opaque = value; }
+    bool isOpaque() const { return opaque; }
+    
+    // Вывод другой поверхности в точку (x, y) этой поверхности
+    void blit(const Surface& source, int x, int y, float opacity = 1.0f);
+
+private:
+    uint32_t* pixels;
+    int width, height;
+    int stride;
+    bool opaque;
+};
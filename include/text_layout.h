@@ -0,0 +1,70 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "font.h"
+
+// Разложенная строка: номера глифов начертания и положения пера.
+// Строки разделяются '\n' и идут одна под другой с шагом в размер шрифта.
+struct TextLayout {
+    struct Line {
+        int first, count;       // Глифы строки в glyphs и x
+        int width;
+    };
+    
+    const FontFace* face;
+    std::vector<uint16_t> glyphs;
+    std::vector<int32_t> x;     // Перо каждого глифа от начала его строки
+    std::vector<Line> lines;
+    int width;                  // Ширина самой длинной строки
+    int height;                 // Число строк, умноженное на размер
+    
+    void build(const FontFace* face, const char* text, size_t length);
+    
+    // Повтор раскладки с верхом первой строки в y; глифы и строки вне цели пропускаются
+    template<class F>
+    void draw(const Raster::BasicTarget<F>& target, int x, int y, uint32_t pixel) const;
+    
+    size_t memoryBytes() const;
+};
+
+// Кэш раскладок по хэшу строки и размеру шрифта. Надписи интерфейса
+// одни и те же из кадра в кадр, и свечение рисует одну строку десятки раз,
+// поэтому повторные вызовы только проигрывают готовую раскладку.
+// Записи вытесняются лишь в начале кадра, так что отложенный список
+// команд может ссылаться на раскладки до конца кадра.
+class TextLayoutCache {
+public:
+    static const size_t MAX_BYTES = 64 * 1024;
+    
+    TextLayoutCache();
+    
+    // Начало кадра: давно не использованные записи сверх MAX_BYTES удаляются
+    void beginFrame();
+    
+    // Раскладка строки; строится при первом обращении
+    const TextLayout* get(const std::string& text, int size);
+    
+    int getHits() const { return hits; }
+    int getMisses() const { return misses; }
+    size_t getEntryCount() const { return entries.size(); }
+    size_t getMemoryBytes() const { return bytes; }
+
+private:
+    struct Entry {
+        std::string text;
+        int size;
+        unsigned lastUse;
+        size_t bytes;
+        TextLayout layout;
+    };
+    
+    static uint64_t hash(const std::string& text, int size);
+    
+    // Записи с общим хэшем лежат рядом; узлы не переезжают при росте таблицы
+    std::unordered_multimap<uint64_t, Entry> entries;
+    size_t bytes;
+    unsigned clock;
+    int hits, misses;       // С начала кадра
+};
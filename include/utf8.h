@@ -0,0 +1,61 @@
+#pragma once
+#include <cstdint>
+
+// Декодирование UTF-8 в текстовом пути.
+// Некорректная последовательность (одиночный байт продолжения, избыточная
+// запись, суррогат, код больше U+10FFFF, обрыв строки) дает REPLACEMENT и
+// пропускает только свою корректную начальную часть, поэтому разбор всегда
+// продвигается и не выходит за end.
+namespace Utf8 {
+
+    const uint32_t REPLACEMENT = 0xFFFD;
+    
+    // Многобайтная последовательность; p указывает на ведущий байт >= 0x80.
+    // Допустимые диапазоны второго байта - по таблице 3-7 стандарта Unicode.
+    inline uint32_t decodeMultibyte(const unsigned char*& p, const unsigned char* end) {
+        uint32_t lead = p[0];
+        uint32_t lo = 0x80, hi = 0xBF;
+        uint32_t c;
+        int length;
+        
+        if (lead >= 0xC2 && lead <= 0xDF) {
+            length = 2;
+            c = lead & 0x1F;
+        } else if (lead >= 0xE0 && lead <= 0xEF) {
+            length = 3;
+            c = lead & 0x0F;
+            if (lead == 0xE0) lo = 0xA0;        // Избыточная запись
+            else if (lead == 0xED) hi = 0x9F;   // Суррогаты
+        } else if (lead >= 0xF0 && lead <= 0xF4) {
+            length = 4;
+            c = lead & 0x07;
+            if (lead == 0xF0) lo = 0x90;        // Избыточная запись
+            else if (lead == 0xF4) hi = 0x8F;   // Больше U+10FFFF
+        } else {
+            p++;
+            return REPLACEMENT;
+        }
+        
+        for (int i = 1; i < length; i++) {
+            if (p + i >= end || p[i] < lo || p[i] > hi) {
+                p += i;
+                return REPLACEMENT;
+            }
+            c = (c << 6) | (p[i] & 0x3F);
+            lo = 0x80;
+            hi = 0xBF;
+        }
+        p += length;
+        return c;
+    }
+    
+    // Следующий код строки; p < end. ASCII возвращается без проверок.
+    inline uint32_t next(const unsigned char*& p, const unsigned char* end) {
+        uint32_t c = *p;
+        if (c < 0x80) {
+            p++;
+            return c;
+        }
+        return decodeMultibyte(p, end);
+    }
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+
+#ifdef __SWITCH__
+#include <switch.h>
+#else
+#include <thread>
+#endif
+
+// Пул рабочих потоков для рендера по тайлам.
+// На консоли потоки создаются через threadCreate и закрепляются за ядрами 0-2,
+// на хосте используются std::thread. Задачи раздаются непрерывными диапазонами,
+// освободившийся поток забирает оставшиеся задачи из чужих диапазонов.
+class WorkerPool {
+public:
+    static const int MAX_WORKERS = 3;
+    
+    // Задача: индекс элемента и номер потока (для выбора локального буфера)
+    typedef std::function<void(int index, int worker)> Task;
+    
+    WorkerPool();
+    ~WorkerPool();
+    
+    bool start(int threadCount);
+    void stop();
+    
+    int getThreadCount() const { return threadCount; }
+    
+    // Ядра, на которых могут работать потоки: на консоли приложению
+    // доступны ядра 0-2, на хосте - сколько сообщает система
+    static int getCoreCount();
+    
+    // Выполнение task для индексов [0, count) на всех потоках с ожиданием завершения.
+    // Без запущенных потоков задачи выполняются в вызывающем потоке.
+    void run(int count, const Task& task);
+
+private:
+    struct Queue {
+        std::atomic<int> next;
+        int end;
+    };
+    
+    struct WorkerArgs {
+        WorkerPool* pool;
+        int id;
+        unsigned generation;    // Поколение задач на момент запуска потока
+    };
+    
+    static void threadEntry(void* arg);
+    void workerLoop(int id, unsigned seen);
+    void process(int id);
+    
+    Queue queues[MAX_WORKERS];
+    WorkerArgs args[MAX_WORKERS];
+#ifdef __SWITCH__
+    Thread threads[MAX_WORKERS];
+#else
+    std::thread threads[MAX_WORKERS];
+#endif
+    int threadCount;
+    
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    const Task* task;
+    unsigned generation;
+    int pending;
+    bool stopping;
+};
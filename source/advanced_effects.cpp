@@ -1,12 +1,13 @@
 #include "graphics.h"
 #include "icon_loader.h"
+#include <algorithm>
 #include <cmath>
 #include <random>
 #include <vector>
 
 // Advanced visual effects for NEOVIA
 namespace AdvancedEffects {
-    
+
     // Holographic effect with rainbow colors
     void drawHolographicPanel(float x, float y, float width, float height, float time, float intensity = 1.0f) {
         // Create holographic shimmer effect
@@ -47,23 +48,14 @@ namespace AdvancedEffects {
     // Neon glow text effect
     void drawNeonText(const std::string& text, float x, float y, const Color& color, 
                      int fontSize, float glowSize = 8.0f, float intensity = 1.0f) {
-        // Draw multiple glow layers
-        for (int layer = (int)glowSize; layer > 0; layer--) {
-            float alpha = intensity * (1.0f - (float)layer / glowSize) * 0.3f;
-            Color glowColor(color.r, color.g, color.b, (uint8_t)(255 * alpha));
-            
-            // Draw text at multiple offsets for glow effect
-            for (int dx = -layer; dx <= layer; dx++) {
-                for (int dy = -layer; dy <= layer; dy++) {
-                    if (dx * dx + dy * dy <= layer * layer) {
-                        GFX->drawText(text, x + dx, y + dy, glowColor, fontSize);
-                    }
-                }
-            }
-        }
-        
-        // Draw main text
-        GFX->drawText(text, x, y, color, fontSize);
+        // Fill and glow in one distance-field pass; the glow fades out over glowSize pixels
+        TextStyle style;
+        style.fill = color;
+        style.outline = Color(0, 0, 0, 0);
+        style.glow = Color(color.r, color.g, color.b, (uint8_t)(255 * std::min(1.0f, intensity * 0.6f)));
+        style.outlineWidth = 0.0f;
+        style.glowRadius = glowSize;
+        GFX->drawStyledText(text, x, y, fontSize, style);
     }
     
     // Plasma effect background
@@ -101,10 +93,6 @@ namespace AdvancedEffects {
                 float fx = (float)px / width;
                 float fy = (float)py / height;
                 
-                // Create refraction effect
-                float offsetX = sin(fy * 10.0f + time) * refraction * width;
-                float offsetY = cos(fx * 10.0f + time) * refraction * height;
-                
                 // Sample "background" with offset
                 float intensity = 0.8f + 0.2f * sin((fx + fy) * 8.0f + time * 2.0f);
                 
@@ -131,13 +119,13 @@ namespace AdvancedEffects {
         float brightness;
         float phase;
     };
-
+    
     // Animated constellation effect
     void drawConstellation(float x, float y, float width, float height, float time, int starCount = 20) {
         static std::vector<Star> stars;
         
         // Initialize stars
-        if (stars.empty() || stars.size() != starCount) {
+        if (stars.empty() || stars.size() != (size_t)starCount) {
             stars.clear();
             stars.resize(starCount);
             std::random_device rd;
@@ -154,6 +142,15 @@ namespace AdvancedEffects {
             }
         }
         
+        // Star crosses and connection lines are drawn in two batches
+        static std::vector<float> pointX, pointY;
+        static std::vector<uint32_t> pointColors;
+        static std::vector<LineSegment> connections;
+        pointX.clear();
+        pointY.clear();
+        pointColors.clear();
+        connections.clear();
+        
         // Draw stars
         for (size_t i = 0; i < stars.size(); i++) {
             const auto& star = stars[i];
@@ -166,14 +163,17 @@ namespace AdvancedEffects {
             float starX = x + star.x;
             float starY = y + star.y;
             
-            // Draw star with cross pattern
-            GFX->drawPixel(starX, starY, starColor);
-            GFX->drawPixel(starX - 1, starY, Color(intensity/2, intensity/2, intensity/2, intensity/2));
-            GFX->drawPixel(starX + 1, starY, Color(intensity/2, intensity/2, intensity/2, intensity/2));
-            GFX->drawPixel(starX, starY - 1, Color(intensity/2, intensity/2, intensity/2, intensity/2));
-            GFX->drawPixel(starX, starY + 1, Color(intensity/2, intensity/2, intensity/2, intensity/2));
+            // Star with cross pattern
+            const float crossX[5] = { 0, -1, 1, 0, 0 };
+            const float crossY[5] = { 0, 0, 0, -1, 1 };
+            uint32_t armColor = Color(intensity/2, intensity/2, intensity/2, intensity/2).toRGBA();
+            for (int k = 0; k < 5; k++) {
+                pointX.push_back(starX + crossX[k]);
+                pointY.push_back(starY + crossY[k]);
+                pointColors.push_back(k == 0 ? starColor.toRGBA() : armColor);
+            }
             
-            // Draw connections to nearby stars
+            // Collect connections to nearby stars
             for (size_t j = i + 1; j < stars.size(); j++) {
                 const auto& other = stars[j];
                 float dx = star.x - other.x;
@@ -185,10 +185,13 @@ namespace AdvancedEffects {
                     Color lineColor(Colors::PRIMARY.r, Colors::PRIMARY.g, Colors::PRIMARY.b, 
                                    (uint8_t)(255 * alpha));
                     
-                    GFX->drawLine(x + star.x, y + star.y, x + other.x, y + other.y, lineColor);
+                    connections.push_back({ x + star.x, y + star.y, x + other.x, y + other.y, lineColor });
                 }
             }
         }
+        
+        GFX->drawPoints(pointX.data(), pointY.data(), pointColors.data(), (int)pointColors.size());
+        GFX->drawLines(connections.data(), (int)connections.size());
     }
     
     // Liquid metal effect
@@ -264,13 +267,7 @@ namespace AdvancedEffects {
                     Color glowColor(255, 255, 255, (uint8_t)(150 * glowIntensity));
                     
                     // Draw small glow
-                    for (int dy = -2; dy <= 2; dy++) {
-                        for (int dx = -2; dx <= 2; dx++) {
-                            if (dx * dx + dy * dy <= 4) {
-                                GFX->drawPixel(x + gx + dx, y + gy + dy, glowColor);
-                            }
-                        }
-                    }
+                    GFX->drawRadialGradient(x + gx + 0.5f, y + gy + 0.5f, 3, glowColor, Color(255, 255, 255, 0));
                 }
             }
         }
@@ -286,7 +283,8 @@ namespace AdvancedEffects {
         Color glowColor(Colors::PRIMARY.r, Colors::PRIMARY.g, Colors::PRIMARY.b, 
                        (uint8_t)(100 * pulse));
         
-        GFX->drawCircle(x + logoSize/2, y + logoSize/2, logoSize * 0.6f * pulse, glowColor);
+        GFX->drawRadialGradient(x + logoSize/2, y + logoSize/2, logoSize * 0.6f * pulse, glowColor,
+                                Color(glowColor.r, glowColor.g, glowColor.b, 0));
         
         // Rotating elements
         for (int i = 0; i < 6; i++) {
@@ -0,0 +1,135 @@
+#include "rasterizer.h"
+#include "corner_mask.h"
+#include <algorithm>
+
+namespace {
+
+    // Высота полосы, по которой идут круги пакета: в полосе каждый круг
+    // рисуется одним вызовом, а полоса целиком остается в кэше
+    const int BAND = 32;
+    
+    // Устойчивая сортировка подсчетом: индексы элементов в порядке
+    // первой строки, внутри строки - в порядке массива
+    void sortByRow(Raster::BatchScratch& scratch, int rowCount) {
+        const std::vector<int>& items = scratch.items;
+        const std::vector<int>& rows = scratch.rows;
+        std::vector<int>& start = scratch.start;
+        std::vector<int>& next = scratch.next;
+        
+        start.assign(rowCount + 1, 0);
+        for (int row : rows) start[row + 1]++;
+        for (int i = 0; i < rowCount; i++) start[i + 1] += start[i];
+        
+        scratch.order.resize(items.size());
+        next.assign(start.begin(), start.end() - 1);
+        for (size_t k = 0; k < items.size(); k++) {
+            scratch.order[next[rows[k]]++] = items[k];
+        }
+    }
+}
+
+namespace Raster {
+
+    // Видимые круги раскладываются по первой полосе, затем кадр проходится
+    // полосами сверху вниз со списком активных кругов, упорядоченным по индексу:
+    // пересекающиеся круги накладываются в том же порядке, что и по одному.
+    template<class F>
+    void fillCircles(const BasicTarget<F>& target, const Fixed* cx, const Fixed* cy, const int32_t* radius,
+                     const uint32_t* pixels, int count, BatchScratch& scratch) {
+        if (!target.valid() || count <= 0) return;
+        
+        std::vector<int>& items = scratch.items;
+        std::vector<int>& rows = scratch.rows;
+        items.clear();
+        rows.clear();
+        int maxRadius = 0;
+        for (int i = 0; i < count; i++) {
+            int r = radius[i];
+            if (r <= 0 || (pixels[i] & 0xFF) == 0) continue;
+            if (fixedCeil(cx[i] + toFixed(r)) <= target.x0 || fixedFloor(cx[i] - toFixed(r)) >= target.x1) continue;
+            if (fixedCeil(cy[i] + toFixed(r)) <= target.y0 || fixedFloor(cy[i] - toFixed(r)) >= target.y1) continue;
+            
+            items.push_back(i);
+            rows.push_back((std::max(fixedFloor(cy[i] - toFixed(r)), target.y0) - target.y0) / BAND);
+            maxRadius = std::max(maxRadius, r);
+        }
+        if (items.empty()) return;
+        
+        int bandCount = (target.y1 - target.y0 + BAND - 1) / BAND;
+        sortByRow(scratch, bandCount);
+        const std::vector<int>& start = scratch.start;
+        const std::vector<int>& order = scratch.order;
+        
+        // Маски берутся из кэша один раз на радиус; большие радиусы
+        // удерживаются до конца пакета
+        std::vector<const CornerMask*>& masks = scratch.masks;
+        masks.assign(maxRadius + 1, nullptr);
+        scratch.holders.resize(maxRadius + 1);
+        for (int i : order) {
+            if (!masks[radius[i]]) masks[radius[i]] = CORNER_MASKS->get(radius[i], scratch.holders[radius[i]]);
+        }
+        
+        // Новые круги полосы вливаются в активный список через второй буфер
+        std::vector<int>& active = scratch.active;
+        std::vector<int>& merged = scratch.merged;
+        active.clear();
+        for (int band = 0; band < bandCount; band++) {
+            int first = start[band], last = start[band + 1];
+            if (active.empty() && first == last) continue;
+            
+            if (first < last) {
+                merged.resize(active.size() + (last - first));
+                std::merge(active.begin(), active.end(), order.begin() + first, order.begin() + last,
+                           merged.begin());
+                active.swap(merged);
+            }
+            
+            int y0 = target.y0 + band * BAND;
+            BasicTarget<F> strip = target.clip(target.x0, y0, target.x1, y0 + BAND);
+            size_t kept = 0;
+            for (size_t k = 0; k < active.size(); k++) {
+                int i = active[k];
+                int r = radius[i];
+                
+                // Та же заливка, что у fillCircle, поэтому пакет и одиночные круги
+                // дают одинаковые пиксели
+                fillRoundedRectWithMask(strip, cx[i] - toFixed(r), cy[i] - toFixed(r), 2 * r, 2 * r,
+                                        *masks[r], pixels[i]);
+                if (fixedCeil(cy[i] + toFixed(r)) > strip.y1) active[kept++] = i;
+            }
+            active.resize(kept);
+        }
+        scratch.holders.clear();
+    }
+    
+    // Точки сортируются по строкам, чтобы запись в буфер шла сверху вниз,
+    // а не в случайные строки; точки одной строки сохраняют порядок массива
+    template<class F>
+    void plotPoints(const BasicTarget<F>& target, const int32_t* x, const int32_t* y,
+                    const uint32_t* pixels, int count, BatchScratch& scratch) {
+        if (!target.valid() || count <= 0) return;
+        
+        scratch.items.clear();
+        scratch.rows.clear();
+        for (int i = 0; i < count; i++) {
+            if ((pixels[i] & 0xFF) == 0 || !target.contains(x[i], y[i])) continue;
+            scratch.items.push_back(i);
+            scratch.rows.push_back(y[i] - target.y0);
+        }
+        if (scratch.items.empty()) return;
+        
+        sortByRow(scratch, target.y1 - target.y0);
+        
+        for (int i : scratch.order) {
+            F::plot(target.row(y[i]) + x[i], pixels[i]);
+        }
+    }
+
+#define INSTANTIATE(F) \
+    template void fillCircles(const BasicTarget<F>&, const Fixed*, const Fixed*, const int32_t*, const uint32_t*, int, \
+                              BatchScratch&); \
+    template void plotPoints(const BasicTarget<F>&, const int32_t*, const int32_t*, const uint32_t*, int, BatchScratch&);
+    
+    PIXEL_FORMATS(INSTANTIATE)
+#undef INSTANTIATE
+}
@@ -0,0 +1,413 @@
+#include "blend.h"
+#include <cstring>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define BLEND_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define BLEND_SSE2 1
+#endif
+
+// Скалярная реализация
+namespace Blend {
+namespace Scalar {
+
+    void blendColor(uint32_t* dst, int count, uint32_t color) {
+        for (int i = 0; i < count; i++) {
+            dst[i] = blendPixel(dst[i], color);
+        }
+    }
+    
+    void blendPixels(uint32_t* dst, const uint32_t* src, int count) {
+        for (int i = 0; i < count; i++) {
+            dst[i] = blendPixel(dst[i], src[i]);
+        }
+    }
+    
+    void blendPixelsOpacity(uint32_t* dst, const uint32_t* src, int count, uint32_t opacity) {
+        for (int i = 0; i < count; i++) {
+            dst[i] = blendPixel(dst[i], scalePixel(src[i], opacity));
+        }
+    }
+    
+    void blendMask(uint32_t* dst, const uint8_t* mask, int count, uint32_t color) {
+        for (int i = 0; i < count; i++) {
+            if (mask[i]) dst[i] = blendPixel(dst[i], scalePixel(color, mask[i]));
+        }
+    }
+    
+    void copyPixels(uint32_t* dst, const uint32_t* src, int count) {
+        if (count > 0) memcpy(dst, src, count * sizeof(uint32_t));
+    }
+    
+    void sampleBilinear(uint32_t* dst, const uint32_t* src, int stride,
+                        int32_t u, int32_t v, int32_t du, int32_t dv, int count) {
+        for (int i = 0; i < count; i++, u += du, v += dv) {
+            const uint32_t* p = src + (v >> 16) * stride + (u >> 16);
+            dst[i] = bilinearPixel(p[0], p[1], p[stride], p[stride + 1], (u >> 8) & 0xFF, (v >> 8) & 0xFF);
+        }
+    }
+}
+}
+
+#if defined(BLEND_NEON)
+
+// ARMv8 NEON: 16 пикселей за итерацию.
+// vld4q_u8 раскладывает пиксели по каналам; в памяти (little-endian)
+// порядок байтов a, b, g, r, поэтому val[0] - альфа.
+namespace {
+
+    // x * y / 255 с точным округлением для 16 значений.
+    // (t * 257) >> 16 == (t + (t >> 8)) >> 8 при t < 65536, а vaddhn_u16
+    // как раз возвращает старшие 8 бит суммы.
+    inline uint8x16_t mulLanes(uint8x16_t x, uint8x16_t y) {
+        const uint16x8_t bias = vdupq_n_u16(128);
+        uint16x8_t lo = vaddq_u16(vmull_u8(vget_low_u8(x), vget_low_u8(y)), bias);
+        uint16x8_t hi = vaddq_u16(vmull_high_u8(x, y), bias);
+        return vcombine_u8(vaddhn_u16(lo, vshrq_n_u16(lo, 8)),
+                           vaddhn_u16(hi, vshrq_n_u16(hi, 8)));
+    }
+    
+    inline void overPixels(const uint8x16x4_t& s, uint8x16x4_t& d) {
+        const uint8x16_t ia = vmvnq_u8(s.val[0]);
+        for (int c = 0; c < 4; c++) {
+            d.val[c] = vqaddq_u8(s.val[c], mulLanes(d.val[c], ia));
+        }
+    }
+    
+    // (a * (256 - t) + b * t + 128) >> 8 в 16-битных лапах;
+    // сумма не больше 255 * 256, так что переполнения нет
+    inline uint16x8_t lerpWide(uint16x8_t a, uint16x8_t b, uint16x8_t t) {
+        uint16x8_t s = vmlaq_u16(vmulq_u16(a, vsubq_u16(vdupq_n_u16(256), t)), b, t);
+        return vrshrq_n_u16(s, 8);
+    }
+    
+    // Вертикальная интерполяция пары соседей p[0], p[1] с парой строкой ниже
+    inline uint16x8_t columnPair(const uint32_t* p, int stride, int32_t v) {
+        uint16x8_t top = vmovl_u8(vreinterpret_u8_u32(vld1_u32(p)));
+        uint16x8_t bottom = vmovl_u8(vreinterpret_u8_u32(vld1_u32(p + stride)));
+        return lerpWide(top, bottom, vdupq_n_u16((v >> 8) & 0xFF));
+    }
+    
+    // Две точки выборки: столбцы обеих пар, затем интерполяция между столбцами
+    inline uint8x8_t bilinearPair(const uint32_t* src, int stride, int32_t& u, int32_t& v, int32_t du, int32_t dv) {
+        uint16x8_t a = columnPair(src + (v >> 16) * stride + (u >> 16), stride, v);
+        uint16_t fa = (u >> 8) & 0xFF;
+        u += du;
+        v += dv;
+        uint16x8_t b = columnPair(src + (v >> 16) * stride + (u >> 16), stride, v);
+        uint16_t fb = (u >> 8) & 0xFF;
+        u += du;
+        v += dv;
+        
+        uint16x8_t left = vcombine_u16(vget_low_u16(a), vget_low_u16(b));
+        uint16x8_t right = vcombine_u16(vget_high_u16(a), vget_high_u16(b));
+        return vmovn_u16(lerpWide(left, right, vcombine_u16(vdup_n_u16(fa), vdup_n_u16(fb))));
+    }
+}
+
+namespace Blend {
+
+    void blendColor(uint32_t* dst, int count, uint32_t color) {
+        uint8x16x4_t s;
+        s.val[0] = vdupq_n_u8(color & 0xFF);
+        s.val[1] = vdupq_n_u8((color >> 8) & 0xFF);
+        s.val[2] = vdupq_n_u8((color >> 16) & 0xFF);
+        s.val[3] = vdupq_n_u8(color >> 24);
+        
+        int i = 0;
+        for (; i + 16 <= count; i += 16) {
+            uint8_t* p = (uint8_t*)(dst + i);
+            uint8x16x4_t d = vld4q_u8(p);
+            overPixels(s, d);
+            vst4q_u8(p, d);
+        }
+        Scalar::blendColor(dst + i, count - i, color);
+    }
+    
+    void blendPixels(uint32_t* dst, const uint32_t* src, int count) {
+        int i = 0;
+        for (; i + 16 <= count; i += 16) {
+            uint8_t* p = (uint8_t*)(dst + i);
+            uint8x16x4_t s = vld4q_u8((const uint8_t*)(src + i));
+            uint8x16x4_t d = vld4q_u8(p);
+            overPixels(s, d);
+            vst4q_u8(p, d);
+        }
+        Scalar::blendPixels(dst + i, src + i, count - i);
+    }
+    
+    void blendPixelsOpacity(uint32_t* dst, const uint32_t* src, int count, uint32_t opacity) {
+        if (opacity >= 255) {
+            blendPixels(dst, src, count);
+            return;
+        }
+        
+        const uint8x16_t o = vdupq_n_u8(opacity);
+        int i = 0;
+        for (; i + 16 <= count; i += 16) {
+            uint8_t* p = (uint8_t*)(dst + i);
+            uint8x16x4_t s = vld4q_u8((const uint8_t*)(src + i));
+            for (int c = 0; c < 4; c++) {
+                s.val[c] = mulLanes(s.val[c], o);
+            }
+            uint8x16x4_t d = vld4q_u8(p);
+            overPixels(s, d);
+            vst4q_u8(p, d);
+        }
+        Scalar::blendPixelsOpacity(dst + i, src + i, count - i, opacity);
+    }
+    
+    // Пустые куски маски (просветы между штрихами глифа) пропускаются
+    void blendMask(uint32_t* dst, const uint8_t* mask, int count, uint32_t color) {
+        uint8x16_t c[4];
+        c[0] = vdupq_n_u8(color & 0xFF);
+        c[1] = vdupq_n_u8((color >> 8) & 0xFF);
+        c[2] = vdupq_n_u8((color >> 16) & 0xFF);
+        c[3] = vdupq_n_u8(color >> 24);
+        
+        int i = 0;
+        for (; i + 16 <= count; i += 16) {
+            uint8x16_t m = vld1q_u8(mask + i);
+            if (vmaxvq_u8(m) == 0) continue;
+            
+            uint8x16x4_t s;
+            for (int k = 0; k < 4; k++) {
+                s.val[k] = mulLanes(c[k], m);
+            }
+            uint8_t* p = (uint8_t*)(dst + i);
+            uint8x16x4_t d = vld4q_u8(p);
+            overPixels(s, d);
+            vst4q_u8(p, d);
+        }
+        Scalar::blendMask(dst + i, mask + i, count - i, color);
+    }
+    
+    // Кэш-линия (16 пикселей) за итерацию: четыре 128-битные загрузки и записи
+    void copyPixels(uint32_t* dst, const uint32_t* src, int count) {
+        int i = 0;
+        for (; i + 16 <= count; i += 16) {
+            __builtin_prefetch(src + i + 64);
+            uint32x4_t a = vld1q_u32(src + i);
+            uint32x4_t b = vld1q_u32(src + i + 4);
+            uint32x4_t c = vld1q_u32(src + i + 8);
+            uint32x4_t d = vld1q_u32(src + i + 12);
+            vst1q_u32(dst + i, a);
+            vst1q_u32(dst + i + 4, b);
+            vst1q_u32(dst + i + 8, c);
+            vst1q_u32(dst + i + 12, d);
+        }
+        Scalar::copyPixels(dst + i, src + i, count - i);
+    }
+    
+    void sampleBilinear(uint32_t* dst, const uint32_t* src, int stride,
+                        int32_t u, int32_t v, int32_t du, int32_t dv, int count) {
+        int i = 0;
+        for (; i + 4 <= count; i += 4) {
+            uint8x8_t lo = bilinearPair(src, stride, u, v, du, dv);
+            uint8x8_t hi = bilinearPair(src, stride, u, v, du, dv);
+            vst1q_u32(dst + i, vreinterpretq_u32_u8(vcombine_u8(lo, hi)));
+        }
+        Scalar::sampleBilinear(dst + i, src, stride, u, v, du, dv, count - i);
+    }
+}
+
+#elif defined(BLEND_SSE2)
+
+// SSE2 для сборки на хосте: 8 пикселей за итерацию, каналы в 16-битных лапах
+namespace {
+
+    // x * y / 255 с точным округлением в 16-битных лапах
+    inline __m128i mulWide(__m128i x, __m128i y) {
+        __m128i t = _mm_add_epi16(_mm_mullo_epi16(x, y), _mm_set1_epi16(128));
+        return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+    }
+    
+    // Наложение двух пикселей, развернутых в лапы (a, b, g, r, a, b, g, r)
+    inline __m128i overWide(__m128i s, __m128i d) {
+        __m128i a = _mm_shufflelo_epi16(s, _MM_SHUFFLE(0, 0, 0, 0));
+        a = _mm_shufflehi_epi16(a, _MM_SHUFFLE(0, 0, 0, 0));
+        __m128i ia = _mm_xor_si128(a, _mm_set1_epi16(0xFF));
+        return _mm_add_epi16(s, mulWide(d, ia));
+    }
+    
+    // Четыре пикселя; packus насыщает сумму до 255, как и скалярный вариант
+    inline __m128i overQuad(__m128i s, __m128i d) {
+        const __m128i zero = _mm_setzero_si128();
+        __m128i lo = overWide(_mm_unpacklo_epi8(s, zero), _mm_unpacklo_epi8(d, zero));
+        __m128i hi = overWide(_mm_unpackhi_epi8(s, zero), _mm_unpackhi_epi8(d, zero));
+        return _mm_packus_epi16(lo, hi);
+    }
+    
+    inline __m128i scaleQuad(__m128i s, __m128i o) {
+        const __m128i zero = _mm_setzero_si128();
+        __m128i lo = mulWide(_mm_unpacklo_epi8(s, zero), o);
+        __m128i hi = mulWide(_mm_unpackhi_epi8(s, zero), o);
+        return _mm_packus_epi16(lo, hi);
+    }
+    
+    // (a * (256 - t) + b * t + 128) >> 8; сумма не больше 255 * 256 и
+    // помещается в беззнаковую 16-битную лапу
+    inline __m128i lerpWide(__m128i a, __m128i b, __m128i t) {
+        __m128i it = _mm_sub_epi16(_mm_set1_epi16(256), t);
+        __m128i s = _mm_add_epi16(_mm_mullo_epi16(a, it), _mm_mullo_epi16(b, t));
+        return _mm_srli_epi16(_mm_add_epi16(s, _mm_set1_epi16(128)), 8);
+    }
+    
+    // Вертикальная интерполяция пары соседей p[0], p[1] с парой строкой ниже
+    inline __m128i columnPair(const uint32_t* p, int stride, int32_t v) {
+        const __m128i zero = _mm_setzero_si128();
+        __m128i top = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)p), zero);
+        __m128i bottom = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(p + stride)), zero);
+        return lerpWide(top, bottom, _mm_set1_epi16((v >> 8) & 0xFF));
+    }
+    
+    // Две точки выборки: столбцы обеих пар, затем интерполяция между столбцами
+    inline __m128i bilinearPair(const uint32_t* src, int stride, int32_t& u, int32_t& v, int32_t du, int32_t dv) {
+        __m128i a = columnPair(src + (v >> 16) * stride + (u >> 16), stride, v);
+        __m128i fa = _mm_set1_epi16((u >> 8) & 0xFF);
+        u += du;
+        v += dv;
+        __m128i b = columnPair(src + (v >> 16) * stride + (u >> 16), stride, v);
+        __m128i fb = _mm_set1_epi16((u >> 8) & 0xFF);
+        u += du;
+        v += dv;
+        
+        __m128i left = _mm_unpacklo_epi64(a, b);
+        __m128i right = _mm_unpackhi_epi64(a, b);
+        return lerpWide(left, right, _mm_unpacklo_epi64(fa, fb));
+    }
+}
+
+namespace Blend {
+
+    void blendColor(uint32_t* dst, int count, uint32_t color) {
+        const __m128i s = _mm_set1_epi32((int)color);
+        
+        int i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m128i* p = (__m128i*)(dst + i);
+            _mm_storeu_si128(p, overQuad(s, _mm_loadu_si128(p)));
+            _mm_storeu_si128(p + 1, overQuad(s, _mm_loadu_si128(p + 1)));
+        }
+        Scalar::blendColor(dst + i, count - i, color);
+    }
+    
+    void blendPixels(uint32_t* dst, const uint32_t* src, int count) {
+        int i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m128i* p = (__m128i*)(dst + i);
+            const __m128i* q = (const __m128i*)(src + i);
+            _mm_storeu_si128(p, overQuad(_mm_loadu_si128(q), _mm_loadu_si128(p)));
+            _mm_storeu_si128(p + 1, overQuad(_mm_loadu_si128(q + 1), _mm_loadu_si128(p + 1)));
+        }
+        Scalar::blendPixels(dst + i, src + i, count - i);
+    }
+    
+    void blendPixelsOpacity(uint32_t* dst, const uint32_t* src, int count, uint32_t opacity) {
+        if (opacity >= 255) {
+            blendPixels(dst, src, count);
+            return;
+        }
+        
+        const __m128i o = _mm_set1_epi16((short)opacity);
+        int i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m128i* p = (__m128i*)(dst + i);
+            const __m128i* q = (const __m128i*)(src + i);
+            __m128i s0 = scaleQuad(_mm_loadu_si128(q), o);
+            __m128i s1 = scaleQuad(_mm_loadu_si128(q + 1), o);
+            _mm_storeu_si128(p, overQuad(s0, _mm_loadu_si128(p)));
+            _mm_storeu_si128(p + 1, overQuad(s1, _mm_loadu_si128(p + 1)));
+        }
+        Scalar::blendPixelsOpacity(dst + i, src + i, count - i, opacity);
+    }
+    
+    // Пустые куски маски (просветы между штрихами глифа) пропускаются
+    void blendMask(uint32_t* dst, const uint8_t* mask, int count, uint32_t color) {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i c = _mm_unpacklo_epi8(_mm_set1_epi32((int)color), zero);
+        
+        int i = 0;
+        for (; i + 4 <= count; i += 4) {
+            uint32_t m;
+            memcpy(&m, mask + i, sizeof(m));
+            if (m == 0) continue;
+            
+            // Покрытие каждого пикселя размножается на его четыре канала
+            __m128i w = _mm_cvtsi32_si128((int)m);
+            w = _mm_unpacklo_epi8(w, w);
+            w = _mm_unpacklo_epi16(w, w);
+            __m128i s = _mm_packus_epi16(mulWide(c, _mm_unpacklo_epi8(w, zero)),
+                                         mulWide(c, _mm_unpackhi_epi8(w, zero)));
+            __m128i* p = (__m128i*)(dst + i);
+            _mm_storeu_si128(p, overQuad(s, _mm_loadu_si128(p)));
+        }
+        Scalar::blendMask(dst + i, mask + i, count - i, color);
+    }
+    
+    // Невременные записи: кадр не возвращается в кэш, который нужен рендеру.
+    // Начало строки дописывается скалярно до выравнивания приемника на 16 байт.
+    void copyPixels(uint32_t* dst, const uint32_t* src, int count) {
+        int head = (int)((16 - ((uintptr_t)dst & 15)) & 15) / 4;
+        if ((uintptr_t)dst & 3 || head >= count) {
+            Scalar::copyPixels(dst, src, count);
+            return;
+        }
+        Scalar::copyPixels(dst, src, head);
+        
+        int i = head;
+        for (; i + 8 <= count; i += 8) {
+            __m128i* p = (__m128i*)(dst + i);
+            const __m128i* q = (const __m128i*)(src + i);
+            _mm_stream_si128(p, _mm_loadu_si128(q));
+            _mm_stream_si128(p + 1, _mm_loadu_si128(q + 1));
+        }
+        _mm_sfence();
+        Scalar::copyPixels(dst + i, src + i, count - i);
+    }
+    
+    void sampleBilinear(uint32_t* dst, const uint32_t* src, int stride,
+                        int32_t u, int32_t v, int32_t du, int32_t dv, int count) {
+        int i = 0;
+        for (; i + 4 <= count; i += 4) {
+            __m128i lo = bilinearPair(src, stride, u, v, du, dv);
+            __m128i hi = bilinearPair(src, stride, u, v, du, dv);
+            _mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(lo, hi));
+        }
+        Scalar::sampleBilinear(dst + i, src, stride, u, v, du, dv, count - i);
+    }
+}
+
+#else
+
+namespace Blend {
+
+    void blendColor(uint32_t* dst, int count, uint32_t color) {
+        Scalar::blendColor(dst, count, color);
+    }
+    
+    void blendPixels(uint32_t* dst, const uint32_t* src, int count) {
+        Scalar::blendPixels(dst, src, count);
+    }
+    
+    void blendPixelsOpacity(uint32_t* dst, const uint32_t* src, int count, uint32_t opacity) {
+        Scalar::blendPixelsOpacity(dst, src, count, opacity);
+    }
+    
+    void blendMask(uint32_t* dst, const uint8_t* mask, int count, uint32_t color) {
+        Scalar::blendMask(dst, mask, count, color);
+    }
+    
+    void copyPixels(uint32_t* dst, const uint32_t* src, int count) {
+        Scalar::copyPixels(dst, src, count);
+    }
+    
+    void sampleBilinear(uint32_t* dst, const uint32_t* src, int stride,
+                        int32_t u, int32_t v, int32_t du, int32_t dv, int count) {
+        Scalar::sampleBilinear(dst, src, stride, u, v, du, dv, count);
+    }
+}
+
+#endif
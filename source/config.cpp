@@ -1,6 +1,6 @@
 #include "config.h"
 #include "neovia.h"
-#include <switch.h>
+#include "platform.h"
 #include <fstream>
 // #include <json/json.h> // Убрано для упрощения
 
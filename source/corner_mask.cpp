@@ -0,0 +1,117 @@
+#include "corner_mask.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+    // Площадь под дугой y = sqrt(R^2 - x^2) на отрезке [0, x]
+    double arcIntegral(double x, double R) {
+        double s = sqrt(std::max(0.0, R * R - x * x));
+        return 0.5 * (x * s + R * R * asin(std::min(1.0, x / R)));
+    }
+    
+    // Площадь части круга над прямой y на полосе [x0, x1] (x0, y >= 0)
+    double areaAbove(double x0, double x1, double y, double R) {
+        if (y >= R) return 0.0;
+        double xm = std::min(x1, sqrt(R * R - y * y));
+        if (xm <= x0) return 0.0;
+        return arcIntegral(xm, R) - arcIntegral(x0, R) - y * (xm - x0);
+    }
+    
+    // Точная площадь пересечения круга с пикселем [i, i + 1] x [j, j + 1]
+    double pixelCoverage(int i, int j, double R) {
+        return areaAbove(i, i + 1, j, R) - areaAbove(i, i + 1, j + 1, R);
+    }
+}
+
+CornerMaskCache::CornerMaskCache() : clock(0) {
+    for (int i = 0; i <= DIRECT_RADIUS; i++) {
+        direct[i].store(nullptr, std::memory_order_relaxed);
+    }
+    for (int i = 0; i < MAX_ENTRIES; i++) {
+        entries[i].lastUse = 0;
+    }
+}
+
+// Локальная статическая переменная создается ровно один раз даже при первом
+// обращении сразу из нескольких потоков рендера
+CornerMaskCache* CornerMaskCache::getInstance() {
+    static CornerMaskCache cache;
+    return &cache;
+}
+
+const CornerMask* CornerMaskCache::get(int radius, std::shared_ptr<const CornerMask>& holder) {
+    if (radius <= DIRECT_RADIUS) {
+        const CornerMask* mask = direct[radius].load(std::memory_order_acquire);
+        return mask ? mask : getDirect(radius);
+    }
+    holder = getShared(radius);
+    return holder.get();
+}
+
+// Первое обращение к малому радиусу: маска строится под мьютексом один раз
+const CornerMask* CornerMaskCache::getDirect(int radius) {
+    std::lock_guard<std::mutex> lock(mutex);
+    
+    if (!directMasks[radius]) {
+        directMasks[radius] = build(radius);
+        direct[radius].store(directMasks[radius].get(), std::memory_order_release);
+    }
+    return directMasks[radius].get();
+}
+
+std::shared_ptr<const CornerMask> CornerMaskCache::getShared(int radius) {
+    std::lock_guard<std::mutex> lock(mutex);
+    
+    Entry* victim = &entries[0];
+    for (int i = 0; i < MAX_ENTRIES; i++) {
+        Entry& entry = entries[i];
+        if (entry.mask && entry.mask->radius == radius) {
+            entry.lastUse = ++clock;
+            return entry.mask;
+        }
+        if (!entry.mask || (victim->mask && entry.lastUse < victim->lastUse)) {
+            victim = &entry;
+        }
+    }
+    
+    victim->mask = build(radius);
+    victim->lastUse = ++clock;
+    return victim->mask;
+}
+
+std::shared_ptr<const CornerMask> CornerMaskCache::build(int radius) {
+    std::shared_ptr<CornerMask> mask = std::make_shared<CornerMask>();
+    int n = radius;
+    double R = radius;
+    
+    mask->radius = radius;
+    mask->coverage.resize(2 * n * n);
+    mask->solid.resize(n);
+    mask->extent.resize(n);
+    
+    for (int j = 0; j < n; j++) {
+        uint8_t* row = mask->coverage.data() + (2 * j + 1) * n;
+        int solid = 0, extent = 0;
+        for (int i = 0; i < n; i++) {
+            row[i] = (uint8_t)std::min(255.0, pixelCoverage(i, j, R) * 255 + 0.5);
+            if (row[i] == 255 && solid == i) solid = i + 1;
+            if (row[i] > 0) extent = i + 1;
+        }
+        std::reverse_copy(row, row + n, row - n);
+        mask->solid[j] = (uint16_t)solid;
+        mask->extent[j] = (uint16_t)extent;
+    }
+    
+    if (n <= CornerMask::DISC_RADIUS) {
+        mask->discRow.resize(2 * n + 1);
+        for (int j = 0; j < 2 * n; j++) {
+            int row = n - 1 - std::min(j, 2 * n - 1 - j);
+            const uint8_t* span = mask->mirroredRow(row) + (n - mask->extent[row]);
+            mask->discRow[j] = (uint16_t)mask->disc.size();
+            mask->disc.insert(mask->disc.end(), span, span + 2 * mask->extent[row]);
+        }
+        mask->discRow[2 * n] = (uint16_t)mask->disc.size();
+    }
+    return mask;
+}
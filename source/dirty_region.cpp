@@ -0,0 +1,92 @@
+#include "dirty_region.h"
+#include <algorithm>
+
+namespace {
+
+    DirtyRect unite(const DirtyRect& a, const DirtyRect& b) {
+        return { std::min(a.x0, b.x0), std::min(a.y0, b.y0),
+                 std::max(a.x1, b.x1), std::max(a.y1, b.y1) };
+    }
+    
+    // Пересечение или общая граница
+    bool touches(const DirtyRect& a, const DirtyRect& b) {
+        return a.x0 <= b.x1 && b.x0 <= a.x1 && a.y0 <= b.y1 && b.y0 <= a.y1;
+    }
+}
+
+DirtyRegion::DirtyRegion(int w, int h) : count(0), width(w), height(h) {
+}
+
+void DirtyRegion::setBounds(int w, int h) {
+    width = w;
+    height = h;
+}
+
+void DirtyRegion::add(int x, int y, int w, int h) {
+    add(DirtyRect{ x, y, x + w, y + h });
+}
+
+void DirtyRegion::add(const DirtyRect& rect) {
+    DirtyRect clipped = { std::max(rect.x0, 0), std::max(rect.y0, 0),
+                          std::min(rect.x1, width), std::min(rect.y1, height) };
+    if (clipped.empty()) return;
+    
+    rects[count++] = clipped;
+    mergeAt(count - 1);
+    
+    if (count > MAX_RECTS) {
+        // Сливаем пару, объединение которой добавляет меньше всего лишних пикселей
+        int bestI = 0, bestJ = 1;
+        int bestCost = -1;
+        for (int i = 0; i < count; i++) {
+            for (int j = i + 1; j < count; j++) {
+                int cost = unite(rects[i], rects[j]).area() - rects[i].area() - rects[j].area();
+                if (bestCost < 0 || cost < bestCost) {
+                    bestCost = cost;
+                    bestI = i;
+                    bestJ = j;
+                }
+            }
+        }
+        rects[bestI] = unite(rects[bestI], rects[bestJ]);
+        rects[bestJ] = rects[--count];
+        mergeAt(bestI < count ? bestI : count - 1);
+    }
+}
+
+void DirtyRegion::add(const DirtyRegion& other) {
+    for (int i = 0; i < other.count; i++) {
+        add(other.rects[i]);
+    }
+}
+
+void DirtyRegion::addAll() {
+    rects[0] = { 0, 0, width, height };
+    count = 1;
+}
+
+int DirtyRegion::area() const {
+    int total = 0;
+    for (int i = 0; i < count; i++) {
+        total += rects[i].area();
+    }
+    return total;
+}
+
+// Слияние прямоугольника index со всеми, которых он касается.
+// После слияния он может задеть новые, поэтому повторяем до устойчивости.
+void DirtyRegion::mergeAt(int index) {
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (int i = 0; i < count; i++) {
+            if (i == index || !touches(rects[i], rects[index])) continue;
+            
+            rects[index] = unite(rects[index], rects[i]);
+            rects[i] = rects[--count];
+            if (index == count) index = i;
+            merged = true;
+            break;
+        }
+    }
+}
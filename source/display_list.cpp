@@ -0,0 +1,292 @@
+#include "display_list.h"
+#include "text_layout.h"
+#include <algorithm>
+
+DisplayList::DisplayList() : width(0), height(0), tilesX(0), tilesY(0) {
+}
+
+void DisplayList::reset(int w, int h) {
+    width = w;
+    height = h;
+    tilesX = (w + TILE_SIZE - 1) / TILE_SIZE;
+    tilesY = (h + TILE_SIZE - 1) / TILE_SIZE;
+    bins.resize(tilesX * tilesY);
+    
+    commands.clear();
+    pixelPool.clear();
+    surfaces.clear();
+    images.clear();
+    layouts.clear();
+    fieldGlyphs.clear();
+}
+
+void DisplayList::add(const DrawCommand& cmd, int x0, int y0, int x1, int y1) {
+    x0 = std::max(x0, 0);
+    y0 = std::max(y0, 0);
+    x1 = std::min(x1, width);
+    y1 = std::min(y1, height);
+    if (x0 >= x1 || y0 >= y1) return;
+    
+    commands.push_back(cmd);
+    DrawCommand& stored = commands.back();
+    stored.x0 = (int16_t)x0;
+    stored.y0 = (int16_t)y0;
+    stored.x1 = (int16_t)x1;
+    stored.y1 = (int16_t)y1;
+}
+
+int32_t DisplayList::storePixels(const uint32_t* pixels, int count) {
+    int32_t offset = (int32_t)pixelPool.size();
+    pixelPool.insert(pixelPool.end(), pixels, pixels + count);
+    return offset;
+}
+
+int32_t DisplayList::storeSurface(const Surface* surface, int sx, int sy, int sw, int sh) {
+    surfaces.push_back({ surface, sx, sy, sw, sh });
+    return (int32_t)surfaces.size() - 1;
+}
+
+int32_t DisplayList::storeImage(const uint32_t* pixels, int stride, int w, int h, const Raster::AffineMap& map) {
+    images.push_back({ pixels, stride, w, h, map });
+    return (int32_t)images.size() - 1;
+}
+
+int32_t DisplayList::storeLayout(const TextLayout* layout) {
+    layouts.push_back(layout);
+    return (int32_t)layouts.size() - 1;
+}
+
+int32_t DisplayList::storeFieldGlyphs(const Raster::FieldGlyph* glyphs, int count) {
+    int32_t offset = (int32_t)fieldGlyphs.size();
+    fieldGlyphs.insert(fieldGlyphs.end(), glyphs, glyphs + count);
+    return offset;
+}
+
+int32_t DisplayList::storeCircles(const Raster::Fixed* cx, const Raster::Fixed* cy, const int32_t* radius,
+                                  const uint32_t* pixels, int count) {
+    int32_t offset = (int32_t)pixelPool.size();
+    pixelPool.insert(pixelPool.end(), (const uint32_t*)cx, (const uint32_t*)cx + count);
+    pixelPool.insert(pixelPool.end(), (const uint32_t*)cy, (const uint32_t*)cy + count);
+    pixelPool.insert(pixelPool.end(), (const uint32_t*)radius, (const uint32_t*)radius + count);
+    pixelPool.insert(pixelPool.end(), pixels, pixels + count);
+    
+    // Тайлы, которые задевает круг i, как в bin()
+    auto tileRange = [&](int i, int& tx0, int& ty0, int& tx1, int& ty1) {
+        Raster::Fixed r = Raster::toFixed(radius[i]);
+        int x0 = std::max(Raster::fixedFloor(cx[i] - r), 0), x1 = std::min(Raster::fixedCeil(cx[i] + r), width);
+        int y0 = std::max(Raster::fixedFloor(cy[i] - r), 0), y1 = std::min(Raster::fixedCeil(cy[i] + r), height);
+        if (x0 >= x1 || y0 >= y1) return false;
+        tx0 = x0 / TILE_SIZE;
+        tx1 = (x1 - 1) / TILE_SIZE;
+        ty0 = y0 / TILE_SIZE;
+        ty1 = (y1 - 1) / TILE_SIZE;
+        return true;
+    };
+    
+    // Списки по тайлам подряд: начала tilesX * tilesY + 1 списков, затем индексы кругов
+    int tiles = tilesX * tilesY;
+    size_t starts = pixelPool.size();
+    pixelPool.resize(starts + tiles + 1, 0);
+    int tx0, ty0, tx1, ty1;
+    for (int i = 0; i < count; i++) {
+        if (!tileRange(i, tx0, ty0, tx1, ty1)) continue;
+        for (int ty = ty0; ty <= ty1; ty++) {
+            for (int tx = tx0; tx <= tx1; tx++) {
+                pixelPool[starts + ty * tilesX + tx + 1]++;
+            }
+        }
+    }
+    for (int t = 0; t < tiles; t++) {
+        pixelPool[starts + t + 1] += pixelPool[starts + t];
+    }
+    
+    size_t indices = pixelPool.size();
+    pixelPool.resize(indices + pixelPool[starts + tiles]);
+    tileCursor.assign(pixelPool.begin() + starts, pixelPool.begin() + starts + tiles);
+    for (int i = 0; i < count; i++) {
+        if (!tileRange(i, tx0, ty0, tx1, ty1)) continue;
+        for (int ty = ty0; ty <= ty1; ty++) {
+            for (int tx = tx0; tx <= tx1; tx++) {
+                pixelPool[indices + tileCursor[ty * tilesX + tx]++] = (uint32_t)i;
+            }
+        }
+    }
+    return offset;
+}
+
+template<class F>
+void DisplayList::render(const Raster::BasicTarget<F>& target, WorkerPool* workers) {
+    if (!target.valid()) return;
+    
+    bin();
+    if (workers && workers->getThreadCount() > 1) {
+        workers->run(tilesX * tilesY, [&](int index, int worker) {
+            renderTile(index % tilesX, index / tilesX, target, tileBuffers[worker]);
+        });
+    } else {
+        for (int ty = 0; ty < tilesY; ty++) {
+            for (int tx = 0; tx < tilesX; tx++) {
+                renderTile(tx, ty, target, tileBuffers[0]);
+            }
+        }
+    }
+    
+    commands.clear();
+    pixelPool.clear();
+    surfaces.clear();
+    images.clear();
+    layouts.clear();
+    fieldGlyphs.clear();
+}
+
+// Раскладка команд по тайлам, которые пересекает их прямоугольник
+void DisplayList::bin() {
+    for (auto& tileBin : bins) {
+        tileBin.clear();
+    }
+    
+    for (size_t i = 0; i < commands.size(); i++) {
+        const DrawCommand& cmd = commands[i];
+        int tx0 = cmd.x0 / TILE_SIZE, tx1 = (cmd.x1 - 1) / TILE_SIZE;
+        int ty0 = cmd.y0 / TILE_SIZE, ty1 = (cmd.y1 - 1) / TILE_SIZE;
+        
+        for (int ty = ty0; ty <= ty1; ty++) {
+            for (int tx = tx0; tx <= tx1; tx++) {
+                bins[ty * tilesX + tx].push_back((uint32_t)i);
+            }
+        }
+    }
+}
+
+// Непрозрачная заливка, полностью закрывающая тайл: все, что под ней, можно не рисовать
+bool DisplayList::coversTile(const DrawCommand& cmd, int x0, int y0, int x1, int y1) const {
+    if (cmd.x0 > x0 || cmd.y0 > y0 || cmd.x1 < x1 || cmd.y1 < y1) return false;
+    
+    switch (cmd.type) {
+        case DrawCommand::RECT:
+            // Тайл должен лежать в полностью закрытых пикселях, без дробных краев
+            return (cmd.color & 0xFF) == 255 &&
+                   Raster::fixedCeil(cmd.p[0]) <= x0 && Raster::fixedCeil(cmd.p[1]) <= y0 &&
+                   Raster::fixedFloor(cmd.p[0] + cmd.p[2]) >= x1 && Raster::fixedFloor(cmd.p[1] + cmd.p[3]) >= y1;
+        case DrawCommand::GRADIENT:
+            return cmd.startColor.a == 255 && cmd.endColor.a == 255;
+        case DrawCommand::BLIT:
+            return cmd.color == 255 && surfaces[cmd.p[2]].surface->isOpaque();
+        default:
+            return false;
+    }
+}
+
+template<class F>
+void DisplayList::renderTile(int tx, int ty, const Raster::BasicTarget<F>& buffer, uint32_t* tileBuffer) {
+    const std::vector<uint32_t>& tileBin = bins[ty * tilesX + tx];
+    if (tileBin.empty()) return;
+    
+    int x0 = tx * TILE_SIZE, y0 = ty * TILE_SIZE;
+    int x1 = std::min(x0 + TILE_SIZE, width);
+    int y1 = std::min(y0 + TILE_SIZE, height);
+    int count = x1 - x0;
+    
+    // Начинаем с последней команды, закрывающей тайл целиком
+    size_t first = tileBin.size();
+    while (first > 0 && !coversTile(commands[tileBin[first - 1]], x0, y0, x1, y1)) {
+        first--;
+    }
+    if (first > 0) {
+        first--;
+    } else {
+        // Перекрывающей команды нет - нужен текущий фон тайла
+        for (int y = y0; y < y1; y++) {
+            F::load(tileBuffer + (y - y0) * TILE_SIZE, buffer.row(y) + x0, count);
+        }
+    }
+    
+    Raster::Target target(tileBuffer, TILE_SIZE, x0, y0, x1, y1);
+    // Команда рисуется только внутри своего прямоугольника: он уже обрезан
+    // по отсечению, действовавшему при записи
+    for (size_t i = first; i < tileBin.size(); i++) {
+        const DrawCommand& cmd = commands[tileBin[i]];
+        execute(target.clip(cmd.x0, cmd.y0, cmd.x1, cmd.y1), cmd);
+    }
+    
+    for (int y = y0; y < y1; y++) {
+        F::copy(buffer.row(y) + x0, tileBuffer + (y - y0) * TILE_SIZE, count);
+    }
+}
+
+void DisplayList::execute(const Raster::Target& target, const DrawCommand& cmd) const {
+    const int32_t* p = cmd.p;
+    
+    switch (cmd.type) {
+        case DrawCommand::PIXEL:
+            Raster::plot(target, p[0], p[1], cmd.color);
+            break;
+        case DrawCommand::LINE:
+            Raster::drawLine(target, p[0], p[1], p[2], p[3], cmd.color, p[4] / 256.0f);
+            break;
+        case DrawCommand::RECT:
+            Raster::fillRectFixed(target, p[0], p[1], p[2], p[3], cmd.color);
+            break;
+        case DrawCommand::ROUNDED_RECT:
+            Raster::fillRoundedRect(target, p[0], p[1], p[2], p[3], p[4], cmd.color);
+            break;
+        case DrawCommand::CIRCLE:
+            Raster::fillCircle(target, p[0], p[1], p[2], cmd.color);
+            break;
+        case DrawCommand::GRADIENT:
+            Raster::fillGradient(target, p[0], p[1], p[2], p[3], cmd.startColor, cmd.endColor, cmd.vertical, cmd.dither);
+            break;
+        case DrawCommand::POLYGON:
+            Raster::fillPolygon(target, (const int32_t*)pixelPool.data() + p[1], p[0], cmd.color, p[2] != 0);
+            break;
+        case DrawCommand::RADIAL_GRADIENT:
+            Raster::fillRadialGradient(target, p[0], p[1], p[2], cmd.startColor, cmd.endColor, cmd.dither);
+            break;
+        case DrawCommand::IMAGE_SPAN:
+            Raster::blendSpan(target, p[0], p[1], pixelPool.data() + p[3], p[2], cmd.color);
+            break;
+        case DrawCommand::BLIT: {
+            const SurfaceRef& ref = surfaces[p[2]];
+            const Surface* surface = ref.surface;
+            Raster::tile(target, surface->row(ref.sy) + ref.sx, surface->getStride(), ref.sw, ref.sh,
+                         p[0], p[1], p[3], p[4], cmd.color, surface->isOpaque());
+            break;
+        }
+        case DrawCommand::IMAGE_AFFINE: {
+            const ImageRef& ref = images[p[0]];
+            Raster::blitAffine(target, ref.pixels, ref.stride, ref.width, ref.height, ref.map, cmd.color, p[1] != 0);
+            break;
+        }
+        case DrawCommand::TEXT:
+            layouts[p[2]]->draw(target, p[0], p[1], cmd.color);
+            break;
+        case DrawCommand::TEXT_FIELD:
+            Raster::fillDistanceField(target, fieldGlyphs.data() + p[0], p[1], p[3], pixelPool.data() + p[2]);
+            break;
+        case DrawCommand::CIRCLES: {
+            if (!target.valid()) break;
+            
+            // Список тайла, в котором лежит цель (storeCircles)
+            int count = p[1];
+            const int32_t* cx = (const int32_t*)pixelPool.data() + p[0];
+            const int32_t* cy = cx + count;
+            const int32_t* radius = cy + count;
+            const uint32_t* pixels = (const uint32_t*)(radius + count);
+            const uint32_t* starts = pixels + count;
+            const uint32_t* indices = starts + tilesX * tilesY + 1;
+            int tile = (target.y0 / TILE_SIZE) * tilesX + target.x0 / TILE_SIZE;
+            
+            for (uint32_t k = starts[tile]; k < starts[tile + 1]; k++) {
+                uint32_t i = indices[k];
+                Raster::fillCircle(target, cx[i], cy[i], radius[i], pixels[i]);
+            }
+            break;
+        }
+    }
+}
+
+#define INSTANTIATE(F) \
+    template void DisplayList::render(const Raster::BasicTarget<F>&, WorkerPool*);
+
+PIXEL_FORMATS(INSTANTIATE)
+#undef INSTANTIATE
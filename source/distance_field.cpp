@@ -0,0 +1,98 @@
+#include "rasterizer.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+    // Строка обрабатывается кусками такой длины
+    const int CHUNK = 256;
+    
+    // Деление с округлением вверх на положительное d
+    int64_t ceilDiv(int64_t a, int64_t d) {
+        return a >= 0 ? (a + d - 1) / d : -((-a) / d);
+    }
+    
+    // Положение глифа в текселях как линейная функция координаты пикселя:
+    // центр пикселя p попадает в t = origin + p * step (16.16, целые t -
+    // центры текселей). Функция не зависит от цели, поэтому тайлы
+    // отложенного рендера дают те же выборки.
+    struct Axis {
+        int64_t origin;
+        int64_t step;
+        
+        Axis(int32_t position, int32_t texelSize) {
+            step = ((int64_t)1 << 32) / texelSize;
+            origin = ((int64_t)0x8000 - position) * 65536 / texelSize - 0x8000;
+        }
+        
+        int64_t at(int p) const { return origin + p * step; }
+        
+        // Пиксели [first, last), для которых 0 <= t < limit текселей
+        void range(int limit, int& first, int& last) const {
+            first = (int)ceilDiv(-origin, step);
+            last = (int)ceilDiv(((int64_t)limit << 16) - origin, step);
+        }
+    };
+}
+
+namespace Raster {
+
+    template<class F>
+    void fillDistanceField(const BasicTarget<F>& target, const FieldGlyph* glyphs, int count,
+                           int32_t texelSize, const uint32_t* lut) {
+        if (count <= 0 || texelSize <= 0 || !target.valid()) return;
+        
+        uint16_t field[CHUNK];
+        uint32_t buffer[CHUNK];
+        
+        for (int py = target.y0; py < target.y1; py++) {
+            typename F::Pixel* dst = target.row(py);
+            
+            for (int cx0 = target.x0; cx0 < target.x1; cx0 += CHUNK) {
+                int cx1 = std::min(target.x1, cx0 + CHUNK);
+                memset(field, 0, sizeof(field));
+                
+                for (int i = 0; i < count; i++) {
+                    const FieldGlyph& g = glyphs[i];
+                    
+                    // Крайние тексели поля далеко снаружи, поэтому выборки
+                    // берутся только между центрами текселей
+                    int64_t v = Axis(g.y, texelSize).at(py);
+                    if (v < 0 || v >= (int64_t)(g.height - 1) << 16) continue;
+                    
+                    Axis u(g.x, texelSize);
+                    int first, last;
+                    u.range(g.width - 1, first, last);
+                    first = std::max(first, cx0);
+                    last = std::min(last, cx1);
+                    if (first >= last) continue;
+                    
+                    const uint8_t* row0 = g.texels + (int)(v >> 16) * g.width;
+                    const uint8_t* row1 = row0 + g.width;
+                    int fy = (int)(v >> 8) & 0xFF;
+                    int64_t t = u.at(first);
+                    for (int px = first; px < last; px++, t += u.step) {
+                        int tx = (int)(t >> 16);
+                        int fx = (int)(t >> 8) & 0xFF;
+                        int top = row0[tx] * 256 + (row0[tx + 1] - row0[tx]) * fx;
+                        int bottom = row1[tx] * 256 + (row1[tx + 1] - row1[tx]) * fx;
+                        int value = (top * 256 + (bottom - top) * fy) >> 14;
+                        uint16_t& slot = field[px - cx0];
+                        if (value > slot) slot = (uint16_t)value;
+                    }
+                }
+                
+                for (int px = cx0; px < cx1; px++) {
+                    buffer[px - cx0] = lut[field[px - cx0]];
+                }
+                F::blend(dst + cx0, buffer, cx1 - cx0, 255);
+            }
+        }
+    }
+
+#define INSTANTIATE(F) \
+    template void fillDistanceField(const BasicTarget<F>&, const FieldGlyph*, int, int32_t, const uint32_t*);
+    
+    PIXEL_FORMATS(INSTANTIATE)
+#undef INSTANTIATE
+}
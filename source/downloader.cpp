@@ -4,7 +4,7 @@
 #include "neocore.h"
 // #include <curl/curl.h> // Убрано - может отсутствовать в devkitPro
 // #include <json/json.h> // Убрано для упрощения
-#include <switch.h>
+#include "platform.h"
 #include <string>
 #include <fstream>
 #include <sstream>
@@ -85,15 +85,15 @@ Result downloadModsForGame(const std::string& titleId) {
     
     // Создаем папку для игры
     std::string gamePath = std::string(GRAPHICS_PATH) + titleId + "/";
-    rc = fsFsCreateDirectory(fsdevGetDeviceFileSystem("sdmc"), gamePath.c_str());
-    if (R_FAILED(rc) && rc != 0x402) { // 0x402 = уже существует
+    rc = PLATFORM->createDirectory(gamePath);
+    if (R_FAILED(rc)) {
         return rc;
     }
     
     // Создаем папку downloaded
     std::string downloadPath = gamePath + "downloaded/";
-    rc = fsFsCreateDirectory(fsdevGetDeviceFileSystem("sdmc"), downloadPath.c_str());
-    if (R_FAILED(rc) && rc != 0x402) {
+    rc = PLATFORM->createDirectory(downloadPath);
+    if (R_FAILED(rc)) {
         return rc;
     }
     
@@ -150,7 +150,7 @@ Result createGraphicsEnhancementFiles(const std::string& titleId, const std::str
     
     // Создаем файл шейдеров в папке graphics
     std::string shaderPath = "/graphics/shaders/";
-    fsFsCreateDirectory(fsdevGetDeviceFileSystem("sdmc"), shaderPath.c_str());
+    PLATFORM->createDirectory(shaderPath);
     
     std::string shaderConfigPath = shaderPath + titleId + "_shader_config.txt";
     std::ofstream shaderFile(shaderConfigPath);
@@ -173,7 +173,7 @@ Result createGraphicsEnhancementFiles(const std::string& titleId, const std::str
     
     // Создаем файл текстур в папке graphics
     std::string texturePath = "/graphics/textures/";
-    fsFsCreateDirectory(fsdevGetDeviceFileSystem("sdmc"), texturePath.c_str());
+    PLATFORM->createDirectory(texturePath);
     
     std::string textureConfigPath = texturePath + titleId + "_texture_config.txt";
     std::ofstream textureFile(textureConfigPath);
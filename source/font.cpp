@@ -0,0 +1,544 @@
+#include "font.h"
+#include "utf8.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+    // Мастер-глифы 5 x 11: строки 0-1 - место под диакритику прописных,
+    // 2-8 - прописные и верхние выносные, 9-10 - нижние выносные.
+    // Бит 4 строки - левый столбец.
+    const int MASTER_WIDTH = 5;
+    const int MASTER_ROWS = 11;
+    const int EM_ROWS = 12;         // Высота строки; последняя строка - межстрочный просвет
+    const int BASELINE_ROW = 9;
+    const int SPACE_COLUMNS = 3;
+    const int UPSCALE = 4;          // Клеток увеличенной сетки на клетку мастера
+    static_assert(DistanceFont::TEXELS_PER_CELL == UPSCALE, "distance field texels follow the upscaled grid");
+    
+    struct MasterGlyph {
+        uint16_t code;
+        uint8_t rows[MASTER_ROWS];
+    };
+    
+    constexpr MasterGlyph GLYPHS[] = {
+        { 0x0020, { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 } }, // ' '
+        { 0x0021, { 0x00, 0x00, 0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x04, 0x00, 0x00 } }, // '!'
+        { 0x0022, { 0x00, 0x00, 0x0A, 0x0A, 0x0A, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 } }, // '"'
+        { 0x0023, { 0x00, 0x00, 0x0A, 0x0A, 0x1F, 0x0A, 0x1F, 0x0A, 0x0A, 0x00, 0x00 } }, // '#'
+        { 0x0024, { 0x00, 0x00, 0x04, 0x0F, 0x14, 0x0E, 0x05, 0x1E, 0x04, 0x00, 0x00 } }, // '$'
+        { 0x0025, { 0x00, 0x00, 0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03, 0x00, 0x00 } }, // '%'
+        { 0x0026, { 0x00, 0x00, 0x0C, 0x12, 0x14, 0x08, 0x15, 0x12, 0x0D, 0x00, 0x00 } }, // '&'
+        { 0x0027, { 0x00, 0x00, 0x04, 0x04, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 } }, // '\''
+        { 0x0028, { 0x00, 0x00, 0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02, 0x00, 0x00 } }, // '('
+        { 0x0029, { 0x00, 0x00, 0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08, 0x00, 0x00 } }, // ')'
+        { 0x002A, { 0x00, 0x00, 0x00, 0x04, 0x15, 0x0E, 0x15, 0x04, 0x00, 0x00, 0x00 } }, // '*'
+        { 0x002B, { 0x00, 0x00, 0x00, 0x04, 0x04, 0x1F, 0x04, 0x04, 0x00, 0x00, 0x00 } }, // '+'
+        { 0x002C, { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x04, 0x08 } }, // ','
+        { 0x002D, { 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00, 0x00, 0x00 } }, // '-'
+        { 0x002E, { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x00, 0x00 } }, // '.'
+        { 0x002F, { 0x00, 0x00, 0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00, 0x00, 0x00 } }, // '/'
+        { 0x0030, { 0x00, 0x00, 0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E, 0x00, 0x00 } }, // '0'
+        { 0x0031, { 0x00, 0x00, 0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E, 0x00, 0x00 } }, // '1'
+        { 0x0032, { 0x00, 0x00, 0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F, 0x00, 0x00 } }, // '2'
+        { 0x0033, { 0x00, 0x00, 0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E, 0x00, 0x00 } }, // '3'
+        { 0x0034, { 0x00, 0x00, 0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02, 0x00, 0x00 } }, // '4'
+        { 0x0035, { 0x00, 0x00, 0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E, 0x00, 0x00 } }, // '5'
+        { 0x0036, { 0x00, 0x00, 0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E, 0x00, 0x00 } }, // '6'
+        { 0x0037, { 0x00, 0x00, 0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08, 0x00, 0x00 } }, // '7'
+        { 0x0038, { 0x00, 0x00, 0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E, 0x00, 0x00 } }, // '8'
+        { 0x0039, { 0x00, 0x00, 0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C, 0x00, 0x00 } }, // '9'
+        { 0x003A, { 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00, 0x00, 0x00 } }, // ':'
+        { 0x003B, { 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x04, 0x08, 0x00 } }, // ';'
+        { 0x003C, { 0x00, 0x00, 0x02, 0x04, 0x08, 0x10, 0x08, 0x04, 0x02, 0x00, 0x00 } }, // '<'
+        { 0x003D, { 0x00, 0x00, 0x00, 0x00, 0x1F, 0x00, 0x1F, 0x00, 0x00, 0x00, 0x00 } }, // '='
+        { 0x003E, { 0x00, 0x00, 0x08, 0x04, 0x02, 0x01, 0x02, 0x04, 0x08, 0x00, 0x00 } }, // '>'
+        { 0x003F, { 0x00, 0x00, 0x0E, 0x11, 0x01, 0x02, 0x04, 0x00, 0x04, 0x00, 0x00 } }, // '?'
+        { 0x0040, { 0x00, 0x00, 0x0E, 0x11, 0x01, 0x0D, 0x15, 0x15, 0x0E, 0x00, 0x00 } }, // '@'
+        { 0x0041, { 0x00, 0x00, 0x0E, 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x00, 0x00 } }, // 'A'
+        { 0x0042, { 0x00, 0x00, 0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E, 0x00, 0x00 } }, // 'B'
+        { 0x0043, { 0x00, 0x00, 0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E, 0x00, 0x00 } }, // 'C'
+        { 0x0044, { 0x00, 0x00, 0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C, 0x00, 0x00 } }, // 'D'
+        { 0x0045, { 0x00, 0x00, 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F, 0x00, 0x00 } }, // 'E'
+        { 0x0046, { 0x00, 0x00, 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10, 0x00, 0x00 } }, // 'F'
+        { 0x0047, { 0x00, 0x00, 0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F, 0x00, 0x00 } }, // 'G'
+        { 0x0048, { 0x00, 0x00, 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11, 0x00, 0x00 } }, // 'H'
+        { 0x0049, { 0x00, 0x00, 0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E, 0x00, 0x00 } }, // 'I'
+        { 0x004A, { 0x00, 0x00, 0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C, 0x00, 0x00 } }, // 'J'
+        { 0x004B, { 0x00, 0x00, 0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11, 0x00, 0x00 } }, // 'K'
+        { 0x004C, { 0x00, 0x00, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F, 0x00, 0x00 } }, // 'L'
+        { 0x004D, { 0x00, 0x00, 0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11, 0x00, 0x00 } }, // 'M'
+        { 0x004E, { 0x00, 0x00, 0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11, 0x00, 0x00 } }, // 'N'
+        { 0x004F, { 0x00, 0x00, 0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E, 0x00, 0x00 } }, // 'O'
+        { 0x0050, { 0x00, 0x00, 0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10, 0x00, 0x00 } }, // 'P'
+        { 0x0051, { 0x00, 0x00, 0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D, 0x00, 0x00 } }, // 'Q'
+        { 0x0052, { 0x00, 0x00, 0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11, 0x00, 0x00 } }, // 'R'
+        { 0x0053, { 0x00, 0x00, 0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E, 0x00, 0x00 } }, // 'S'
+        { 0x0054, { 0x00, 0x00, 0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x00 } }, // 'T'
+        { 0x0055, { 0x00, 0x00, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E, 0x00, 0x00 } }, // 'U'
+        { 0x0056, { 0x00, 0x00, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04, 0x00, 0x00 } }, // 'V'
+        { 0x0057, { 0x00, 0x00, 0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A, 0x00, 0x00 } }, // 'W'
+        { 0x0058, { 0x00, 0x00, 0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11, 0x00, 0x00 } }, // 'X'
+        { 0x0059, { 0x00, 0x00, 0x11, 0x11, 0x11, 0x0A, 0x04, 0x04, 0x04, 0x00, 0x00 } }, // 'Y'
+        { 0x005A, { 0x00, 0x00, 0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F, 0x00, 0x00 } }, // 'Z'
+        { 0x005B, { 0x00, 0x00, 0x0E, 0x08, 0x08, 0x08, 0x08, 0x08, 0x0E, 0x00, 0x00 } }, // '['
+        { 0x005C, { 0x00, 0x00, 0x00, 0x10, 0x08, 0x04, 0x02, 0x01, 0x00, 0x00, 0x00 } }, // '\\'
+        { 0x005D, { 0x00, 0x00, 0x0E, 0x02, 0x02, 0x02, 0x02, 0x02, 0x0E, 0x00, 0x00 } }, // ']'
+        { 0x005E, { 0x00, 0x00, 0x04, 0x0A, 0x11, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 } }, // '^'
+        { 0x005F, { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F, 0x00, 0x00 } }, // '_'
+        { 0x0060, { 0x00, 0x00, 0x08, 0x04, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 } }, // '`'
+        { 0x0061, { 0x00, 0x00, 0x00, 0x00, 0x0E, 0x01, 0x0F, 0x11, 0x0F, 0x00, 0x00 } }, // 'a'
+        { 0x0062, { 0x00, 0x00, 0x10, 0x10, 0x16, 0x19, 0x11, 0x11, 0x1E, 0x00, 0x00 } }, // 'b'
+        { 0x0063, { 0x00, 0x00, 0x00, 0x00, 0x0E, 0x10, 0x10, 0x11, 0x0E, 0x00, 0x00 } }, // 'c'
+        { 0x0064, { 0x00, 0x00, 0x01, 0x01, 0x0D, 0x13, 0x11, 0x11, 0x0F, 0x00, 0x00 } }, // 'd'
+        { 0x0065, { 0x00, 0x00, 0x00, 0x00, 0x0E, 0x11, 0x1F, 0x10, 0x0E, 0x00, 0x00 } }, // 'e'
+        { 0x0066, { 0x00, 0x00, 0x06, 0x09, 0x08, 0x1C, 0x08, 0x08, 0x08, 0x00, 0x00 } }, // 'f'
+        { 0x0067, { 0x00, 0x00, 0x00, 0x00, 0x0F, 0x11, 0x11, 0x0F, 0x01, 0x11, 0x0E } }, // 'g'
+        { 0x0068, { 0x00, 0x00, 0x10, 0x10, 0x16, 0x19, 0x11, 0x11, 0x11, 0x00, 0x00 } }, // 'h'
+        { 0x0069, { 0x00, 0x00, 0x04, 0x00, 0x0C, 0x04, 0x04, 0x04, 0x0E, 0x00, 0x00 } }, // 'i'
+        { 0x006A, { 0x00, 0x00, 0x02, 0x00, 0x06, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C } }, // 'j'
+        { 0x006B, { 0x00, 0x00, 0x10, 0x10, 0x12, 0x14, 0x18, 0x14, 0x12, 0x00, 0x00 } }, // 'k'
+        { 0x006C, { 0x00, 0x00, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E, 0x00, 0x00 } }, // 'l'
+        { 0x006D, { 0x00, 0x00, 0x00, 0x00, 0x1A, 0x15, 0x15, 0x11, 0x11, 0x00, 0x00 } }, // 'm'
+        { 0x006E, { 0x00, 0x00, 0x00, 0x00, 0x16, 0x19, 0x11, 0x11, 0x11, 0x00, 0x00 } }, // 'n'
+        { 0x006F, { 0x00, 0x00, 0x00, 0x00, 0x0E, 0x11, 0x11, 0x11, 0x0E, 0x00, 0x00 } }, // 'o'
+        { 0x0070, { 0x00, 0x00, 0x00, 0x00, 0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10 } }, // 'p'
+        { 0x0071, { 0x00, 0x00, 0x00, 0x00, 0x0F, 0x11, 0x11, 0x0F, 0x01, 0x01, 0x01 } }, // 'q'
+        { 0x0072, { 0x00, 0x00, 0x00, 0x00, 0x16, 0x19, 0x10, 0x10, 0x10, 0x00, 0x00 } }, // 'r'
+        { 0x0073, { 0x00, 0x00, 0x00, 0x00, 0x0F, 0x10, 0x0E, 0x01, 0x1E, 0x00, 0x00 } }, // 's'
+        { 0x0074, { 0x00, 0x00, 0x08, 0x08, 0x1C, 0x08, 0x08, 0x09, 0x06, 0x00, 0x00 } }, // 't'
+        { 0x0075, { 0x00, 0x00, 0x00, 0x00, 0x11, 0x11, 0x11, 0x13, 0x0D, 0x00, 0x00 } }, // 'u'
+        { 0x0076, { 0x00, 0x00, 0x00, 0x00, 0x11, 0x11, 0x11, 0x0A, 0x04, 0x00, 0x00 } }, // 'v'
+        { 0x0077, { 0x00, 0x00, 0x00, 0x00, 0x11, 0x11, 0x15, 0x15, 0x0A, 0x00, 0x00 } }, // 'w'
+        { 0x0078, { 0x00, 0x00, 0x00, 0x00, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x00, 0x00 } }, // 'x'
+        { 0x0079, { 0x00, 0x00, 0x00, 0x00, 0x11, 0x11, 0x11, 0x0F, 0x01, 0x11, 0x0E } }, // 'y'
+        { 0x007A, { 0x00, 0x00, 0x00, 0x00, 0x1F, 0x02, 0x04, 0x08, 0x1F, 0x00, 0x00 } }, // 'z'
+        { 0x007B, { 0x00, 0x00, 0x02, 0x04, 0x04, 0x08, 0x04, 0x04, 0x02, 0x00, 0x00 } }, // '{'
+        { 0x007C, { 0x00, 0x00, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x00 } }, // '|'
+        { 0x007D, { 0x00, 0x00, 0x08, 0x04, 0x04, 0x02, 0x04, 0x04, 0x08, 0x00, 0x00 } }, // '}'
+        { 0x007E, { 0x00, 0x00, 0x00, 0x00, 0x08, 0x15, 0x02, 0x00, 0x00, 0x00, 0x00 } }, // '~'
+        
+        // Кириллица, украинские буквы и типографские знаки
+        { 0x0410, { 0x00, 0x00, 0x0E, 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x00, 0x00 } }, // 'А'
+        { 0x0411, { 0x00, 0x00, 0x1F, 0x10, 0x10, 0x1E, 0x11, 0x11, 0x1E, 0x00, 0x00 } }, // 'Б'
+        { 0x0412, { 0x00, 0x00, 0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E, 0x00, 0x00 } }, // 'В'
+        { 0x0413, { 0x00, 0x00, 0x1F, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x00, 0x00 } }, // 'Г'
+        { 0x0414, { 0x00, 0x00, 0x06, 0x0A, 0x0A, 0x0A, 0x0A, 0x11, 0x1F, 0x11, 0x00 } }, // 'Д'
+        { 0x0415, { 0x00, 0x00, 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F, 0x00, 0x00 } }, // 'Е'
+        { 0x0416, { 0x00, 0x00, 0x15, 0x15, 0x0E, 0x04, 0x0E, 0x15, 0x15, 0x00, 0x00 } }, // 'Ж'
+        { 0x0417, { 0x00, 0x00, 0x0E, 0x11, 0x01, 0x06, 0x01, 0x11, 0x0E, 0x00, 0x00 } }, // 'З'
+        { 0x0418, { 0x00, 0x00, 0x11, 0x11, 0x13, 0x15, 0x19, 0x11, 0x11, 0x00, 0x00 } }, // 'И'
+        { 0x0419, { 0x0A, 0x04, 0x11, 0x11, 0x13, 0x15, 0x19, 0x11, 0x11, 0x00, 0x00 } }, // 'Й'
+        { 0x041A, { 0x00, 0x00, 0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11, 0x00, 0x00 } }, // 'К'
+        { 0x041B, { 0x00, 0x00, 0x07, 0x09, 0x09, 0x09, 0x09, 0x09, 0x11, 0x00, 0x00 } }, // 'Л'
+        { 0x041C, { 0x00, 0x00, 0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11, 0x00, 0x00 } }, // 'М'
+        { 0x041D, { 0x00, 0x00, 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11, 0x00, 0x00 } }, // 'Н'
+        { 0x041E, { 0x00, 0x00, 0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E, 0x00, 0x00 } }, // 'О'
+        { 0x041F, { 0x00, 0x00, 0x1F, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x00, 0x00 } }, // 'П'
+        { 0x0420, { 0x00, 0x00, 0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10, 0x00, 0x00 } }, // 'Р'
+        { 0x0421, { 0x00, 0x00, 0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E, 0x00, 0x00 } }, // 'С'
+        { 0x0422, { 0x00, 0x00, 0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x00 } }, // 'Т'
+        { 0x0423, { 0x00, 0x00, 0x11, 0x11, 0x11, 0x0F, 0x01, 0x11, 0x0E, 0x00, 0x00 } }, // 'У'
+        { 0x0424, { 0x00, 0x00, 0x04, 0x0E, 0x15, 0x15, 0x15, 0x0E, 0x04, 0x00, 0x00 } }, // 'Ф'
+        { 0x0425, { 0x00, 0x00, 0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11, 0x00, 0x00 } }, // 'Х'
+        { 0x0426, { 0x00, 0x00, 0x12, 0x12, 0x12, 0x12, 0x12, 0x12, 0x1F, 0x01, 0x00 } }, // 'Ц'
+        { 0x0427, { 0x00, 0x00, 0x11, 0x11, 0x11, 0x0F, 0x01, 0x01, 0x01, 0x00, 0x00 } }, // 'Ч'
+        { 0x0428, { 0x00, 0x00, 0x15, 0x15, 0x15, 0x15, 0x15, 0x15, 0x1F, 0x00, 0x00 } }, // 'Ш'
+        { 0x0429, { 0x00, 0x00, 0x15, 0x15, 0x15, 0x15, 0x15, 0x15, 0x1F, 0x01, 0x00 } }, // 'Щ'
+        { 0x042A, { 0x00, 0x00, 0x18, 0x08, 0x08, 0x0E, 0x09, 0x09, 0x0E, 0x00, 0x00 } }, // 'Ъ'
+        { 0x042B, { 0x00, 0x00, 0x11, 0x11, 0x11, 0x19, 0x15, 0x15, 0x19, 0x00, 0x00 } }, // 'Ы'
+        { 0x042C, { 0x00, 0x00, 0x10, 0x10, 0x10, 0x1E, 0x11, 0x11, 0x1E, 0x00, 0x00 } }, // 'Ь'
+        { 0x042D, { 0x00, 0x00, 0x0E, 0x11, 0x01, 0x0E, 0x01, 0x11, 0x0E, 0x00, 0x00 } }, // 'Э'
+        { 0x042E, { 0x00, 0x00, 0x12, 0x15, 0x15, 0x1D, 0x15, 0x15, 0x12, 0x00, 0x00 } }, // 'Ю'
+        { 0x042F, { 0x00, 0x00, 0x0F, 0x11, 0x11, 0x0F, 0x05, 0x09, 0x11, 0x00, 0x00 } }, // 'Я'
+        { 0x0430, { 0x00, 0x00, 0x00, 0x00, 0x0E, 0x01, 0x0F, 0x11, 0x0F, 0x00, 0x00 } }, // 'а'
+        { 0x0431, { 0x00, 0x00, 0x07, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E, 0x00, 0x00 } }, // 'б'
+        { 0x0432, { 0x00, 0x00, 0x00, 0x00, 0x1E, 0x11, 0x1E, 0x11, 0x1E, 0x00, 0x00 } }, // 'в'
+        { 0x0433, { 0x00, 0x00, 0x00, 0x00, 0x1F, 0x10, 0x10, 0x10, 0x10, 0x00, 0x00 } }, // 'г'
+        { 0x0434, { 0x00, 0x00, 0x00, 0x00, 0x06, 0x0A, 0x0A, 0x11, 0x1F, 0x11, 0x00 } }, // 'д'
+        { 0x0435, { 0x00, 0x00, 0x00, 0x00, 0x0E, 0x11, 0x1F, 0x10, 0x0E, 0x00, 0x00 } }, // 'е'
+        { 0x0436, { 0x00, 0x00, 0x00, 0x00, 0x15, 0x15, 0x0E, 0x15, 0x15, 0x00, 0x00 } }, // 'ж'
+        { 0x0437, { 0x00, 0x00, 0x00, 0x00, 0x1E, 0x01, 0x0E, 0x01, 0x1E, 0x00, 0x00 } }, // 'з'
+        { 0x0438, { 0x00, 0x00, 0x00, 0x00, 0x11, 0x13, 0x15, 0x19, 0x11, 0x00, 0x00 } }, // 'и'
+        { 0x0439, { 0x00, 0x00, 0x0A, 0x04, 0x11, 0x13, 0x15, 0x19, 0x11, 0x00, 0x00 } }, // 'й'
+        { 0x043A, { 0x00, 0x00, 0x00, 0x00, 0x12, 0x14, 0x18, 0x14, 0x12, 0x00, 0x00 } }, // 'к'
+        { 0x043B, { 0x00, 0x00, 0x00, 0x00, 0x07, 0x09, 0x09, 0x09, 0x11, 0x00, 0x00 } }, // 'л'
+        { 0x043C, { 0x00, 0x00, 0x00, 0x00, 0x11, 0x1B, 0x15, 0x11, 0x11, 0x00, 0x00 } }, // 'м'
+        { 0x043D, { 0x00, 0x00, 0x00, 0x00, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x00, 0x00 } }, // 'н'
+        { 0x043E, { 0x00, 0x00, 0x00, 0x00, 0x0E, 0x11, 0x11, 0x11, 0x0E, 0x00, 0x00 } }, // 'о'
+        { 0x043F, { 0x00, 0x00, 0x00, 0x00, 0x1F, 0x11, 0x11, 0x11, 0x11, 0x00, 0x00 } }, // 'п'
+        { 0x0440, { 0x00, 0x00, 0x00, 0x00, 0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10 } }, // 'р'
+        { 0x0441, { 0x00, 0x00, 0x00, 0x00, 0x0E, 0x10, 0x10, 0x11, 0x0E, 0x00, 0x00 } }, // 'с'
+        { 0x0442, { 0x00, 0x00, 0x00, 0x00, 0x1F, 0x04, 0x04, 0x04, 0x04, 0x00, 0x00 } }, // 'т'
+        { 0x0443, { 0x00, 0x00, 0x00, 0x00, 0x11, 0x11, 0x11, 0x0F, 0x01, 0x11, 0x0E } }, // 'у'
+        { 0x0444, { 0x00, 0x00, 0x00, 0x04, 0x0E, 0x15, 0x15, 0x15, 0x0E, 0x04, 0x04 } }, // 'ф'
+        { 0x0445, { 0x00, 0x00, 0x00, 0x00, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x00, 0x00 } }, // 'х'
+        { 0x0446, { 0x00, 0x00, 0x00, 0x00, 0x12, 0x12, 0x12, 0x12, 0x1F, 0x01, 0x00 } }, // 'ц'
+        { 0x0447, { 0x00, 0x00, 0x00, 0x00, 0x11, 0x11, 0x0F, 0x01, 0x01, 0x00, 0x00 } }, // 'ч'
+        { 0x0448, { 0x00, 0x00, 0x00, 0x00, 0x15, 0x15, 0x15, 0x15, 0x1F, 0x00, 0x00 } }, // 'ш'
+        { 0x0449, { 0x00, 0x00, 0x00, 0x00, 0x15, 0x15, 0x15, 0x15, 0x1F, 0x01, 0x00 } }, // 'щ'
+        { 0x044A, { 0x00, 0x00, 0x00, 0x00, 0x18, 0x08, 0x0E, 0x09, 0x0E, 0x00, 0x00 } }, // 'ъ'
+        { 0x044B, { 0x00, 0x00, 0x00, 0x00, 0x11, 0x11, 0x19, 0x15, 0x19, 0x00, 0x00 } }, // 'ы'
+        { 0x044C, { 0x00, 0x00, 0x00, 0x00, 0x10, 0x10, 0x1E, 0x11, 0x1E, 0x00, 0x00 } }, // 'ь'
+        { 0x044D, { 0x00, 0x00, 0x00, 0x00, 0x0E, 0x11, 0x07, 0x11, 0x0E, 0x00, 0x00 } }, // 'э'
+        { 0x044E, { 0x00, 0x00, 0x00, 0x00, 0x12, 0x15, 0x1D, 0x15, 0x12, 0x00, 0x00 } }, // 'ю'
+        { 0x044F, { 0x00, 0x00, 0x00, 0x00, 0x0F, 0x11, 0x0F, 0x09, 0x11, 0x00, 0x00 } }, // 'я'
+        { 0x0401, { 0x0A, 0x00, 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F, 0x00, 0x00 } }, // 'Ё'
+        { 0x0451, { 0x00, 0x00, 0x0A, 0x00, 0x0E, 0x11, 0x1F, 0x10, 0x0E, 0x00, 0x00 } }, // 'ё'
+        { 0x0404, { 0x00, 0x00, 0x0E, 0x11, 0x10, 0x1E, 0x10, 0x11, 0x0E, 0x00, 0x00 } }, // 'Є'
+        { 0x0454, { 0x00, 0x00, 0x00, 0x00, 0x0E, 0x11, 0x1E, 0x11, 0x0E, 0x00, 0x00 } }, // 'є'
+        { 0x0406, { 0x00, 0x00, 0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E, 0x00, 0x00 } }, // 'І'
+        { 0x0456, { 0x00, 0x00, 0x04, 0x00, 0x0C, 0x04, 0x04, 0x04, 0x0E, 0x00, 0x00 } }, // 'і'
+        { 0x0407, { 0x0A, 0x00, 0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E, 0x00, 0x00 } }, // 'Ї'
+        { 0x0457, { 0x00, 0x00, 0x0A, 0x00, 0x0C, 0x04, 0x04, 0x04, 0x0E, 0x00, 0x00 } }, // 'ї'
+        { 0x0490, { 0x00, 0x01, 0x1F, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x00, 0x00 } }, // 'Ґ'
+        { 0x0491, { 0x00, 0x00, 0x00, 0x01, 0x1F, 0x10, 0x10, 0x10, 0x10, 0x00, 0x00 } }, // 'ґ'
+        { 0x00AB, { 0x00, 0x00, 0x00, 0x00, 0x05, 0x0A, 0x14, 0x0A, 0x05, 0x00, 0x00 } }, // '«'
+        { 0x00BB, { 0x00, 0x00, 0x00, 0x00, 0x14, 0x0A, 0x05, 0x0A, 0x14, 0x00, 0x00 } }, // '»'
+        { 0x2026, { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x15, 0x00, 0x00 } }, // '…'
+    };
+    static_assert(sizeof(GLYPHS) / sizeof(GLYPHS[0]) == FontFace::GLYPH_COUNT, "GLYPH_COUNT does not match the glyph table");
+    
+    constexpr int glyphIndex(uint32_t code) {
+        for (int i = 0; i < FontFace::GLYPH_COUNT; i++) {
+            if (GLYPHS[i].code == code) return i;
+        }
+        return -1;
+    }
+    
+    // Страница 0 - пустая; страницы с глифами заводятся по мере надобности.
+    // Лишняя страница сверх MAX_PAGES - выход за массив и ошибка компиляции.
+    constexpr GlyphMap buildMap() {
+        GlyphMap map = {};
+        uint16_t replacement = (uint16_t)glyphIndex('?');
+        int pageCount = 1;
+        for (int i = 0; i < GlyphMap::PAGE_SIZE; i++) {
+            map.pages[0][i] = replacement;
+        }
+        for (int i = 0; i < FontFace::GLYPH_COUNT; i++) {
+            uint32_t code = GLYPHS[i].code;
+            uint8_t& page = map.directory[code >> GlyphMap::PAGE_BITS];
+            if (page == 0) {
+                page = (uint8_t)pageCount++;
+                for (int j = 0; j < GlyphMap::PAGE_SIZE; j++) {
+                    map.pages[page][j] = replacement;
+                }
+            }
+            map.pages[page][code & (GlyphMap::PAGE_SIZE - 1)] = (uint16_t)i;
+        }
+        return map;
+    }
+    
+    // Размеры, которые использует интерфейс
+    const int PRELOADED_SIZES[] = { 12, 14, 16, 18, 20, 24, 28, 32, 48 };
+    
+    // Увеличение вдвое по правилам Scale2x: ступеньки диагоналей становятся
+    // наклонными отрезками, прямые штрихи остаются прямыми. За краем - пусто.
+    std::vector<uint8_t> scale2x(const std::vector<uint8_t>& src, int w, int h) {
+        auto at = [&](int x, int y) -> uint8_t {
+            return x >= 0 && x < w && y >= 0 && y < h ? src[y * w + x] : 0;
+        };
+        std::vector<uint8_t> dst(w * h * 4);
+        for (int y = 0; y < h; y++) {
+            for (int x = 0; x < w; x++) {
+                uint8_t e = at(x, y);
+                uint8_t b = at(x, y - 1), d = at(x - 1, y), f = at(x + 1, y), hh = at(x, y + 1);
+                uint8_t* row0 = dst.data() + (2 * y) * 2 * w + 2 * x;
+                uint8_t* row1 = row0 + 2 * w;
+                row0[0] = d == b && b != f && d != hh ? d : e;
+                row0[1] = b == f && b != d && f != hh ? f : e;
+                row1[0] = d == hh && d != b && hh != f ? d : e;
+                row1[1] = hh == f && d != hh && b != f ? f : e;
+            }
+        }
+        return dst;
+    }
+    
+    // Мастер-глиф клетками 0/1 и границы закрашенной части; у пустого глифа c1 < 0
+    struct Master {
+        std::vector<uint8_t> bits;
+        int c0, c1, r0, r1;
+        
+        explicit Master(const uint8_t* rows)
+            : bits(MASTER_WIDTH * MASTER_ROWS), c0(MASTER_WIDTH), c1(-1), r0(MASTER_ROWS), r1(-1) {
+            for (int r = 0; r < MASTER_ROWS; r++) {
+                for (int c = 0; c < MASTER_WIDTH; c++) {
+                    if (!(rows[r] & (0x10 >> c))) continue;
+                    bits[r * MASTER_WIDTH + c] = 1;
+                    c0 = std::min(c0, c);
+                    c1 = std::max(c1, c);
+                    r0 = std::min(r0, r);
+                    r1 = std::max(r1, r);
+                }
+            }
+        }
+        
+        // Сетка MASTER_WIDTH * UPSCALE x MASTER_ROWS * UPSCALE после двух проходов Scale2x
+        std::vector<uint8_t> upscale() const {
+            return scale2x(scale2x(bits, MASTER_WIDTH, MASTER_ROWS), MASTER_WIDTH * 2, MASTER_ROWS * 2);
+        }
+    };
+    
+    // Одномерное преобразование расстояний (Фельценшвальб, Хуттенлохер):
+    // d[q] = min по p (f[p] + (q - p)^2), нижняя огибающая парабол
+    void distanceTransform(const float* f, float* d, int n, int* v, float* z) {
+        int k = 0;
+        v[0] = 0;
+        z[0] = -INFINITY;
+        z[1] = INFINITY;
+        for (int q = 1; q < n; q++) {
+            float s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2.0f * (q - v[k]));
+            while (s <= z[k]) {
+                k--;
+                s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2.0f * (q - v[k]));
+            }
+            k++;
+            v[k] = q;
+            z[k] = s;
+            z[k + 1] = INFINITY;
+        }
+        k = 0;
+        for (int q = 0; q < n; q++) {
+            while (z[k + 1] < q) k++;
+            d[q] = (q - v[k]) * (q - v[k]) + f[v[k]];
+        }
+    }
+    
+    // Квадраты расстояний до ближайшей клетки с нулем (остальные - FAR):
+    // по строкам, затем по столбцам
+    const float FAR = 1e20f;
+    
+    void distanceTransform(std::vector<float>& grid, int w, int h) {
+        int n = std::max(w, h);
+        std::vector<float> f(n), d(n), z(n + 1);
+        std::vector<int> v(n);
+        for (int y = 0; y < h; y++) {
+            distanceTransform(grid.data() + y * w, d.data(), w, v.data(), z.data());
+            std::copy(d.begin(), d.begin() + w, grid.begin() + y * w);
+        }
+        for (int x = 0; x < w; x++) {
+            for (int y = 0; y < h; y++) f[y] = grid[y * w + x];
+            distanceTransform(f.data(), d.data(), h, v.data(), z.data());
+            for (int y = 0; y < h; y++) grid[y * w + x] = d[y];
+        }
+    }
+    
+    // Раздача площади: точка сетки [a, a + step) добавляет в пиксели
+    // target[p] длину своего пересечения с [p, p + 1), умноженную на weight
+    void splat(float* target, int count, float a, float step, float weight) {
+        int first = std::max(0, (int)floorf(a));
+        int last = std::min(count, (int)ceilf(a + step));
+        for (int p = first; p < last; p++) {
+            float len = std::min(a + step, (float)(p + 1)) - std::max(a, (float)p);
+            if (len > 0) target[p] += len * weight;
+        }
+    }
+}
+
+constexpr GlyphMap FontFace::charMap = buildMap();
+
+FontFace::FontFace(int fontSize)
+    : size(fontSize), ascent((int)lroundf(fontSize * BASELINE_ROW / (float)EM_ROWS)) {
+    for (int i = 0; i < GLYPH_COUNT; i++) {
+        rasterize(i, GLYPHS[i].rows);
+    }
+}
+
+// Мастер увеличивается в 4 раза двумя проходами Scale2x, затем каждая точка
+// увеличенной сетки отдает пикселям свою площадь: сначала по строке, потом
+// по столбцу. Базовая линия попадает на границу пикселей, глиф начинается
+// у пера с первого закрашенного столбца мастера.
+void FontFace::rasterize(int index, const uint8_t* rows) {
+    Glyph& g = glyphs[index];
+    g.offset = (int32_t)atlas.size();
+    g.width = g.height = g.top = 0;
+    
+    Master master(rows);
+    int c0 = master.c0, c1 = master.c1, r0 = master.r0, r1 = master.r1;
+    float k = size / (float)EM_ROWS;
+    if (c1 < 0) {
+        g.advance = (uint8_t)std::max(1L, lroundf(SPACE_COLUMNS * k));
+        return;
+    }
+    g.advance = (uint8_t)lroundf((c1 - c0 + 2) * k);
+    
+    int w = MASTER_WIDTH * UPSCALE, h = MASTER_ROWS * UPSCALE;
+    std::vector<uint8_t> fine = master.upscale();
+    
+    float step = k / UPSCALE;
+    float ox = -c0 * k;
+    float oy = ascent - BASELINE_ROW * k;
+    int top = std::max(0, (int)floorf(r0 * k + oy));
+    int bottom = std::min(size + 1, (int)ceilf((r1 + 1) * k + oy));
+    int width = (int)ceilf((c1 + 1) * k + ox);
+    int height = bottom - top;
+    
+    // Покрытие строк увеличенной сетки по пикселям, затем по строкам пикселей
+    std::vector<float> columns(h * width, 0.0f);
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            if (fine[y * w + x]) splat(columns.data() + y * width, width, x * step + ox, step, 1.0f);
+        }
+    }
+    std::vector<float> cover(height * width, 0.0f);
+    std::vector<float> weight(height);
+    for (int y = 0; y < h; y++) {
+        std::fill(weight.begin(), weight.end(), 0.0f);
+        splat(weight.data(), height, y * step + oy - top, step, 1.0f);
+        for (int py = 0; py < height; py++) {
+            if (weight[py] == 0) continue;
+            for (int px = 0; px < width; px++) {
+                cover[py * width + px] += weight[py] * columns[y * width + px];
+            }
+        }
+    }
+    
+    g.width = (uint8_t)width;
+    g.height = (uint8_t)height;
+    g.top = (uint8_t)top;
+    atlas.resize(atlas.size() + width * height);
+    uint8_t* dst = atlas.data() + g.offset;
+    for (int i = 0; i < width * height; i++) {
+        dst[i] = (uint8_t)std::min(255L, lroundf(cover[i] * 255));
+    }
+}
+
+int FontFace::measure(const char* text, size_t length) const {
+    const unsigned char* p = (const unsigned char*)text;
+    const unsigned char* end = p + length;
+    int width = 0;
+    while (p < end) {
+        width += glyph(Utf8::next(p, end)).advance;
+    }
+    return width;
+}
+
+template<class F>
+void FontFace::draw(const Raster::BasicTarget<F>& target, const char* text, size_t length,
+                    int x, int y, uint32_t pixel) const {
+    const unsigned char* p = (const unsigned char*)text;
+    const unsigned char* end = p + length;
+    while (p < end && x < target.x1) {
+        const Glyph& g = glyph(Utf8::next(p, end));
+        if (g.width && x + g.width > target.x0) {
+            Raster::fillMask(target, coverage(g), g.width, g.width, g.height, x, y + g.top, pixel);
+        }
+        x += g.advance;
+    }
+}
+
+#define INSTANTIATE(F) \
+    template void FontFace::draw(const Raster::BasicTarget<F>&, const char*, size_t, int, int, uint32_t) const;
+
+PIXEL_FORMATS(INSTANTIATE)
+#undef INSTANTIATE
+
+DistanceFont::DistanceFont() {
+    for (int i = 0; i < FontFace::GLYPH_COUNT; i++) {
+        build(i, GLYPHS[i].rows);
+    }
+}
+
+// Увеличенная сетка мастера с полями SPREAD: для каждой клетки точное
+// евклидово расстояние до ближайшей клетки другого цвета. Контур проходит
+// посередине между центрами, отсюда поправка на полклетки.
+void DistanceFont::build(int index, const uint8_t* rows) {
+    DistanceGlyph& g = glyphs[index];
+    g.offset = (int32_t)atlas.size();
+    g.width = g.height = 0;
+    g.left = g.top = 0;
+    
+    Master master(rows);
+    if (master.c1 < 0) {
+        g.advance = SPACE_COLUMNS;
+        return;
+    }
+    g.advance = (uint8_t)(master.c1 - master.c0 + 2);
+    
+    int fw = MASTER_WIDTH * UPSCALE, fh = MASTER_ROWS * UPSCALE;
+    std::vector<uint8_t> fine = master.upscale();
+    int x0 = fw, x1 = -1, y0 = fh, y1 = -1;
+    for (int y = 0; y < fh; y++) {
+        for (int x = 0; x < fw; x++) {
+            if (!fine[y * fw + x]) continue;
+            x0 = std::min(x0, x);
+            x1 = std::max(x1, x);
+            y0 = std::min(y0, y);
+            y1 = std::max(y1, y);
+        }
+    }
+    
+    int w = x1 - x0 + 1 + 2 * SPREAD, h = y1 - y0 + 1 + 2 * SPREAD;
+    std::vector<float> toInside(w * h), toOutside(w * h);
+    for (int j = 0; j < h; j++) {
+        for (int i = 0; i < w; i++) {
+            int x = x0 - SPREAD + i, y = y0 - SPREAD + j;
+            bool inside = x >= 0 && x < fw && y >= 0 && y < fh && fine[y * fw + x];
+            toInside[j * w + i] = inside ? 0.0f : FAR;
+            toOutside[j * w + i] = inside ? FAR : 0.0f;
+        }
+    }
+    distanceTransform(toInside, w, h);
+    distanceTransform(toOutside, w, h);
+    
+    g.width = (uint8_t)w;
+    g.height = (uint8_t)h;
+    g.left = (int8_t)(x0 - SPREAD - master.c0 * UPSCALE);
+    g.top = (int8_t)(y0 - SPREAD);
+    atlas.resize(atlas.size() + w * h);
+    uint8_t* dst = atlas.data() + g.offset;
+    for (int i = 0; i < w * h; i++) {
+        float d = toOutside[i] > 0 ? 0.5f - sqrtf(toOutside[i]) : sqrtf(toInside[i]) - 0.5f;
+        dst[i] = (uint8_t)std::min(255L, std::max(0L, lroundf((SPREAD - d) * 255 / (SPREAD + DEPTH))));
+    }
+}
+
+int DistanceFont::place(const char* text, size_t length, float size, int x, int y,
+                        std::vector<Raster::FieldGlyph>& out, int32_t& texelSize) const {
+    double k = size / EM_ROWS;
+    double t = k / TEXELS_PER_CELL;
+    double oy = lround(size * BASELINE_ROW / EM_ROWS) - BASELINE_ROW * k;
+    texelSize = (int32_t)lround(t * 65536);
+    
+    const unsigned char* p = (const unsigned char*)text;
+    const unsigned char* end = p + length;
+    int pen = 0;
+    while (p < end) {
+        const DistanceGlyph& g = glyph(Utf8::next(p, end));
+        if (g.width) {
+            out.push_back({ atlas.data() + g.offset, g.width, g.height,
+                            (int32_t)lround((x + pen + g.left * t) * 65536),
+                            (int32_t)lround((y + oy + g.top * t) * 65536) });
+        }
+        pen += std::max(1L, lround(g.advance * k));
+    }
+    return pen;
+}
+
+// Первое обращение может прийти из потока рендера: локальная статическая
+// переменная создается потокобезопасно
+FontCache* FontCache::getInstance() {
+    static FontCache cache;
+    return &cache;
+}
+
+FontCache::FontCache() {
+    for (int size : PRELOADED_SIZES) {
+        get(size);
+    }
+}
+
+const FontFace* FontCache::get(int size) {
+    size = clampSize(size);
+    if (!faces[size]) {
+        faces[size].reset(new FontFace(size));
+    }
+    return faces[size].get();
+}
+
+const DistanceFont* FontCache::distanceField() {
+    if (!field) {
+        field.reset(new DistanceFont());
+    }
+    return field.get();
+}
@@ -1,42 +1,112 @@
-#include "simple_interface.h"
-#include <cstring>
+#include "graphics.h"
+#include "display_list.h"
+#include "text_layout.h"
+#include "blend.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
 
-// Простая функция отрисовки текста без сложного шрифта
+namespace {
+
+    float clampUnit(float v) {
+        return v < 0.0f ? 0.0f : v > 1.0f ? 1.0f : v;
+    }
+    
+    // Цвет пикселя по значению поля: свечение, поверх него обводка, поверх
+    // заливка. Расстояния переводятся в пиксели экрана; край сглаживается
+    // на пиксель, свечение гаснет квадратично.
+    void buildFieldLut(uint32_t* lut, float texelPixels, const TextStyle& style,
+                       float outlineWidth, float glowRadius) {
+        uint32_t fill = style.fill.toPremultiplied();
+        uint32_t outline = outlineWidth > 0.0f ? style.outline.toPremultiplied() : 0;
+        uint32_t glow = glowRadius > 0.0f ? style.glow.toPremultiplied() : 0;
+        
+        for (int i = 0; i < Raster::FIELD_LUT_SIZE; i++) {
+            float d = DistanceFont::decode((i + 0.5f) / 4.0f) * texelPixels;
+            float edge = d - outlineWidth;
+            float fade = glowRadius > 0.0f ? 1.0f - clampUnit(edge / glowRadius) : 0.0f;
+            
+            uint32_t pixel = Blend::scalePixel(glow, Blend::opacityByte(fade * fade));
+            pixel = Blend::blendPixel(pixel, Blend::scalePixel(outline, Blend::opacityByte(clampUnit(0.5f - edge))));
+            lut[i] = Blend::blendPixel(pixel, Blend::scalePixel(fill, Blend::opacityByte(clampUnit(0.5f - d))));
+        }
+    }
+}
+
+// Текст рисуется пером от левого верхнего угла строки. Раскладка берется
+// из кэша, так что повторная надпись только проигрывает готовые глифы;
+// глифы - маски покрытия из атласа начертания.
 void GraphicsManager::drawText(const std::string& text, float x, float y, const Color& color, int fontSize) {
-    // Простая заглушка для отрисовки текста
-    // В реальной реализации здесь будет bitmap шрифт
+    if (color.a == 0 || text.empty()) return;
     
-    if (!framebuffer) return;
+    const TextLayout* layout = layouts->get(text, fontSize);
+    int ix = (int)lroundf(x), iy = (int)lroundf(y);
+    uint32_t pixel = color.toPremultiplied();
     
-    int charWidth = fontSize / 2;
-    int charHeight = fontSize;
+    // Нижние выносные могут заходить на пиксель ниже последней строки
+    DirtyRect box = { ix, iy, ix + layout->width, iy + layout->height + 1 };
+    if (!visibleBounds(box)) return;
     
-    for (size_t i = 0; i < text.length(); i++) {
-        char c = text[i];
-        
-        // Простой прямоугольник вместо символа (для совместимости)
-        int startX = (int)(x + i * charWidth);
-        int startY = (int)y;
-        
-        // Рисуем простой прямоугольник для каждого символа
-        for (int dy = 0; dy < charHeight && startY + dy < height; dy++) {
-            for (int dx = 0; dx < charWidth && startX + dx < width; dx++) {
-                if (startX + dx >= 0 && startY + dy >= 0) {
-                    int pixelIndex = (startY + dy) * width + (startX + dx);
-                    if (pixelIndex < width * height) {
-                        // Простая отрисовка - рамка символа
-                        if (dx == 0 || dx == charWidth-1 || dy == 0 || dy == charHeight-1) {
-                            framebuffer[pixelIndex] = color.toRGBA();
-                        }
-                    }
-                }
-            }
-        }
+    if (recording) {
+        DrawCommand cmd;
+        cmd.type = DrawCommand::TEXT;
+        cmd.p[0] = ix;
+        cmd.p[1] = iy;
+        cmd.p[2] = displayList->storeLayout(layout);
+        cmd.color = pixel;
+        record(cmd, box);
+        return;
     }
+    
+    rasterize(box, [&](const auto& t) { layout->draw(t, ix, iy, pixel); });
 }
 
-// Простая функция получения размера текста
 void GraphicsManager::getTextSize(const std::string& text, int fontSize, int& width, int& height) {
-    width = text.length() * (fontSize / 2);
-    height = fontSize;
-}
\ No newline at end of file
+    const TextLayout* layout = layouts->get(text, fontSize);
+    width = layout->width;
+    height = layout->height;
+}
+
+void GraphicsManager::drawStyledText(const std::string& text, float x, float y, float fontSize, const TextStyle& style) {
+    if (text.empty() || fontSize <= 0.0f) return;
+    if (style.fill.a == 0 && style.outline.a == 0 && style.glow.a == 0) return;
+    
+    const DistanceFont* font = FONTS->distanceField();
+    int ix = (int)lroundf(x), iy = (int)lroundf(y);
+    int32_t texelSize;
+    fieldGlyphs.clear();
+    font->place(text.data(), text.size(), fontSize, ix, iy, fieldGlyphs, texelSize);
+    if (fieldGlyphs.empty()) return;
+    
+    DirtyRect box = { INT_MAX, INT_MAX, INT_MIN, INT_MIN };
+    for (const Raster::FieldGlyph& g : fieldGlyphs) {
+        box.x0 = std::min(box.x0, g.x >> 16);
+        box.y0 = std::min(box.y0, g.y >> 16);
+        box.x1 = std::max(box.x1, (int)((g.x + (int64_t)g.width * texelSize + 0xFFFF) >> 16));
+        box.y1 = std::max(box.y1, (int)((g.y + (int64_t)g.height * texelSize + 0xFFFF) >> 16));
+    }
+    // Таблица строится только для видимого текста
+    if (!visibleBounds(box)) return;
+    
+    // Свечение должно погаснуть до края поля, иначе оно обрежется рамкой глифа
+    float texelPixels = texelSize / 65536.0f;
+    float reach = (DistanceFont::SPREAD - 1) * texelPixels;
+    float outlineWidth = style.outline.a ? std::min(std::max(style.outlineWidth, 0.0f), reach) : 0.0f;
+    float glowRadius = style.glow.a ? std::min(std::max(style.glowRadius, 0.0f), reach - outlineWidth) : 0.0f;
+    uint32_t lut[Raster::FIELD_LUT_SIZE];
+    buildFieldLut(lut, texelPixels, style, outlineWidth, glowRadius);
+    
+    int count = (int)fieldGlyphs.size();
+    if (recording) {
+        DrawCommand cmd;
+        cmd.type = DrawCommand::TEXT_FIELD;
+        cmd.p[0] = displayList->storeFieldGlyphs(fieldGlyphs.data(), count);
+        cmd.p[1] = count;
+        cmd.p[2] = displayList->storePixels(lut, Raster::FIELD_LUT_SIZE);
+        cmd.p[3] = texelSize;
+        record(cmd, box);
+        return;
+    }
+    
+    rasterize(box, [&](const auto& t) { Raster::fillDistanceField(t, fieldGlyphs.data(), count, texelSize, lut); });
+}
@@ -1,6 +1,6 @@
 #include "game_database.h"
 #include "neovia.h"
-#include <switch.h>
+#include "platform.h"
 #include <vector>
 #include <map>
 #include <string>
@@ -170,6 +170,10 @@ static const std::map<std::string, std::string> GAME_DATABASE = {
 
 // Сканирование установленных игр на консоли
 Result scanInstalledGames(std::vector<GameInfo>& games) {
+#ifndef __SWITCH__
+    // На хосте установленных игр нет
+    return 0;
+#else
     Result rc = 0;
     NsApplicationRecord* records = nullptr;
     s32 recordCount = 0;
@@ -211,6 +215,7 @@ Result scanInstalledGames(std::vector<GameInfo>& games) {
             game.hasIcon = false;
             game.iconData = nullptr;
             game.iconSize = 0;
+            game.hasCustomProfile = false;
             
             // Пытаемся получить иконку игры
             NsApplicationControlData controlData;
@@ -248,6 +253,7 @@ Result scanInstalledGames(std::vector<GameInfo>& games) {
     
     delete[] records;
     return 0;
+#endif
 }
 
 // Получение информации об игре по Title ID
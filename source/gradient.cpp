@@ -0,0 +1,168 @@
+#include "rasterizer.h"
+#include "graphics.h"
+#include <algorithm>
+#include <cmath>
+
+// Градиенты: таблица цветов строится один раз на вызов, заливка - массовыми записями.
+// Цвета таблицы хранятся в 8.8 с фиксированной точкой; при сглаживании дробная
+// часть округляется порогом из матрицы Байера 4x4, привязанной к экранным
+// координатам, поэтому тайлы стыкуются без швов.
+namespace {
+
+    // Строка собирается в буфере на стеке кусками такой длины (кратной 4,
+    // чтобы узор сглаживания одинаково ложился на каждый кусок)
+    const int CHUNK = 256;
+    
+    // Предел размера таблицы радиального градиента
+    const int MAX_RAMP = 4096;
+    
+    // Порог округления для пикселя (x, y); без сглаживания - обычное округление
+    inline uint32_t threshold(int x, int y, bool dither) {
+        return dither ? PixelFormat::bayer(x, y) * 16 + 8 : 128;
+    }
+    
+    // Предумноженный цвет в 8.8
+    struct RampEntry {
+        uint16_t r, g, b, a;
+    };
+    
+    inline RampEntry rampEntry(const Color& start, const Color& end, float t) {
+        float a = start.a + t * (end.a - start.a);
+        float scale = a / 255.0f * 256.0f;
+        RampEntry e;
+        e.r = (uint16_t)((start.r + t * (end.r - start.r)) * scale + 0.5f);
+        e.g = (uint16_t)((start.g + t * (end.g - start.g)) * scale + 0.5f);
+        e.b = (uint16_t)((start.b + t * (end.b - start.b)) * scale + 0.5f);
+        e.a = (uint16_t)(a * 256.0f + 0.5f);
+        return e;
+    }
+    
+    // Таблица радиального градиента своя у каждого потока: она слишком велика
+    // для стека рабочего потока, а выделять ее на каждый вызов (в отложенном
+    // режиме - на каждый тайл) дорого
+    thread_local RampEntry radialRamp[MAX_RAMP + 1];
+    
+    inline uint32_t pack(const RampEntry& e, uint32_t th) {
+        return (((e.r + th) >> 8) << 24) | (((e.g + th) >> 8) << 16) |
+               (((e.b + th) >> 8) << 8) | ((e.a + th) >> 8);
+    }
+    
+    template<class F>
+    inline void storeRow(typename F::Pixel* dst, const uint32_t* src, int count, bool opaque) {
+        if (opaque) {
+            F::copy(dst, src, count);
+        } else {
+            F::blend(dst, src, count, 255);
+        }
+    }
+}
+
+namespace Raster {
+
+    template<class F>
+    void fillGradient(const BasicTarget<F>& target, int x, int y, int w, int h,
+                      const Color& startColor, const Color& endColor, bool vertical, bool dither) {
+        int x0 = std::max(x, target.x0);
+        int y0 = std::max(y, target.y0);
+        int x1 = std::min(x + w, target.x1);
+        int y1 = std::min(y + h, target.y1);
+        if (x0 >= x1 || y0 >= y1) return;
+        if (startColor.a == 0 && endColor.a == 0) return;
+        
+        bool opaque = startColor.a == 255 && endColor.a == 255;
+        int count = x1 - x0;
+        
+        if (vertical) {
+            // Цвет постоянен вдоль строки; со сглаживанием строка - повтор
+            // четырех пикселей, один кусок годится для всей строки
+            uint32_t buffer[CHUNK];
+            int chunk = std::min(count, CHUNK);
+            for (int py = y0; py < y1; py++) {
+                RampEntry e = rampEntry(startColor, endColor, (float)(py - y) / h);
+                if (!dither) {
+                    fillSpan(target, py, x0, x1, pack(e, 128));
+                    continue;
+                }
+                
+                uint32_t pattern[4];
+                for (int k = 0; k < 4; k++) {
+                    pattern[k] = pack(e, threshold(k, py, true));
+                }
+                for (int i = 0; i < chunk; i++) {
+                    buffer[i] = pattern[(x0 + i) & 3];
+                }
+                typename F::Pixel* dst = target.row(py) + x0;
+                for (int i = 0; i < count; i += CHUNK) {
+                    storeRow<F>(dst + i, buffer, std::min(CHUNK, count - i), opaque);
+                }
+            }
+        } else {
+            // Цвет постоянен вдоль столбца: для каждого куска столбцов одна
+            // готовая строка (или четыре со сглаживанием), каждая строка
+            // экрана - копия одной из них
+            int variants = dither ? 4 : 1;
+            uint32_t rows[4][CHUNK];
+            for (int cx0 = x0; cx0 < x1; cx0 += CHUNK) {
+                int cx1 = std::min(x1, cx0 + CHUNK);
+                for (int px = cx0; px < cx1; px++) {
+                    RampEntry e = rampEntry(startColor, endColor, (float)(px - x) / w);
+                    for (int v = 0; v < variants; v++) {
+                        rows[v][px - cx0] = pack(e, threshold(px, v, dither));
+                    }
+                }
+                for (int py = y0; py < y1; py++) {
+                    const uint32_t* src = rows[dither ? (py & 3) : 0];
+                    storeRow<F>(target.row(py) + cx0, src, cx1 - cx0, opaque);
+                }
+            }
+        }
+    }
+    
+    // Радиальный градиент в круге радиуса radius с центром в углу пикселя (cx, cy).
+    // Таблица индексируется квадратом расстояния, поэтому корень считается
+    // только при построении таблицы, а не для каждого пикселя.
+    template<class F>
+    void fillRadialGradient(const BasicTarget<F>& target, int cx, int cy, int radius,
+                            const Color& innerColor, const Color& outerColor, bool dither) {
+        if (radius <= 0 || (innerColor.a == 0 && outerColor.a == 0)) return;
+        
+        int x0 = std::max(cx - radius, target.x0);
+        int y0 = std::max(cy - radius, target.y0);
+        int x1 = std::min(cx + radius, target.x1);
+        int y1 = std::min(cy + radius, target.y1);
+        if (x0 >= x1 || y0 >= y1) return;
+        
+        // Расстояния в половинах пикселя: центр пикселя px - это 2 * px + 1
+        int64_t limit = 4 * (int64_t)radius * radius;
+        int size = (int)std::min<int64_t>(limit, MAX_RAMP);
+        RampEntry* ramp = radialRamp;
+        for (int i = 0; i <= size; i++) {
+            ramp[i] = rampEntry(innerColor, outerColor, sqrtf((float)i / size));
+        }
+        
+        uint32_t buffer[CHUNK];
+        for (int py = y0; py < y1; py++) {
+            int64_t dy = 2 * (py - cy) + 1;
+            for (int cx0 = x0; cx0 < x1; cx0 += CHUNK) {
+                int cx1 = std::min(x1, cx0 + CHUNK);
+                for (int px = cx0; px < cx1; px++) {
+                    int64_t dx = 2 * (px - cx) + 1;
+                    int64_t d2 = dx * dx + dy * dy;
+                    if (d2 >= limit) {
+                        buffer[px - cx0] = 0;
+                    } else {
+                        buffer[px - cx0] = pack(ramp[(int)(d2 * size / limit)], threshold(px, py, dither));
+                    }
+                }
+                F::blend(target.row(py) + cx0, buffer, cx1 - cx0, 255);
+            }
+        }
+    }
+
+#define INSTANTIATE(F) \
+    template void fillGradient(const BasicTarget<F>&, int, int, int, int, const Color&, const Color&, bool, bool); \
+    template void fillRadialGradient(const BasicTarget<F>&, int, int, int, const Color&, const Color&, bool);
+    
+    PIXEL_FORMATS(INSTANTIATE)
+#undef INSTANTIATE
+}
@@ -1,7 +1,13 @@
 #include "graphics.h"
+#include "blend.h"
+#include "display_list.h"
+#include "surface.h"
+#include "shadow_cache.h"
+#include "text_layout.h"
 #include <cmath>
 #include <algorithm>
 #include <cstring>
+#include <cstdlib>
 #include <functional>
 
 GraphicsManager* GraphicsManager::instance = nullptr;
@@ -14,185 +20,934 @@ GraphicsManager* GraphicsManager::getInstance() {
 }
 
 bool GraphicsManager::initialize() {
-    gfxInitDefault();
     width = 1280;
     height = 720;
-    framebuffer = (uint32_t*)gfxGetFramebuffer(&width, &height);
+    framebuffer = PLATFORM->initialize(width, height) ? PLATFORM->getFramebuffer(&width, &height) : nullptr;
     lastFrameTime = 0.016f; // 60 FPS по умолчанию
+    deferred = false;
+    recording = false;
+    recordingSuspended = false;
+    renderTarget = nullptr;
+    dithering = true;
+    subpixel = true;
+    displayList = new DisplayList();
+    workers = new WorkerPool();
+    shadows = new ShadowCache();
+    layouts = new TextLayoutCache();
+    backBuffer = new Surface();
+    background = new Surface();
+    backBuffered = false;
+    backgroundDithered = false;
+    lowPower = false;
+    lowBuffer = nullptr;
+    lowBackground = nullptr;
+    stats = FrameStats();
+    frameStats = FrameStats();
+    // Потоков не больше, чем ядер: лишние потоки делили бы одно ядро
+    setRenderThreads(std::min(WorkerPool::MAX_WORKERS, WorkerPool::getCoreCount()));
+    setBackBuffer(true);
+    resetTarget();
     return framebuffer != nullptr;
 }
 
 void GraphicsManager::cleanup() {
-    gfxExit();
+    releaseLowPower();
+    delete background;
+    background = nullptr;
+    delete backBuffer;
+    backBuffer = nullptr;
+    delete shadows;
+    shadows = nullptr;
+    delete layouts;
+    layouts = nullptr;
+    delete workers;
+    workers = nullptr;
+    delete displayList;
+    displayList = nullptr;
+    PLATFORM->shutdown();
 }
 
-void GraphicsManager::beginFrame() {
-    static u64 lastTime = armGetSystemTick();
-    u64 currentTime = armGetSystemTick();
-    lastFrameTime = (float)(currentTime - lastTime) / armGetSystemTickFreq();
-    lastTime = currentTime;
+// Цель строится заново из буфера кадра (или поверхности) и сужается
+// до текущего прямоугольника отсечения
+void GraphicsManager::resetTarget() {
+    if (renderTarget) {
+        target = renderTarget->target();
+    } else if (backBuffered) {
+        target = backBuffer->target();
+    } else {
+        target = Raster::Target(framebuffer, width, 0, 0, width, height);
+    }
+    if (lowPower) {
+        lowTarget = Raster::BasicTarget<PixelFormat::RGB565>(lowBuffer, width, 0, 0, width, height);
+    }
+    
+    if (!clipStack.empty()) {
+        const DirtyRect& clip = clipStack.back();
+        target = target.clip(clip.x0, clip.y0, clip.x1, clip.y1);
+        lowTarget = lowTarget.clip(clip.x0, clip.y0, clip.x1, clip.y1);
+    }
+}
+
+void GraphicsManager::pushClip(int x, int y, int w, int h) {
+    DirtyRect clip = { x, y, x + w, y + h };
+    if (!clipStack.empty()) {
+        const DirtyRect& outer = clipStack.back();
+        clip = { std::max(clip.x0, outer.x0), std::max(clip.y0, outer.y0),
+                 std::min(clip.x1, outer.x1), std::min(clip.y1, outer.y1) };
+    }
+    clipStack.push_back(clip);
+    resetTarget();
+}
+
+void GraphicsManager::popClip() {
+    if (clipStack.empty()) return;
+    clipStack.pop_back();
+    resetTarget();
+}
+
+bool GraphicsManager::isClipped(float x, float y, float w, float h) const {
+    return !target.valid() || x + w <= target.x0 || x >= target.x1 ||
+           y + h <= target.y0 || y >= target.y1;
+}
+
+void GraphicsManager::setBackBuffer(bool enabled) {
+    flush();
+    backBuffered = enabled && backBuffer->create(width, height);
+    if (!backBuffered) backBuffer->release();
+    presentedDamage.setBounds(width, height);
+    presentedDamage.addAll();
+    resetTarget();
+}
+
+// Фон кадра - градиент, который раньше пересчитывался в каждом beginFrame
+void GraphicsManager::buildBackground() {
+    if (!background->create(width, height)) return;
+    Raster::fillGradient(background->target(), 0, 0, width, height,
+                         Colors::BACKGROUND, Color(12, 12, 18), true, dithering);
+    background->setOpaque(true);
+    backgroundDithered = dithering;
+    
+    // В экономичном режиме фон хранится уже в RGB565: упаковка со сглаживанием,
+    // иначе темный градиент распадается на полосы
+    if (lowPower) {
+        for (uint32_t y = 0; y < height; y++) {
+            const uint32_t* src = background->row(y);
+            uint16_t* dst = lowBackground + y * width;
+            for (uint32_t x = 0; x < width; x++) {
+                dst[x] = PixelFormat::RGB565::packDithered(src[x], x, y);
+            }
+        }
+    }
+}
+
+void GraphicsManager::setLowPowerMode(bool enabled) {
+    flush();
+    releaseLowPower();
     
-    framebuffer = (uint32_t*)gfxGetFramebuffer(&width, &height);
+    if (enabled) {
+        size_t bytes = ((size_t)width * height * sizeof(uint16_t) + 63) & ~(size_t)63;
+        lowBuffer = (uint16_t*)aligned_alloc(64, bytes);
+        lowBackground = (uint16_t*)aligned_alloc(64, bytes);
+        if (lowBuffer && lowBackground) {
+            lowPower = true;
+            buildBackground();
+        } else {
+            releaseLowPower();
+        }
+    }
     
-    // Очистка экрана с градиентом
-    drawGradient(0, 0, width, height, Colors::BACKGROUND, Color(12, 12, 18), true);
+    presentedDamage.addAll();
+    resetTarget();
 }
 
-void GraphicsManager::endFrame() {
-    gfxFlushBuffers();
-    gfxSwapBuffers();
-    gfxWaitForVsync();
+void GraphicsManager::releaseLowPower() {
+    free(lowBuffer);
+    free(lowBackground);
+    lowBuffer = nullptr;
+    lowBackground = nullptr;
+    lowPower = false;
+    lowTarget = Raster::BasicTarget<PixelFormat::RGB565>();
 }
 
-void GraphicsManager::drawPixel(int x, int y, const Color& color) {
-    if (x < 0 || x >= (int)width || y < 0 || y >= (int)height || !framebuffer) return;
+void GraphicsManager::beginFrame() {
+    static uint64_t lastTime = PLATFORM->getTicks();
+    uint64_t currentTime = PLATFORM->getTicks();
+    lastFrameTime = (float)(currentTime - lastTime) / PLATFORM->getTickFrequency();
+    lastTime = currentTime;
+    
+    framebuffer = PLATFORM->getFramebuffer(&width, &height);
+    renderTarget = nullptr;
+    recordingSuspended = false;
+    clipStack.clear();
+    occluders.clear();
+    stats = FrameStats();
+    if (!paintedMask.empty()) setOverdrawTracking(true);
+    if (backBuffered && (backBuffer->getWidth() != (int)width || backBuffer->getHeight() != (int)height)) {
+        setBackBuffer(true);
+    }
+    if (lowPower && (background->getWidth() != (int)width || background->getHeight() != (int)height)) {
+        setLowPowerMode(true);
+    }
+    resetTarget();
+    shadows->beginFrame();
+    layouts->beginFrame();
     
-    uint32_t* pixel = framebuffer + y * width + x;
-    if (color.a == 255) {
-        *pixel = color.toRGBA();
+    // В отложенном режиме кадр сначала записывается в список команд
+    if (deferred) {
+        displayList->reset(width, height);
+        recording = true;
+    }
+    
+    // Очистка экрана копией готового фона; в отложенном режиме это
+    // непрозрачная команда на весь кадр, и тайлы не читают старый кадр
+    if (!background->valid() || background->getWidth() != (int)width ||
+        background->getHeight() != (int)height || backgroundDithered != dithering) {
+        buildBackground();
+    }
+    if (lowPower) {
+        memcpy(lowBuffer, lowBackground, (size_t)width * height * sizeof(uint16_t));
+        countPaint({ 0, 0, (int)width, (int)height });
+    } else if (background->valid()) {
+        drawSurface(*background, 0, 0);
     } else {
-        // Alpha blending
-        uint32_t existing = *pixel;
-        uint8_t er = (existing >> 24) & 0xFF;
-        uint8_t eg = (existing >> 16) & 0xFF;
-        uint8_t eb = (existing >> 8) & 0xFF;
-        
-        float alpha = color.a / 255.0f;
-        uint8_t nr = (uint8_t)(color.r * alpha + er * (1.0f - alpha));
-        uint8_t ng = (uint8_t)(color.g * alpha + eg * (1.0f - alpha));
-        uint8_t nb = (uint8_t)(color.b * alpha + eb * (1.0f - alpha));
-        
-        *pixel = (nr << 24) | (ng << 16) | (nb << 8) | 0xFF;
+        drawGradient(0, 0, width, height, Colors::BACKGROUND, Color(12, 12, 18), true);
     }
 }
 
-void GraphicsManager::drawLine(int x1, int y1, int x2, int y2, const Color& color, float thickness) {
-    int dx = abs(x2 - x1);
-    int dy = abs(y2 - y1);
-    int sx = x1 < x2 ? 1 : -1;
-    int sy = y1 < y2 ? 1 : -1;
-    int err = dx - dy;
+void GraphicsManager::endFrame(const DirtyRegion* damage) {
+    flush();
+    
+    // Перерисовка - все закраски сверх первой для каждого пикселя
+    if (!paintedMask.empty()) {
+        int64_t covered = std::count(paintedMask.begin(), paintedMask.end(), 1);
+        stats.overdrawPixels = stats.paintedPixels - covered;
+    }
+    stats.textLayoutHits = layouts->getHits();
+    stats.textLayoutMisses = layouts->getMisses();
+    stats.textLayoutBytes = (int64_t)layouts->getMemoryBytes();
+    frameStats = stats;
+    present(damage);
+    PLATFORM->present();
+}
+
+void GraphicsManager::setDeferred(bool enabled) {
+    if (!enabled) flush();
+    deferred = enabled;
+}
+
+void GraphicsManager::flush() {
+    if (renderTarget) setTarget(nullptr);
+    if (!recording) return;
     
-    int x = x1, y = y1;
-    int halfThickness = (int)(thickness / 2);
+    // Команды уже обрезаны отсечением, действовавшим при записи, поэтому
+    // список рисуется в кадр целиком: пустое текущее отсечение иначе
+    // выбросило бы все записанное
+    std::vector<DirtyRect> clips;
+    clips.swap(clipStack);
+    resetTarget();
+    rasterize([&](const auto& t) { displayList->render(t, workers); });
+    clipStack.swap(clips);
+    resetTarget();
+    recording = false;
+}
+
+// Копирование кадра из заднего буфера в память дисплея. Дисплей меняет
+// буферы по очереди, и в текущем лежит кадр двухкадровой давности,
+// поэтому копируются изменения и этого, и прошлого кадра.
+void GraphicsManager::present(const DirtyRegion* damage) {
+    if ((!backBuffered && !lowPower) || !framebuffer) return;
     
-    while (true) {
-        // Рисуем толстую линию
-        for (int i = -halfThickness; i <= halfThickness; i++) {
-            for (int j = -halfThickness; j <= halfThickness; j++) {
-                drawPixel(x + i, y + j, color);
+    DirtyRegion region(width, height);
+    if (damage) {
+        region.add(*damage);
+        region.add(presentedDamage);
+    } else {
+        region.addAll();
+    }
+    
+    for (int i = 0; i < region.size(); i++) {
+        const DirtyRect& rect = region[i];
+        for (int y = rect.y0; y < rect.y1; y++) {
+            uint32_t* dst = framebuffer + y * width + rect.x0;
+            if (lowPower) {
+                PixelFormat::RGB565::load(dst, lowTarget.row(y) + rect.x0, rect.x1 - rect.x0);
+            } else {
+                Blend::copyPixels(dst, backBuffer->row(y) + rect.x0, rect.x1 - rect.x0);
             }
         }
-        
-        if (x == x2 && y == y2) break;
-        
-        int e2 = 2 * err;
-        if (e2 > -dy) {
-            err -= dy;
-            x += sx;
+    }
+    
+    presentedDamage.clear();
+    if (damage) {
+        presentedDamage.add(*damage);
+    } else {
+        presentedDamage.addAll();
+    }
+}
+
+void GraphicsManager::setRenderThreads(int count) {
+    if (count <= 1) {
+        workers->stop();
+    } else {
+        workers->start(count);
+    }
+}
+
+int GraphicsManager::getRenderThreads() const {
+    return std::max(1, workers->getThreadCount());
+}
+
+void GraphicsManager::setTarget(Surface* surface) {
+    if (surface == renderTarget) return;
+    
+    if (surface) {
+        if (!renderTarget) {
+            recordingSuspended = recording;
+            recording = false;
         }
-        if (e2 < dx) {
-            err += dx;
-            y += sy;
+    } else {
+        recording = recordingSuspended;
+        recordingSuspended = false;
+    }
+    renderTarget = surface;
+    resetTarget();
+}
+
+void GraphicsManager::drawSurface(const Surface& surface, int x, int y, float opacity) {
+    drawSurfaceRegion(surface, 0, 0, surface.getWidth(), surface.getHeight(),
+                      x, y, surface.getWidth(), surface.getHeight(), opacity);
+}
+
+void GraphicsManager::drawSurfaceRegion(const Surface& surface, int sx, int sy, int sw, int sh,
+                                        int x, int y, int w, int h, float opacity) {
+    uint32_t o = Blend::opacityByte(opacity);
+    if (o == 0 || !surface.valid() || w <= 0 || h <= 0) return;
+    if (sx < 0 || sy < 0 || sw <= 0 || sh <= 0 ||
+        sx + sw > surface.getWidth() || sy + sh > surface.getHeight()) return;
+    
+    DirtyRect box = { x, y, x + w, y + h };
+    if (!visibleBounds(box)) return;
+    
+    if (recording) {
+        DrawCommand cmd;
+        cmd.type = DrawCommand::BLIT;
+        cmd.p[0] = x;
+        cmd.p[1] = y;
+        cmd.p[2] = displayList->storeSurface(&surface, sx, sy, sw, sh);
+        cmd.p[3] = w;
+        cmd.p[4] = h;
+        cmd.color = o;
+        record(cmd, box);
+        return;
+    }
+    
+    rasterize(box, [&](const auto& t) {
+        Raster::tile(t, surface.row(sy) + sx, surface.getStride(), sw, sh, x, y, w, h, o, surface.isOpaque());
+    });
+}
+
+void GraphicsManager::drawImage(const uint32_t* pixels, int stride, int width, int height, float x, float y,
+                                float scaleX, float scaleY, float rotation, float opacity, bool bilinear) {
+    uint32_t o = Blend::opacityByte(opacity);
+    if (o == 0 || !pixels || width <= 0 || height <= 0 || scaleX <= 0.0f || scaleY <= 0.0f) return;
+    if (!subpixel) {
+        x = (int)x;
+        y = (int)y;
+    }
+    
+    // Синус и косинус - один раз на изображение; поворот вокруг центра
+    double c = cos(rotation), s = sin(rotation);
+    double hw = width * scaleX * 0.5, hh = height * scaleY * 0.5;
+    double cx = x + hw, cy = y + hh;
+    
+    // Прямоугольник повернутых углов; билинейные края шире на полпикселя источника
+    double ex = hw + (bilinear ? scaleX * 0.5 : 0.0);
+    double ey = hh + (bilinear ? scaleY * 0.5 : 0.0);
+    double bw = fabs(c) * ex + fabs(s) * ey;
+    double bh = fabs(s) * ex + fabs(c) * ey;
+    DirtyRect box = { (int)floor(cx - bw), (int)floor(cy - bh), (int)ceil(cx + bw), (int)ceil(cy + bh) };
+    
+    // Обратное отображение строится от угла необрезанного прямоугольника,
+    // чтобы выборки не зависели от отсечения
+    Raster::AffineMap map;
+    map.x = box.x0;
+    map.y = box.y0;
+    double dx = map.x + 0.5 - cx, dy = map.y + 0.5 - cy;
+    map.u = llround((width * 0.5 + (dx * c + dy * s) / scaleX) * 65536.0);
+    map.v = llround((height * 0.5 + (dy * c - dx * s) / scaleY) * 65536.0);
+    map.dudx = (int32_t)lround(c / scaleX * 65536.0);
+    map.dudy = (int32_t)lround(s / scaleX * 65536.0);
+    map.dvdx = (int32_t)lround(-s / scaleY * 65536.0);
+    map.dvdy = (int32_t)lround(c / scaleY * 65536.0);
+    
+    if (!visibleBounds(box)) return;
+    
+    if (recording) {
+        DrawCommand cmd;
+        cmd.type = DrawCommand::IMAGE_AFFINE;
+        cmd.p[0] = displayList->storeImage(pixels, stride, width, height, map);
+        cmd.p[1] = bilinear;
+        cmd.color = o;
+        record(cmd, box);
+        return;
+    }
+    
+    rasterize(box, [&](const auto& t) {
+        Raster::blitAffine(t, pixels, stride, width, height, map, o, bilinear);
+    });
+}
+
+// Прямоугольник команды уже обрезан по отсечению и перекрытию; при растеризации
+// тайла команда рисуется только внутри него, так что обрезка сохраняется
+void GraphicsManager::record(const DrawCommand& cmd, const DirtyRect& box) {
+    displayList->add(cmd, box.x0, box.y0, box.x1, box.y1);
+}
+
+// Часть box внутри цели, не закрытая перекрывающими областями; без статистики
+bool GraphicsManager::visibleArea(DirtyRect& box, DirtyRect& visible) const {
+    box = { std::max(box.x0, target.x0), std::max(box.y0, target.y0),
+            std::min(box.x1, target.x1), std::min(box.y1, target.y1) };
+    visible = box;
+    if (box.empty()) return false;
+    if (renderTarget) return true;
+    
+    for (const DirtyRect& o : occluders) {
+        if (o.x0 <= visible.x0 && o.x1 >= visible.x1) {
+            if (o.y0 <= visible.y0 && o.y1 > visible.y0) {
+                visible.y0 = o.y1;
+            } else if (o.y1 >= visible.y1 && o.y0 < visible.y1) {
+                visible.y1 = o.y0;
+            }
+        } else if (o.y0 <= visible.y0 && o.y1 >= visible.y1) {
+            if (o.x0 <= visible.x0 && o.x1 > visible.x0) {
+                visible.x0 = o.x1;
+            } else if (o.x1 >= visible.x1 && o.x0 < visible.x1) {
+                visible.x1 = o.x0;
+            }
         }
+        if (visible.empty()) return false;
+    }
+    return true;
+}
+
+// Прямоугольник примитива обрезается по цели и по перекрывающим прямоугольникам.
+// Закрытый прямоугольник отбрасывается, а закрытый с одного края во всю
+// ширину или высоту - укорачивается. Пакеты (trim = false) рисуются
+// одним проходом, поэтому у них отбрасываются только закрытые целиком элементы.
+bool GraphicsManager::visibleBounds(DirtyRect& box, bool trim) {
+    DirtyRect visible;
+    if (!visibleArea(box, visible)) {
+        if (!box.empty()) stats.culled++;
+        return false;
+    }
+    
+    if (trim && visible.area() != box.area()) {
+        stats.trimmed++;
+        box = visible;
+    }
+    stats.drawn++;
+    countPaint(box);
+    return true;
+}
+
+// Площадь закраски; при подсчете перерисовки закрашенные пиксели еще и отмечаются
+void GraphicsManager::countPaint(const DirtyRect& box) {
+    stats.paintedPixels += box.area();
+    if (paintedMask.empty()) return;
+    
+    for (int y = box.y0; y < box.y1; y++) {
+        memset(paintedMask.data() + (size_t)y * width + box.x0, 1, box.x1 - box.x0);
+    }
+}
+
+void GraphicsManager::beginOcclusion(const std::vector<DirtyRect>& rects) {
+    occluders.clear();
+    for (const DirtyRect& rect : rects) {
+        if (!rect.empty()) occluders.push_back(rect);
+    }
+}
+
+void GraphicsManager::endOcclusion() {
+    occluders.clear();
+}
+
+void GraphicsManager::setOverdrawTracking(bool enabled) {
+    if (enabled) {
+        paintedMask.assign((size_t)width * height, 0);
+    } else {
+        paintedMask.clear();
+        paintedMask.shrink_to_fit();
     }
 }
 
+void GraphicsManager::drawPixel(int x, int y, const Color& color) {
+    if (color.a == 0) return;
+    
+    DirtyRect box = { x, y, x + 1, y + 1 };
+    if (!visibleBounds(box)) return;
+    
+    uint32_t pixel = color.toPremultiplied();
+    if (recording) {
+        DrawCommand cmd;
+        cmd.type = DrawCommand::PIXEL;
+        cmd.p[0] = x;
+        cmd.p[1] = y;
+        cmd.color = pixel;
+        record(cmd, box);
+        return;
+    }
+    
+    rasterize([&](const auto& t) { Raster::plot(t, x, y, pixel); });
+}
+
+void GraphicsManager::drawPremultipliedPixel(int x, int y, uint32_t pixel) {
+    if (recording) {
+        drawPremultipliedSpan(x, y, &pixel, 1);
+        return;
+    }
+    
+    DirtyRect box = { x, y, x + 1, y + 1 };
+    if (!visibleBounds(box)) return;
+    
+    rasterize([&](const auto& t) { Raster::plot(t, x, y, pixel); });
+}
+
+// Строка готовых предумноженных пикселей (иконки, промежуточные буферы).
+// Глобальная прозрачность - один масштаб всех каналов источника.
+void GraphicsManager::drawPremultipliedSpan(int x, int y, const uint32_t* pixels, int count, float opacity) {
+    uint32_t o = Blend::opacityByte(opacity);
+    if (o == 0 || count <= 0) return;
+    
+    DirtyRect box = { x, y, x + count, y + 1 };
+    if (!visibleBounds(box)) return;
+    
+    if (recording) {
+        // В список попадает только видимая часть строки
+        DrawCommand cmd;
+        cmd.type = DrawCommand::IMAGE_SPAN;
+        cmd.p[0] = box.x0;
+        cmd.p[1] = y;
+        cmd.p[2] = box.x1 - box.x0;
+        cmd.p[3] = displayList->storePixels(pixels + (box.x0 - x), box.x1 - box.x0);
+        cmd.color = o;
+        record(cmd, box);
+        return;
+    }
+    
+    rasterize(box, [&](const auto& t) { Raster::blendSpan(t, x, y, pixels, count, o); });
+}
+
+Raster::Fixed GraphicsManager::fixedCoordinate(float v, bool round) const {
+    if (subpixel) return Raster::toFixed(v);
+    return Raster::toFixed(round ? (int)floorf(v + 0.5f) : (int)v);
+}
+
+Raster::Fixed GraphicsManager::circleCoordinate(float v, int radius) const {
+    if (radius <= Raster::SNAP_RADIUS) return Raster::toFixed((int)floorf(v + 0.5f));
+    return fixedCoordinate(v, true);
+}
+
+void GraphicsManager::drawLine(float x1, float y1, float x2, float y2, const Color& color, float thickness) {
+    if (color.a == 0) return;
+    drawLineSegment(fixedCoordinate(x1, false), fixedCoordinate(y1, false),
+                    fixedCoordinate(x2, false), fixedCoordinate(y2, false),
+                    color.toPremultiplied(), (int)(thickness * 256));
+}
+
+void GraphicsManager::drawLines(const LineSegment* segments, int count, float thickness) {
+    int width = (int)(thickness * 256);
+    for (int i = 0; i < count; i++) {
+        const LineSegment& s = segments[i];
+        if (s.color.a == 0) continue;
+        drawLineSegment(fixedCoordinate(s.x1, false), fixedCoordinate(s.y1, false),
+                        fixedCoordinate(s.x2, false), fixedCoordinate(s.y2, false),
+                        s.color.toPremultiplied(), width);
+    }
+}
+
+// Толщина передается в 1/256 пикселя, чтобы отложенный и прямой
+// режимы рисовали линию одной и той же ширины
+void GraphicsManager::drawLineSegment(Raster::Fixed x1, Raster::Fixed y1, Raster::Fixed x2, Raster::Fixed y2,
+                                      uint32_t pixel, int width) {
+    int pad = Raster::linePadding(width / 256.0f);
+    DirtyRect box = { Raster::fixedFloor(std::min(x1, x2)) - pad, Raster::fixedFloor(std::min(y1, y2)) - pad,
+                      Raster::fixedFloor(std::max(x1, x2)) + pad + 1, Raster::fixedFloor(std::max(y1, y2)) + pad + 1 };
+    if (!visibleBounds(box)) return;
+    
+    if (recording) {
+        DrawCommand cmd;
+        cmd.type = DrawCommand::LINE;
+        cmd.p[0] = x1;
+        cmd.p[1] = y1;
+        cmd.p[2] = x2;
+        cmd.p[3] = y2;
+        cmd.p[4] = width;
+        cmd.color = pixel;
+        record(cmd, box);
+        return;
+    }
+    
+    rasterize(box, [&](const auto& t) { Raster::drawLine(t, x1, y1, x2, y2, pixel, width / 256.0f); });
+}
+
+// Края прямоугольника - x и x + width: с дробными краями крайние
+// пиксели получают закрытую долю площади
 void GraphicsManager::drawRect(float x, float y, float width, float height, const Color& color) {
-    int ix = (int)x, iy = (int)y;
-    int iw = (int)width, ih = (int)height;
+    if (color.a == 0) return;
     
-    for (int py = iy; py < iy + ih; py++) {
-        for (int px = ix; px < ix + iw; px++) {
-            drawPixel(px, py, color);
-        }
+    Raster::Fixed fx = fixedCoordinate(x, false), fy = fixedCoordinate(y, false);
+    Raster::Fixed fw = fixedCoordinate(width, false), fh = fixedCoordinate(height, false);
+    uint32_t pixel = color.toPremultiplied();
+    
+    DirtyRect box = { Raster::fixedFloor(fx), Raster::fixedFloor(fy),
+                      Raster::fixedCeil(fx + fw), Raster::fixedCeil(fy + fh) };
+    if (!visibleBounds(box)) return;
+    
+    if (recording) {
+        DrawCommand cmd;
+        cmd.type = DrawCommand::RECT;
+        cmd.p[0] = fx;
+        cmd.p[1] = fy;
+        cmd.p[2] = fw;
+        cmd.p[3] = fh;
+        cmd.color = pixel;
+        record(cmd, box);
+        return;
     }
+    
+    rasterize(box, [&](const auto& t) { Raster::fillRectFixed(t, fx, fy, fw, fh, pixel); });
 }
 
+// Размеры и радиус - целые пиксели, дробным может быть только положение
 void GraphicsManager::drawRoundedRect(float x, float y, float width, float height, float radius, const Color& color) {
-    int ix = (int)x, iy = (int)y;
+    if (color.a == 0) return;
+    
+    Raster::Fixed fx = fixedCoordinate(x, false), fy = fixedCoordinate(y, false);
     int iw = (int)width, ih = (int)height;
-    int ir = (int)radius;
-    
-    // Основной прямоугольник
-    drawRect(x + radius, y, width - 2 * radius, height, color);
-    drawRect(x, y + radius, width, height - 2 * radius, color);
-    
-    // Углы
-    for (int py = 0; py < ir; py++) {
-        for (int px = 0; px < ir; px++) {
-            float dist = sqrt((px - ir) * (px - ir) + (py - ir) * (py - ir));
-            if (dist <= ir) {
-                // Верхний левый
-                drawPixel(ix + px, iy + py, color);
-                // Верхний правый
-                drawPixel(ix + iw - ir + px, iy + py, color);
-                // Нижний левый
-                drawPixel(ix + px, iy + ih - ir + py, color);
-                // Нижний правый
-                drawPixel(ix + iw - ir + px, iy + ih - ir + py, color);
-            }
-        }
+    uint32_t pixel = color.toPremultiplied();
+    
+    DirtyRect box = { Raster::fixedFloor(fx), Raster::fixedFloor(fy),
+                      Raster::fixedCeil(fx + Raster::toFixed(iw)), Raster::fixedCeil(fy + Raster::toFixed(ih)) };
+    if (!visibleBounds(box)) return;
+    
+    if (recording) {
+        DrawCommand cmd;
+        cmd.type = DrawCommand::ROUNDED_RECT;
+        cmd.p[0] = fx;
+        cmd.p[1] = fy;
+        cmd.p[2] = iw;
+        cmd.p[3] = ih;
+        cmd.p[4] = (int)radius;
+        cmd.color = pixel;
+        record(cmd, box);
+        return;
     }
+    
+    rasterize(box, [&](const auto& t) { Raster::fillRoundedRect(t, fx, fy, iw, ih, (int)radius, pixel); });
 }
 
 void GraphicsManager::drawCircle(float x, float y, float radius, const Color& color) {
-    int ix = (int)x, iy = (int)y;
-    int ir = (int)radius;
+    if (color.a == 0) return;
     
-    for (int py = -ir; py <= ir; py++) {
-        for (int px = -ir; px <= ir; px++) {
-            if (px * px + py * py <= ir * ir) {
-                drawPixel(ix + px, iy + py, color);
-            }
+    // Радиус округляется, ненулевой круг занимает хотя бы 2x2 пикселя;
+    // центр в 24.8 (без субпиксельной точности и у мелких кругов - ближайший угол пикселя)
+    int ir = radius > 0 ? std::max(1, (int)(radius + 0.5f)) : 0;
+    if (ir == 0) return;
+    Raster::Fixed cx = circleCoordinate(x, ir), cy = circleCoordinate(y, ir);
+    uint32_t pixel = color.toPremultiplied();
+    
+    Raster::Fixed fr = Raster::toFixed(ir);
+    DirtyRect box = { Raster::fixedFloor(cx - fr), Raster::fixedFloor(cy - fr),
+                      Raster::fixedCeil(cx + fr), Raster::fixedCeil(cy + fr) };
+    if (!visibleBounds(box)) return;
+    
+    if (recording) {
+        DrawCommand cmd;
+        cmd.type = DrawCommand::CIRCLE;
+        cmd.p[0] = cx;
+        cmd.p[1] = cy;
+        cmd.p[2] = ir;
+        cmd.color = pixel;
+        record(cmd, box);
+        return;
+    }
+    
+    rasterize(box, [&](const auto& t) { Raster::fillCircle(t, cx, cy, ir, pixel); });
+}
+
+// Пакет переводится в 24.8 и сразу растеризуется одним проходом, а в отложенном
+// режиме записывается одной командой: список отображения сам раскладывает круги
+// по тайлам, и каждый тайл рисует только свои.
+void GraphicsManager::drawCircles(const float* xs, const float* ys, const float* radii, const uint32_t* rgba, int count) {
+    batchX.clear();
+    batchY.clear();
+    batchRadius.clear();
+    batchPixels.clear();
+    DirtyRect bounds = { INT32_MAX, INT32_MAX, INT32_MIN, INT32_MIN };
+    
+    for (int i = 0; i < count; i++) {
+        if ((rgba[i] & 0xFF) == 0 || radii[i] <= 0) continue;
+        
+        int ir = std::max(1, (int)(radii[i] + 0.5f));
+        Raster::Fixed cx = circleCoordinate(xs[i], ir), cy = circleCoordinate(ys[i], ir);
+        Raster::Fixed fr = Raster::toFixed(ir);
+        DirtyRect box = { Raster::fixedFloor(cx - fr), Raster::fixedFloor(cy - fr),
+                          Raster::fixedCeil(cx + fr), Raster::fixedCeil(cy + fr) };
+        if (!visibleBounds(box, recording)) continue;
+        
+        batchX.push_back(cx);
+        batchY.push_back(cy);
+        batchRadius.push_back(ir);
+        batchPixels.push_back(Blend::premultiply(rgba[i]));
+        bounds = { std::min(bounds.x0, box.x0), std::min(bounds.y0, box.y0),
+                   std::max(bounds.x1, box.x1), std::max(bounds.y1, box.y1) };
+    }
+    if (batchPixels.empty()) return;
+    
+    if (recording) {
+        DrawCommand cmd;
+        cmd.type = DrawCommand::CIRCLES;
+        cmd.p[0] = displayList->storeCircles(batchX.data(), batchY.data(), batchRadius.data(),
+                                             batchPixels.data(), (int)batchPixels.size());
+        cmd.p[1] = (int32_t)batchPixels.size();
+        record(cmd, bounds);
+    } else {
+        rasterize([&](const auto& t) {
+            Raster::fillCircles(t, batchX.data(), batchY.data(), batchRadius.data(),
+                                batchPixels.data(), (int)batchPixels.size(), batchScratch);
+        });
+    }
+}
+
+void GraphicsManager::drawPoints(const float* xs, const float* ys, const uint32_t* rgba, int count) {
+    batchX.clear();
+    batchY.clear();
+    batchPixels.clear();
+    
+    for (int i = 0; i < count; i++) {
+        int ix = (int)xs[i], iy = (int)ys[i];
+        if ((rgba[i] & 0xFF) == 0) continue;
+        DirtyRect box = { ix, iy, ix + 1, iy + 1 };
+        if (!visibleBounds(box)) continue;
+        uint32_t pixel = Blend::premultiply(rgba[i]);
+        
+        if (recording) {
+            DrawCommand cmd;
+            cmd.type = DrawCommand::PIXEL;
+            cmd.p[0] = ix;
+            cmd.p[1] = iy;
+            cmd.color = pixel;
+            record(cmd, box);
+            continue;
         }
+        
+        batchX.push_back(ix);
+        batchY.push_back(iy);
+        batchPixels.push_back(pixel);
+    }
+    
+    if (!batchPixels.empty()) {
+        rasterize([&](const auto& t) {
+            Raster::plotPoints(t, batchX.data(), batchY.data(), batchPixels.data(), (int)batchPixels.size(),
+                               batchScratch);
+        });
+    }
+}
+
+void GraphicsManager::drawTriangle(float x1, float y1, float x2, float y2, float x3, float y3,
+                                   const Color& color, bool antialias) {
+    float xs[3] = { x1, x2, x3 };
+    float ys[3] = { y1, y2, y3 };
+    drawPolygon(xs, ys, 3, color, antialias);
+}
+
+void GraphicsManager::drawPolygon(const float* xs, const float* ys, int count, const Color& color, bool antialias) {
+    if (color.a == 0 || count < 3 || count > Raster::MAX_POLYGON_VERTICES) return;
+    
+    // Вершины в 24.8; без субпиксельной точности - округление до целых
+    Raster::Fixed points[2 * Raster::MAX_POLYGON_VERTICES];
+    int x0 = INT32_MAX, y0 = INT32_MAX, x1 = INT32_MIN, y1 = INT32_MIN;
+    for (int i = 0; i < count; i++) {
+        points[2 * i] = fixedCoordinate(xs[i], true);
+        points[2 * i + 1] = fixedCoordinate(ys[i], true);
+        x0 = std::min(x0, points[2 * i]);
+        y0 = std::min(y0, points[2 * i + 1]);
+        x1 = std::max(x1, points[2 * i]);
+        y1 = std::max(y1, points[2 * i + 1]);
+    }
+    uint32_t pixel = color.toPremultiplied();
+    
+    DirtyRect box = { Raster::fixedFloor(x0) - 1, Raster::fixedFloor(y0) - 1,
+                      Raster::fixedFloor(x1) + 2, Raster::fixedFloor(y1) + 2 };
+    if (!visibleBounds(box)) return;
+    
+    if (recording) {
+        DrawCommand cmd;
+        cmd.type = DrawCommand::POLYGON;
+        cmd.p[0] = count;
+        cmd.p[1] = displayList->storePixels((const uint32_t*)points, 2 * count);
+        cmd.p[2] = antialias;
+        cmd.color = pixel;
+        record(cmd, box);
+        return;
     }
+    
+    rasterize(box, [&](const auto& t) { Raster::fillPolygon(t, points, count, pixel, antialias); });
 }
 
-void GraphicsManager::drawGradient(float x, float y, float width, float height, 
+void GraphicsManager::drawGradient(float x, float y, float width, float height,
                                  const Color& startColor, const Color& endColor, bool vertical) {
     int ix = (int)x, iy = (int)y;
     int iw = (int)width, ih = (int)height;
     
-    for (int py = 0; py < ih; py++) {
-        for (int px = 0; px < iw; px++) {
-            float t = vertical ? (float)py / ih : (float)px / iw;
-            
-            uint8_t r = (uint8_t)(startColor.r + t * (endColor.r - startColor.r));
-            uint8_t g = (uint8_t)(startColor.g + t * (endColor.g - startColor.g));
-            uint8_t b = (uint8_t)(startColor.b + t * (endColor.b - startColor.b));
-            uint8_t a = (uint8_t)(startColor.a + t * (endColor.a - startColor.a));
-            
-            drawPixel(ix + px, iy + py, Color(r, g, b, a));
-        }
+    DirtyRect box = { ix, iy, ix + iw, iy + ih };
+    if (!visibleBounds(box)) return;
+    
+    if (recording) {
+        DrawCommand cmd;
+        cmd.type = DrawCommand::GRADIENT;
+        cmd.vertical = vertical;
+        cmd.p[0] = ix;
+        cmd.p[1] = iy;
+        cmd.p[2] = iw;
+        cmd.p[3] = ih;
+        cmd.dither = dithering;
+        cmd.startColor = startColor;
+        cmd.endColor = endColor;
+        record(cmd, box);
+        return;
+    }
+    
+    rasterize(box, [&](const auto& t) {
+        Raster::fillGradient(t, ix, iy, iw, ih, startColor, endColor, vertical, dithering);
+    });
+}
+
+void GraphicsManager::drawRadialGradient(float x, float y, float radius,
+                                         const Color& innerColor, const Color& outerColor) {
+    // Центр и радиус привязываются к сетке так же, как у drawCircle
+    int ix = (int)floorf(x + 0.5f), iy = (int)floorf(y + 0.5f);
+    int ir = (int)(radius + 0.5f);
+    if (ir <= 0 || (innerColor.a == 0 && outerColor.a == 0)) return;
+    
+    DirtyRect box = { ix - ir, iy - ir, ix + ir, iy + ir };
+    if (!visibleBounds(box)) return;
+    
+    if (recording) {
+        DrawCommand cmd;
+        cmd.type = DrawCommand::RADIAL_GRADIENT;
+        cmd.dither = dithering;
+        cmd.p[0] = ix;
+        cmd.p[1] = iy;
+        cmd.p[2] = ir;
+        cmd.startColor = innerColor;
+        cmd.endColor = outerColor;
+        record(cmd, box);
+        return;
     }
+    
+    rasterize(box, [&](const auto& t) {
+        Raster::fillRadialGradient(t, ix, iy, ir, innerColor, outerColor, dithering);
+    });
 }
 
 // drawText реализован в font_renderer.cpp
 
 void GraphicsManager::drawTextCentered(const std::string& text, float x, float y, float width, const Color& color, int fontSize) {
-    float textWidth = text.length() * (fontSize / 2);
+    int textWidth, textHeight;
+    getTextSize(text, fontSize, textWidth, textHeight);
     float startX = x + (width - textWidth) / 2;
     drawText(text, startX, y, color, fontSize);
 }
 
+// Nine-patch вокруг фигуры (x, y, w, h): работа пропорциональна периметру.
+// Если фигура меньше двух углов патча, углы обрезаются по середине.
+void GraphicsManager::drawNinePatch(const NinePatch& patch, int x, int y, int w, int h) {
+    const Surface& surface = patch.surface;
+    int size = surface.getWidth();
+    int c = patch.corner;
+    
+    int X = x - patch.pad, Y = y - patch.pad;
+    int W = w + 2 * patch.pad, H = h + 2 * patch.pad;
+    int left = std::min(c, W / 2), right = std::min(c, W - left);
+    int top = std::min(c, H / 2), bottom = std::min(c, H - top);
+    int midW = W - left - right, midH = H - top - bottom;
+    
+    // Верхний ряд: угол, растянутая строка, угол
+    drawSurfaceRegion(surface, 0, 0, left, top, X, Y, left, top);
+    drawSurfaceRegion(surface, c, 0, 1, top, X + left, Y, midW, top);
+    drawSurfaceRegion(surface, size - right, 0, right, top, X + W - right, Y, right, top);
+    
+    // Средний ряд: стороны и сплошная середина
+    drawSurfaceRegion(surface, 0, c, left, 1, X, Y + top, left, midH);
+    drawSurfaceRegion(surface, c, c, 1, 1, X + left, Y + top, midW, midH);
+    drawSurfaceRegion(surface, size - right, c, right, 1, X + W - right, Y + top, right, midH);
+    
+    // Нижний ряд
+    drawSurfaceRegion(surface, 0, size - bottom, left, bottom, X, Y + H - bottom, left, bottom);
+    drawSurfaceRegion(surface, c, size - bottom, 1, bottom, X + left, Y + H - bottom, midW, bottom);
+    drawSurfaceRegion(surface, size - right, size - bottom, right, bottom, X + W - right, Y + H - bottom, right, bottom);
+}
+
+// Видна ли фигура с полями pad со всех сторон: проверка до обращения к кэшу теней
+bool GraphicsManager::shapeVisible(int x, int y, int w, int h, int pad) {
+    DirtyRect box = { x - pad, y - pad, x + w + pad, y + h + pad };
+    DirtyRect visible;
+    if (visibleArea(box, visible)) return true;
+    if (!box.empty()) stats.culled++;
+    return false;
+}
+
 void GraphicsManager::drawShadow(float x, float y, float width, float height, float radius, float opacity) {
-    Color shadowColor(0, 0, 0, (uint8_t)(255 * opacity));
+    int iw = (int)width, ih = (int)height;
+    if (iw <= 0 || ih <= 0) return;
+    
+    // Тень смещена вниз-вправо на половину радиуса и размыта на другую половину
+    int blur = std::max(1, (int)radius / 2);
+    int offset = (int)radius - blur;
+    int corner = std::min(8, std::min(iw, ih) / 2);
+    uint32_t color = Color(0, 0, 0, Blend::opacityByte(opacity)).toPremultiplied();
+    if (color == 0) return;
     
-    // Рисуем размытую тень
-    for (int offset = 0; offset < (int)radius; offset++) {
-        uint8_t alpha = (uint8_t)(255 * opacity * (1.0f - (float)offset / radius));
-        Color blurColor(0, 0, 0, alpha);
-        drawRoundedRect(x + offset, y + offset, width, height, 8, blurColor);
+    // Патч строится или вытесняется из кэша только для видимой тени;
+    // она выходит за фигуру на blur пикселей
+    if (!shapeVisible((int)x + offset, (int)y + offset, iw, ih, blur)) return;
+    
+    const NinePatch* patch = shadows->get(corner, blur, color);
+    if (!patch) {
+        // Все патчи заняты еще не растеризованным кадром. flush() возвращает
+        // рисование в кадр, поэтому тень в поверхность идет в ту же поверхность
+        Surface* surface = renderTarget;
+        flush();
+        setTarget(surface);
+        shadows->beginFrame();
+        patch = shadows->get(corner, blur, color);
+        if (!patch) return;
     }
+    drawNinePatch(*patch, (int)x + offset, (int)y + offset, iw, ih);
 }
 
 void GraphicsManager::drawGlow(float x, float y, float width, float height, const Color& color, float intensity) {
-    for (int offset = 5; offset > 0; offset--) {
-        uint8_t alpha = (uint8_t)(255 * intensity * (float)offset / 5.0f);
-        Color glowColor(color.r, color.g, color.b, alpha);
-        drawRoundedRect(x - offset, y - offset, width + 2 * offset, height + 2 * offset, 8 + offset, glowColor);
+    int iw = (int)width, ih = (int)height;
+    if (iw <= 0 || ih <= 0) return;
+    
+    // Свечение - размытие на 5 пикселей во все стороны от фигуры
+    int corner = std::min(8, std::min(iw, ih) / 2);
+    uint32_t glow = Color(color.r, color.g, color.b, Blend::opacityByte(intensity)).toPremultiplied();
+    if (glow == 0) return;
+    
+    if (!shapeVisible((int)x, (int)y, iw, ih, 5)) return;
+    
+    const NinePatch* patch = shadows->get(corner, 5, glow);
+    if (!patch) {
+        Surface* surface = renderTarget;
+        flush();
+        setTarget(surface);
+        shadows->beginFrame();
+        patch = shadows->get(corner, 5, glow);
+        if (!patch) return;
     }
+    drawNinePatch(*patch, (int)x, (int)y, iw, ih);
 }
 
 // Реализация Button
@@ -265,10 +1020,16 @@ void Panel::render(float deltaTime) {
         GFX->drawRoundedRect(x - 1, y - 1, width + 2, height + 2, cornerRadius + 1, borderGlow);
     }
     
-    // Дочерние элементы
+    // Дочерние элементы обрезаются по панели; целиком невидимые не рисуются.
+    // У элементов без размера (Label) границы неизвестны - они рисуются всегда.
+    GFX->pushClip((int)x, (int)y, (int)width, (int)height);
     for (auto& child : children) {
+        if (!child->visible) continue;
+        if (child->width > 0 && child->height > 0 &&
+            GFX->isClipped(child->x, child->y, child->width, child->height)) continue;
         child->render(deltaTime);
     }
+    GFX->popClip();
 }
 
 void Panel::update(float deltaTime) {
@@ -286,7 +1047,45 @@ bool Panel::handleInput(u64 kDown, float touchX, float touchY) {
     return false;
 }
 
+// Градиент закрывает панель целиком, скругленный прямоугольник - крест
+// без углов. Дочерние элементы видны только внутри панели.
+void Panel::collectOccluders(std::vector<DirtyRect>& out) const {
+    if (!visible) return;
+    
+    int ix = (int)x, iy = (int)y;
+    int iw = (int)width, ih = (int)height;
+    DirtyRect bounds = { ix, iy, ix + iw, iy + ih };
+    if (bounds.empty()) return;
+    
+    if (useGradient) {
+        if (gradientStart.a == 255 && gradientEnd.a == 255) out.push_back(bounds);
+    } else if (backgroundColor.a == 255) {
+        // Фон может стоять на долях пикселя: перекрывают только полностью закрытые
+        // пиксели, от ceil(x) до floor(x) + width
+        Raster::Fixed fx = GFX->isSubpixelPrecision() ? Raster::toFixed(x) : Raster::toFixed(ix);
+        Raster::Fixed fy = GFX->isSubpixelPrecision() ? Raster::toFixed(y) : Raster::toFixed(iy);
+        DirtyRect solid = { Raster::fixedCeil(fx), Raster::fixedCeil(fy),
+                            Raster::fixedFloor(fx) + iw, Raster::fixedFloor(fy) + ih };
+        int r = std::min((int)cornerRadius, std::min(iw, ih) / 2);
+        out.push_back({ solid.x0, solid.y0 + r, solid.x1, solid.y1 - r });
+        out.push_back({ solid.x0 + r, solid.y0, solid.x1 - r, solid.y1 });
+    }
+    
+    size_t first = out.size();
+    for (auto& child : children) {
+        child->collectOccluders(out);
+    }
+    for (size_t i = first; i < out.size(); i++) {
+        DirtyRect& rect = out[i];
+        rect = { std::max(rect.x0, bounds.x0), std::max(rect.y0, bounds.y0),
+                 std::min(rect.x1, bounds.x1), std::min(rect.y1, bounds.y1) };
+    }
+}
+
+// Координаты дочернего элемента задаются относительно панели
 void Panel::addChild(std::unique_ptr<UIElement> child) {
+    child->x += x;
+    child->y += y;
     children.push_back(std::move(child));
 }
 
@@ -0,0 +1,250 @@
+#include "headless_platform.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+namespace {
+
+    struct ButtonName {
+        const char* name;
+        u64 mask;
+    };
+    
+    const ButtonName BUTTONS[] = {
+        { "A", HidNpadButton_A }, { "B", HidNpadButton_B },
+        { "X", HidNpadButton_X }, { "Y", HidNpadButton_Y },
+        { "L", HidNpadButton_L }, { "R", HidNpadButton_R },
+        { "ZL", HidNpadButton_ZL }, { "ZR", HidNpadButton_ZR },
+        { "Plus", HidNpadButton_Plus }, { "Minus", HidNpadButton_Minus },
+        { "Left", HidNpadButton_Left }, { "Up", HidNpadButton_Up },
+        { "Right", HidNpadButton_Right }, { "Down", HidNpadButton_Down }
+    };
+    
+    u64 parseButtons(const std::string& text) {
+        u64 buttons = 0;
+        std::stringstream stream(text);
+        std::string name;
+        while (std::getline(stream, name, '+')) {
+            for (const ButtonName& button : BUTTONS) {
+                if (name == button.name) buttons |= button.mask;
+            }
+        }
+        return buttons;
+    }
+    
+    // Кадр хранится как предумноженный RGBA (r в старшем байте);
+    // кадр дисплея непрозрачен, поэтому альфа отбрасывается
+    void toRGB(const uint32_t* pixels, uint32_t count, uint8_t* out) {
+        for (uint32_t i = 0; i < count; i++) {
+            out[3 * i] = pixels[i] >> 24;
+            out[3 * i + 1] = (pixels[i] >> 16) & 0xFF;
+            out[3 * i + 2] = (pixels[i] >> 8) & 0xFF;
+        }
+    }
+    
+    bool writePPM(const std::string& path, const uint32_t* pixels, uint32_t width, uint32_t height) {
+        FILE* file = fopen(path.c_str(), "wb");
+        if (!file) return false;
+        
+        fprintf(file, "P6\n%u %u\n255\n", width, height);
+        std::vector<uint8_t> row(width * 3);
+        bool ok = true;
+        for (uint32_t y = 0; y < height && ok; y++) {
+            toRGB(pixels + y * width, width, row.data());
+            ok = fwrite(row.data(), 1, row.size(), file) == row.size();
+        }
+        fclose(file);
+        return ok;
+    }
+    
+    uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0) {
+        static uint32_t table[256];
+        if (!table[1]) {
+            for (uint32_t n = 0; n < 256; n++) {
+                uint32_t c = n;
+                for (int k = 0; k < 8; k++) {
+                    c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                }
+                table[n] = c;
+            }
+        }
+        
+        crc = ~crc;
+        for (size_t i = 0; i < size; i++) {
+            crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        }
+        return ~crc;
+    }
+    
+    void putBE32(std::vector<uint8_t>& out, uint32_t value) {
+        out.push_back(value >> 24);
+        out.push_back(value >> 16);
+        out.push_back(value >> 8);
+        out.push_back(value);
+    }
+    
+    void writeChunk(FILE* file, const char* type, const std::vector<uint8_t>& data) {
+        std::vector<uint8_t> chunk;
+        putBE32(chunk, (uint32_t)data.size());
+        chunk.insert(chunk.end(), type, type + 4);
+        chunk.insert(chunk.end(), data.begin(), data.end());
+        putBE32(chunk, crc32(chunk.data() + 4, chunk.size() - 4));
+        fwrite(chunk.data(), 1, chunk.size(), file);
+    }
+    
+    // PNG без сжатия: zlib-поток из несжатых блоков deflate. Файл
+    // больше, зато не нужна внешняя библиотека, а запись почти бесплатна.
+    bool writePNG(const std::string& path, const uint32_t* pixels, uint32_t width, uint32_t height) {
+        FILE* file = fopen(path.c_str(), "wb");
+        if (!file) return false;
+        
+        static const uint8_t SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+        fwrite(SIGNATURE, 1, sizeof(SIGNATURE), file);
+        
+        std::vector<uint8_t> header;
+        putBE32(header, width);
+        putBE32(header, height);
+        header.push_back(8);    // Бит на канал
+        header.push_back(2);    // RGB
+        header.push_back(0);
+        header.push_back(0);
+        header.push_back(0);
+        writeChunk(file, "IHDR", header);
+        
+        // Строки с фильтром 0 перед каждой
+        size_t stride = width * 3 + 1;
+        std::vector<uint8_t> raw(stride * height);
+        for (uint32_t y = 0; y < height; y++) {
+            raw[y * stride] = 0;
+            toRGB(pixels + y * width, width, &raw[y * stride + 1]);
+        }
+        
+        std::vector<uint8_t> data = { 0x78, 0x01 };
+        const size_t BLOCK = 65535;
+        for (size_t offset = 0; offset < raw.size(); offset += BLOCK) {
+            size_t size = std::min(BLOCK, raw.size() - offset);
+            data.push_back(offset + size == raw.size() ? 1 : 0);
+            data.push_back(size & 0xFF);
+            data.push_back(size >> 8);
+            data.push_back(~size & 0xFF);
+            data.push_back((~size >> 8) & 0xFF);
+            data.insert(data.end(), raw.begin() + offset, raw.begin() + offset + size);
+        }
+        
+        uint32_t a = 1, b = 0;
+        for (uint8_t byte : raw) {
+            a = (a + byte) % 65521;
+            b = (b + a) % 65521;
+        }
+        putBE32(data, (b << 16) | a);
+        writeChunk(file, "IDAT", data);
+        writeChunk(file, "IEND", std::vector<uint8_t>());
+        
+        bool ok = !ferror(file);
+        fclose(file);
+        return ok;
+    }
+}
+
+HeadlessPlatform::HeadlessPlatform()
+    : width(0), height(0), current(0), frame(0), frameLimit(0), timestep(0), dumpEvery(0) {
+}
+
+bool HeadlessPlatform::initialize(uint32_t w, uint32_t h) {
+    if (w == 0 || h == 0) return false;
+    
+    width = w;
+    height = h;
+    for (int i = 0; i < 2; i++) {
+        buffers[i].reset(new uint32_t[(size_t)width * height]());
+    }
+    current = 0;
+    frame = 0;
+    start = std::chrono::steady_clock::now();
+    return true;
+}
+
+void HeadlessPlatform::shutdown() {
+    buffers[0].reset();
+    buffers[1].reset();
+}
+
+uint32_t* HeadlessPlatform::getFramebuffer(uint32_t* w, uint32_t* h) {
+    if (w) *w = width;
+    if (h) *h = height;
+    return buffers[current].get();
+}
+
+void HeadlessPlatform::present() {
+    current ^= 1;
+    finishFrame();
+}
+
+void HeadlessPlatform::waitForVsync() {
+    finishFrame();
+}
+
+void HeadlessPlatform::finishFrame() {
+    if (dumpEvery > 0 && frame % dumpEvery == 0) {
+        char number[16];
+        snprintf(number, sizeof(number), "%05d", frame);
+        dumpFrame(dumpPrefix + number + dumpExtension);
+    }
+    frame++;
+}
+
+uint64_t HeadlessPlatform::getTicks() {
+    if (timestep > 0) {
+        return (uint64_t)(frame * timestep * getTickFrequency());
+    }
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool HeadlessPlatform::mainLoop() {
+    return frameLimit <= 0 || frame < frameLimit;
+}
+
+u64 HeadlessPlatform::pollButtonsDown() {
+    auto it = script.find(frame);
+    return it != script.end() ? it->second : 0;
+}
+
+Result HeadlessPlatform::createDirectory(const std::string& path) {
+    return MAKERESULT(Module_Libnx, LibnxError_NotFound);
+}
+
+void HeadlessPlatform::pressAt(int at, u64 buttons) {
+    script[at] |= buttons;
+}
+
+bool HeadlessPlatform::loadInputScript(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.good()) return false;
+    
+    std::string line;
+    while (std::getline(file, line)) {
+        std::stringstream stream(line);
+        int at;
+        std::string buttons;
+        if (line.empty() || line[0] == '#' || !(stream >> at >> buttons)) continue;
+        pressAt(at, parseButtons(buttons));
+    }
+    return true;
+}
+
+void HeadlessPlatform::setFrameDump(const std::string& prefix, int every, const std::string& extension) {
+    dumpPrefix = prefix;
+    dumpEvery = every;
+    dumpExtension = extension;
+}
+
+bool HeadlessPlatform::dumpFrame(const std::string& path) const {
+    const uint32_t* pixels = getPresentedFrame();
+    if (!pixels) return false;
+    
+    bool png = path.size() >= 4 && path.compare(path.size() - 4, 4, ".png") == 0;
+    return png ? writePNG(path, pixels, width, height) : writePPM(path, pixels, width, height);
+}
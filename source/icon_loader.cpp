@@ -3,6 +3,7 @@
 #include <cmath>
 #include <fstream>
 #include <vector>
+#include <algorithm>
 
 IconLoader* IconLoader::instance = nullptr;
 
@@ -131,20 +132,17 @@ bool IconLoader::loadIcon(const std::string& filepath, const std::string& name)
     }
     
     // Create icon entry with enhanced metadata
-    IconData iconData;
-    iconData.width = std::min(jpegInfo.width, 128u); // Limit size for performance
-    iconData.height = std::min(jpegInfo.height, 128u);
-    iconData.data.resize(iconData.width * iconData.height * 4); // RGBA
+    int width = std::min(jpegInfo.width, 128); // Limit size for performance
+    int height = std::min(jpegInfo.height, 128);
+    auto pixels = std::make_unique<uint32_t[]>(width * height);
     
     // Simple JPEG to RGBA conversion (placeholder for actual JPEG decoder)
     // For now, create a beautiful gradient placeholder that represents the icon
-    for (uint32_t y = 0; y < iconData.height; y++) {
-        for (uint32_t x = 0; x < iconData.width; x++) {
-            uint32_t idx = (y * iconData.width + x) * 4;
-            
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
             // Create beautiful gradient based on file characteristics
-            float fx = (float)x / iconData.width;
-            float fy = (float)y / iconData.height;
+            float fx = (float)x / width;
+            float fy = (float)y / height;
             
             // Use file size to influence colors
             uint8_t r = (uint8_t)(64 + (fileSize % 128) + fx * 64);
@@ -159,14 +157,12 @@ bool IconLoader::loadIcon(const std::string& filepath, const std::string& name)
                 b = std::min(255, b + 32);
             }
             
-            iconData.data[idx] = r;
-            iconData.data[idx + 1] = g;
-            iconData.data[idx + 2] = b;
-            iconData.data[idx + 3] = a;
+            pixels[y * width + x] = Color(r, g, b, a).toPremultiplied();
         }
     }
     
-    icons[name] = std::move(iconData);
+    iconCache[name] = std::move(pixels);
+    iconSizes[name] = {width, height};
     return true;
 }
 
@@ -212,77 +208,21 @@ void IconLoader::drawIcon(const std::string& name, float x, float y, float scale
     int width, height;
     uint32_t* pixels = getIcon(name, width, height);
     
-    if (!pixels) return;
-    
-    float scaledWidth = width * scale;
-    float scaledHeight = height * scale;
+    if (!pixels || scale <= 0.0f) return;
     
-    // Simple icon rendering with rotation and alpha
-    for (int py = 0; py < (int)scaledHeight; py++) {
-        for (int px = 0; px < (int)scaledWidth; px++) {
-            float fx = px / scale;
-            float fy = py / scale;
-            
-            if (fx >= 0 && fx < width && fy >= 0 && fy < height) {
-                int srcX = (int)fx;
-                int srcY = (int)fy;
-                uint32_t pixel = pixels[srcY * width + srcX];
-                
-                // Apply alpha
-                uint8_t r = (pixel >> 24) & 0xFF;
-                uint8_t g = (pixel >> 16) & 0xFF;
-                uint8_t b = (pixel >> 8) & 0xFF;
-                uint8_t a = ((pixel & 0xFF) * (uint8_t)(alpha * 255)) >> 8;
-                
-                Color color(r, g, b, a);
-                
-                // Apply rotation if needed
-                float renderX = x + px;
-                float renderY = y + py;
-                
-                if (rotation != 0.0f) {
-                    float centerX = x + scaledWidth / 2;
-                    float centerY = y + scaledHeight / 2;
-                    float dx = renderX - centerX;
-                    float dy = renderY - centerY;
-                    
-                    renderX = centerX + dx * cos(rotation) - dy * sin(rotation);
-                    renderY = centerY + dx * sin(rotation) + dy * cos(rotation);
-                }
-                
-                GFX->drawPixel((int)renderX, (int)renderY, color);
-            }
-        }
-    }
+    // The cache holds premultiplied pixels, so scale, rotation and opacity
+    // are a single inverse-mapped pass over the destination pixels
+    GFX->drawImage(pixels, width, width, height, x, y, scale, scale, rotation, alpha);
 }
 
 void IconLoader::drawIconScaled(const std::string& name, float x, float y, float width, float height, float alpha) {
     int iconWidth, iconHeight;
     uint32_t* pixels = getIcon(name, iconWidth, iconHeight);
     
-    if (!pixels) return;
+    if (!pixels || width <= 0 || height <= 0) return;
     
-    for (int py = 0; py < (int)height; py++) {
-        for (int px = 0; px < (int)width; px++) {
-            float fx = (px / width) * iconWidth;
-            float fy = (py / height) * iconHeight;
-            
-            int srcX = (int)fx;
-            int srcY = (int)fy;
-            
-            if (srcX >= 0 && srcX < iconWidth && srcY >= 0 && srcY < iconHeight) {
-                uint32_t pixel = pixels[srcY * iconWidth + srcX];
-                
-                uint8_t r = (pixel >> 24) & 0xFF;
-                uint8_t g = (pixel >> 16) & 0xFF;
-                uint8_t b = (pixel >> 8) & 0xFF;
-                uint8_t a = ((pixel & 0xFF) * (uint8_t)(alpha * 255)) >> 8;
-                
-                Color color(r, g, b, a);
-                GFX->drawPixel(x + px, y + py, color);
-            }
-        }
-    }
+    GFX->drawImage(pixels, iconWidth, iconWidth, iconHeight, x, y,
+                   width / iconWidth, height / iconHeight, 0.0f, alpha);
 }
 
 void IconLoader::generateGradientIcon(const std::string& name, int size, const Color& color1, const Color& color2) {
@@ -297,7 +237,7 @@ void IconLoader::generateGradientIcon(const std::string& name, int size, const C
             uint8_t b = (uint8_t)(color1.b * (1 - t) + color2.b * t);
             uint8_t a = (uint8_t)(color1.a * (1 - t) + color2.a * t);
             
-            pixels[y * size + x] = (r << 24) | (g << 16) | (b << 8) | a;
+            pixels[y * size + x] = Color(r, g, b, a).toPremultiplied();
         }
     }
     
@@ -315,40 +255,56 @@ void IconLoader::generateGeometricIcon(const std::string& name, int size, const
     float centerY = size / 2.0f;
     float radius = size * 0.4f;
     
+    // Coverage mask goes into the alpha channel first. Convex shapes are
+    // rasterized with anti-aliased spans; the rest use an analytic test,
+    // with the shape resolved once instead of per pixel.
+    Raster::Target mask(pixels.get(), size, 0, 0, size, size);
+    if (shape == "circle") {
+        Raster::fillCircle(mask, Raster::toFixed(size / 2), Raster::toFixed(size / 2), (int)(radius + 0.5f), 0xFFFFFFFF);
+    } else if (shape == "diamond" || shape == "hexagon") {
+        int sides = shape == "diamond" ? 4 : 6;
+        Raster::Fixed points[2 * 6];
+        for (int i = 0; i < sides; i++) {
+            float angle = (float)(i * 2 * M_PI / sides - M_PI / 2);
+            points[2 * i] = Raster::toFixed((float)(centerX + cos(angle) * radius));
+            points[2 * i + 1] = Raster::toFixed((float)(centerY + sin(angle) * radius));
+        }
+        Raster::fillPolygon(mask, points, sides, 0xFFFFFFFF, true);
+    } else {
+        bool ring = shape == "ring";
+        bool star = shape == "star";
+        for (int y = 0; y < size; y++) {
+            for (int x = 0; x < size; x++) {
+                float dx = x - centerX;
+                float dy = y - centerY;
+                float dist = sqrt(dx * dx + dy * dy);
+                
+                bool draw = false;
+                if (ring) {
+                    draw = (dist <= radius && dist >= radius * 0.7f);
+                } else if (star) {
+                    float angle = atan2(dy, dx);
+                    draw = dist <= radius * (0.6f + 0.4f * sin(angle * 5));
+                }
+                if (draw) pixels[y * size + x] = 0xFFFFFFFF;
+            }
+        }
+    }
+    
+    // Shading pass: radial intensity falloff, scaled by coverage
     for (int y = 0; y < size; y++) {
         for (int x = 0; x < size; x++) {
-            bool draw = false;
-            float dx = x - centerX;
-            float dy = y - centerY;
-            float dist = sqrt(dx * dx + dy * dy);
+            uint32_t coverage = pixels[y * size + x] & 0xFF;
+            if (coverage == 0) continue;
             
-            if (shape == "circle") {
-                draw = dist <= radius;
-            } else if (shape == "ring") {
-                draw = (dist <= radius && dist >= radius * 0.7f);
-            } else if (shape == "diamond") {
-                draw = (abs(dx) + abs(dy)) <= radius;
-            } else if (shape == "star") {
-                float angle = atan2(dy, dx);
-                float starRadius = radius * (0.6f + 0.4f * sin(angle * 5));
-                draw = dist <= starRadius;
-            } else if (shape == "hexagon") {
-                // Simplified hexagon
-                draw = (abs(dx) <= radius * 0.866f && 
-                       abs(dy) <= radius && 
-                       abs(dx * 0.866f + dy * 0.5f) <= radius &&
-                       abs(dx * 0.866f - dy * 0.5f) <= radius);
-            }
+            float dx = x + 0.5f - centerX;
+            float dy = y + 0.5f - centerY;
+            float intensity = 1.0f - std::min(1.0f, sqrtf(dx * dx + dy * dy) / radius) * 0.3f;
+            uint8_t r = (uint8_t)(color.r * intensity);
+            uint8_t g = (uint8_t)(color.g * intensity);
+            uint8_t b = (uint8_t)(color.b * intensity);
             
-            if (draw) {
-                // Add some gradient effect
-                float intensity = 1.0f - (dist / radius) * 0.3f;
-                uint8_t r = (uint8_t)(color.r * intensity);
-                uint8_t g = (uint8_t)(color.g * intensity);
-                uint8_t b = (uint8_t)(color.b * intensity);
-                
-                pixels[y * size + x] = (r << 24) | (g << 16) | (b << 8) | color.a;
-            }
+            pixels[y * size + x] = Blend::scalePixel(Color(r, g, b, color.a).toPremultiplied(), coverage);
         }
     }
     
@@ -0,0 +1,129 @@
+#include "rasterizer.h"
+#include "blend.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace {
+
+    // Заливка выпуклого четырехугольника по строкам: пиксель закрашивается,
+    // если его центр внутри. На строку - пересечение с ребрами и одна заливка отрезка.
+    template<class F>
+    void fillQuad(const Raster::BasicTarget<F>& target, const float* xs, const float* ys, uint32_t pixel) {
+        float minY = std::min(std::min(ys[0], ys[1]), std::min(ys[2], ys[3]));
+        float maxY = std::max(std::max(ys[0], ys[1]), std::max(ys[2], ys[3]));
+        int y0 = std::max((int)ceilf(minY - 0.5f), target.y0);
+        int y1 = std::min((int)ceilf(maxY - 0.5f), target.y1);
+        
+        for (int py = y0; py < y1; py++) {
+            float yc = py + 0.5f;
+            float left = 1e30f, right = -1e30f;
+            for (int i = 0; i < 4; i++) {
+                float ax = xs[i], ay = ys[i];
+                float bx = xs[(i + 1) & 3], by = ys[(i + 1) & 3];
+                if ((yc < ay) == (yc < by)) continue;
+                float x = ax + (yc - ay) * (bx - ax) / (by - ay);
+                left = std::min(left, x);
+                right = std::max(right, x);
+            }
+            if (left < right) {
+                Raster::fillSpan(target, py, (int)ceilf(left - 0.5f), (int)ceilf(right - 0.5f), pixel);
+            }
+        }
+    }
+}
+
+namespace Raster {
+
+    // Тонкая линия со сглаживанием по Ву: на каждом шаге по главной оси два
+    // пикселя, покрытие между которыми делит дробная часть второй координаты.
+    // Вторая координата ведется в 16.16 от точного конца. По главной оси линия
+    // занимает [x1 - 0.5, x2 + 0.5]: концевые столбцы получают долю, закрытую
+    // отрезком, и при дробном сдвиге линия не прыгает на целый пиксель.
+    // Главная ось обрезается по цели до цикла.
+    template<class F>
+    void drawLineAA(const BasicTarget<F>& target, Fixed x1, Fixed y1, Fixed x2, Fixed y2, uint32_t pixel) {
+        bool steep = abs(y2 - y1) > abs(x2 - x1);
+        if (steep) {
+            std::swap(x1, y1);
+            std::swap(x2, y2);
+        }
+        if (x1 > x2) {
+            std::swap(x1, x2);
+            std::swap(y1, y2);
+        }
+        
+        int64_t dx = x2 - x1, dy = y2 - y1;
+        int64_t gradient = dx > 0 ? (dy << 16) / dx : 0;
+        
+        int lo = steep ? target.y0 : target.x0;
+        int hi = steep ? target.y1 : target.x1;
+        int first = fixedFloor(x1), last = fixedCeil(x2);
+        int start = std::max(first, lo);
+        int end = std::min(last, hi - 1);
+        
+        int64_t y = ((int64_t)y1 << 8) + ((gradient * (toFixed(start) - x1)) >> FIXED_SHIFT);
+        for (int x = start; x <= end; x++, y += gradient) {
+            uint32_t color = pixel;
+            if (x == first || x == last) {
+                int weight = std::min(toFixed(x), x2) - std::max(toFixed(x), x1) + FIXED_ONE;
+                if (weight <= 0) continue;
+                color = Blend::scalePixel(pixel, weight - (weight >> FIXED_SHIFT));
+            }
+            
+            int iy = (int)(y >> 16);
+            uint32_t frac = (uint32_t)(y >> 8) & 0xFF;
+            uint32_t near = Blend::scalePixel(color, 255 - frac);
+            if (steep) {
+                plot(target, iy, x, near);
+                if (frac) plot(target, iy + 1, x, Blend::scalePixel(color, frac));
+            } else {
+                plot(target, x, iy, near);
+                if (frac) plot(target, x, iy + 1, Blend::scalePixel(color, frac));
+            }
+        }
+    }
+    
+    // Линия толщиной width. До одного пикселя - сглаженная линия Ву,
+    // толще - прямоугольник с квадратными концами, залитый отрезками строк.
+    template<class F>
+    void drawLine(const BasicTarget<F>& target, Fixed x1, Fixed y1, Fixed x2, Fixed y2, uint32_t pixel, float width) {
+        if ((pixel & 0xFF) == 0) return;
+        
+        if (width <= 1.0f) {
+            drawLineAA(target, x1, y1, x2, y2, pixel);
+            return;
+        }
+        
+        // Концы - центры пикселей; d - направление, n - нормаль длиной в полтолщины
+        const float scale = 1.0f / FIXED_ONE;
+        float half = width * 0.5f;
+        float fx = (x2 - x1) * scale, fy = (y2 - y1) * scale;
+        float length = sqrtf(fx * fx + fy * fy);
+        float ux = 1.0f, uy = 0.0f;
+        if (length > 0.0f) {
+            ux = fx / length;
+            uy = fy / length;
+        }
+        float dx = ux * half, dy = uy * half;
+        float nx = -dy, ny = dx;
+        
+        float ax = x1 * scale + 0.5f - dx, ay = y1 * scale + 0.5f - dy;
+        float bx = x2 * scale + 0.5f + dx, by = y2 * scale + 0.5f + dy;
+        float xs[4] = { ax + nx, bx + nx, bx - nx, ax - nx };
+        float ys[4] = { ay + ny, by + ny, by - ny, ay - ny };
+        fillQuad(target, xs, ys, pixel);
+    }
+    
+    int linePadding(float width) {
+        // Квадратный конец по диагонали выходит на half * sqrt(2), сглаженная - на пиксель
+        return (int)ceilf(width * 0.7072f) + 1;
+    }
+
+#define INSTANTIATE(F) \
+    template void drawLineAA(const BasicTarget<F>&, Fixed, Fixed, Fixed, Fixed, uint32_t); \
+    template void drawLine(const BasicTarget<F>&, Fixed, Fixed, Fixed, Fixed, uint32_t, float);
+    
+    PIXEL_FORMATS(INSTANTIATE)
+#undef INSTANTIATE
+}
@@ -4,56 +4,97 @@
 #include "simple_interface.h"
 #include "config.h"
 #include "neocore.h"
+#include "platform.h"
+#include "headless_platform.h"
 
 SimpleInterface g_interface;
 
+#ifndef __SWITCH__
+// На хосте интерфейс работает без дисплея:
+//   --frames N        число кадров (по умолчанию 300)
+//   --fixed-step S    фиксированный шаг времени в секундах
+//   --input FILE      сценарий ввода
+//   --dump PREFIX     сохранять кадры (--dump-every K, --png)
+static HeadlessPlatform* createHeadless(int argc, char* argv[]) {
+    HeadlessPlatform* platform = new HeadlessPlatform();
+    platform->setFrameLimit(300);
+    
+    std::string dumpPrefix;
+    std::string dumpExtension = ".ppm";
+    int dumpEvery = 1;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--frames" && hasValue) {
+            platform->setFrameLimit(atoi(argv[++i]));
+        } else if (arg == "--fixed-step" && hasValue) {
+            platform->setFixedTimestep(atof(argv[++i]));
+        } else if (arg == "--input" && hasValue) {
+            if (!platform->loadInputScript(argv[++i])) {
+                printf("Cannot read input script %s\n", argv[i]);
+            }
+        } else if (arg == "--dump" && hasValue) {
+            dumpPrefix = argv[++i];
+        } else if (arg == "--dump-every" && hasValue) {
+            dumpEvery = atoi(argv[++i]);
+        } else if (arg == "--png") {
+            dumpExtension = ".png";
+        }
+    }
+    if (!dumpPrefix.empty()) {
+        platform->setFrameDump(dumpPrefix, dumpEvery, dumpExtension);
+    }
+    return platform;
+}
+#endif
+
 int main(int argc, char* argv[]) {
     // Инициализация системы
+#ifdef __SWITCH__
     consoleInit(NULL);
-    
+#else
+    Platform::setInstance(createHeadless(argc, argv));
+#endif
+
     logToGraphics("NEOVIA", "========== NEOVIA STARTUP ==========");
     logToGraphics("NEOVIA", "Version: 1.0.0");
     logToGraphics("NEOVIA", "Author: Unix228");
     
-    // Инициализация пада
-    PadState pad;
-    padConfigureInput(1, HidNpadStyleSet_NpadStandard);
-    padInitializeDefault(&pad);
-    
-    logToGraphics("NEOVIA", "Input system initialized");
-    
     // Загрузка конфигурации
-    Config config = loadConfig();
+    Config config;
+    loadConfig(config);
     logToGraphics("NEOVIA", "Configuration loaded");
     
     // Инициализация интерфейса
     if (!g_interface.initialize()) {
         logToGraphics("NEOVIA", "CRITICAL ERROR: Failed to initialize interface!");
         printf("Interface initialization failed!\n");
+#ifdef __SWITCH__
         consoleUpdate(NULL);
         
-        while (appletMainLoop()) {
-            padUpdate(&pad);
-            u64 kDown = padGetButtonsDown(&pad);
+        while (PLATFORM->mainLoop()) {
+            u64 kDown = PLATFORM->pollButtonsDown();
             if (kDown & HidNpadButton_Plus) break;
         }
         
         consoleExit(NULL);
+#endif
         return -1;
     }
     
     printf("🎮 NEOVIA v1.0.0\n");
     printf("📱 Simple interface loaded\n");
     printf("🖼️ Icon: %s\n", "icon.jpg found" );
+#ifdef __SWITCH__
     consoleUpdate(NULL);
-    
+#endif
+
     logToGraphics("NEOVIA", "Interface loaded successfully, entering main loop");
     
     // Основной игровой цикл
-    while (appletMainLoop()) {
+    while (PLATFORM->mainLoop()) {
         // Обновление ввода
-        padUpdate(&pad);
-        u64 kDown = padGetButtonsDown(&pad);
+        u64 kDown = PLATFORM->pollButtonsDown();
         
         // Обработка ввода интерфейсом
         if (!g_interface.handleInput(kDown)) {
@@ -69,6 +110,8 @@ int main(int argc, char* argv[]) {
     logToGraphics("NEOVIA", "Application shutdown, cleaning up resources...");
     g_interface.cleanup();
     logToGraphics("NEOVIA", "========== NEOVIA SHUTDOWN ==========");
+#ifdef __SWITCH__
     consoleExit(NULL);
+#endif
     return 0;
 }
\ No newline at end of file
@@ -40,6 +40,12 @@ bool ModernGUI::initialize(Config* cfg) {
         return false;
     }
     
+    // Фон и эффекты перекрывают весь экран много раз за кадр, поэтому
+    // при нескольких потоках рендера рисуем через список команд с тайлами.
+    // На одном ядре запись и раскладка по тайлам - только накладные расходы
+    // (кадр главного меню в bench: frame.mainmenu/immediate и /deferred)
+    GFX->setDeferred(GFX->getRenderThreads() > 1);
+    
     // Initialize icon system and create beautiful default icons
     DefaultIcons::initializeDefaultIcons();
     
@@ -66,6 +72,14 @@ void ModernGUI::render() {
     float deltaTime = GFX->getDeltaTime();
     backgroundOffset += deltaTime;
     
+    // Непрозрачные панели экрана рисуются поверх фона и эффектов,
+    // поэтому все, что под ними, можно не рисовать
+    occluders.clear();
+    if (Panel* panel = getScreenPanel()) {
+        panel->collectOccluders(occluders);
+    }
+    GFX->beginOcclusion(occluders);
+    
     // Enhanced animated background with multiple effects
     renderBackground(deltaTime);
     
@@ -77,6 +91,7 @@ void ModernGUI::render() {
     AdvancedEffects::drawConstellation(980, 520, 300, 200, backgroundOffset + 1.0f, 6);
     
     renderParticles(deltaTime);
+    GFX->endOcclusion();
     
     // Рендер текущего экрана
     switch (currentScreen) {
@@ -100,6 +115,17 @@ void ModernGUI::render() {
     GFX->endFrame();
 }
 
+Panel* ModernGUI::getScreenPanel() const {
+    switch (currentScreen) {
+        case Screen::MAIN_MENU: return mainPanel.get();
+        case Screen::SETTINGS: return settingsPanel.get();
+        case Screen::ABOUT: return aboutPanel.get();
+        case Screen::GAME_ENHANCEMENT: return enhancementPanel.get();
+        case Screen::LOADING: return loadingPanel.get();
+    }
+    return nullptr;
+}
+
 void ModernGUI::update(float deltaTime) {
     updateParticles(deltaTime);
     backgroundOffset += deltaTime * 10.0f;
@@ -342,13 +368,25 @@ void ModernGUI::createLoadingMenu() {
 // renderBackground реализован в particle_effects.cpp
 
 void ModernGUI::renderParticles(float deltaTime) {
+    // Частицы перекладываются в массивы и рисуются одним пакетом
+    particleX.clear();
+    particleY.clear();
+    particleSize.clear();
+    particleColors.clear();
+    
     for (const auto& particle : particles) {
         if (particle.life > 0) {
             float alpha = particle.life / particle.maxLife;
             Color particleColor(particle.color.r, particle.color.g, particle.color.b, (uint8_t)(255 * alpha));
-            GFX->drawCircle(particle.x, particle.y, particle.size, particleColor);
+            particleX.push_back(particle.x);
+            particleY.push_back(particle.y);
+            particleSize.push_back(particle.size);
+            particleColors.push_back(particleColor.toRGBA());
         }
     }
+    
+    GFX->drawCircles(particleX.data(), particleY.data(), particleSize.data(),
+                     particleColors.data(), (int)particleColors.size());
 }
 
 void ModernGUI::updateParticles(float deltaTime) {
@@ -94,8 +94,8 @@ bool NeoCoreManager::createDirectoryStructure() {
     };
     
     for (const auto& dir : directories) {
-        Result rc = fsFsCreateDirectory(fsdevGetDeviceFileSystem("sdmc"), dir.c_str());
-        if (R_FAILED(rc) && rc != 0x402) { // 0x402 = уже существует
+        Result rc = PLATFORM->createDirectory(dir);
+        if (R_FAILED(rc)) {
             return false;
         }
     }
@@ -179,7 +179,7 @@ bool NeoCoreManager::startCore(const GameInfo& gameInfo) {
     }
     
     status = NeoCoreStatus::RUNNING;
-    logMessage("NeoCore Engine started for game: " + gameInfo.gameName);
+    logMessage("NeoCore Engine started for game: " + gameInfo.name);
     
     // Отправляем информацию об игре
     if (!sendGameInfo(gameInfo)) {
@@ -189,8 +189,8 @@ bool NeoCoreManager::startCore(const GameInfo& gameInfo) {
     }
     
     // Создаем профиль игры если его нет
-    if (!hasGameProfile(gameInfo.gameId)) {
-        createGameProfile(gameInfo.gameId);
+    if (!hasGameProfile(gameInfo.titleId)) {
+        createGameProfile(gameInfo.titleId);
     }
     
     // Ждем готовности ядра
@@ -200,7 +200,7 @@ bool NeoCoreManager::startCore(const GameInfo& gameInfo) {
         return false;
     }
     
-    logMessage("NeoCore Engine successfully applied to " + gameInfo.gameName);
+    logMessage("NeoCore Engine successfully applied to " + gameInfo.name);
     return true;
 }
 
@@ -211,8 +211,8 @@ bool NeoCoreManager::sendGameInfo(const GameInfo& gameInfo) {
     }
     
     commFile << "# NeoCore Communication File\n";
-    commFile << "game_id=" << gameInfo.gameId << "\n";
-    commFile << "game_name=" << gameInfo.gameName << "\n";
+    commFile << "game_id=" << gameInfo.titleId << "\n";
+    commFile << "game_name=" << gameInfo.name << "\n";
     commFile << "has_profile=" << (gameInfo.hasCustomProfile ? "true" : "false") << "\n";
     commFile << "active_mods=" << gameInfo.activeMods.size() << "\n";
     
@@ -253,8 +253,8 @@ bool NeoCoreManager::createGameProfile(const std::string& gameId) {
     std::string profilePath = "/graphics/mods/" + gameId + "/";
     
     // Создаем папку игры
-    Result rc = fsFsCreateDirectory(fsdevGetDeviceFileSystem("sdmc"), profilePath.c_str());
-    if (R_FAILED(rc) && rc != 0x402) {
+    Result rc = PLATFORM->createDirectory(profilePath);
+    if (R_FAILED(rc)) {
         return false;
     }
     
@@ -287,7 +287,7 @@ bool NeoCoreManager::createGameProfile(const std::string& gameId) {
     };
     
     for (const auto& dir : subDirs) {
-        fsFsCreateDirectory(fsdevGetDeviceFileSystem("sdmc"), dir.c_str());
+        PLATFORM->createDirectory(dir);
     }
     
     logMessage("NeoCore Engine created profile for game: " + gameId);
@@ -1,16 +1,17 @@
-#include "graphics.h"
+#include "modern_gui.h"
 #include <random>
 #include <cmath>
 
 // Дополнительные эффекты частиц
 namespace ParticleEffects {
-    
+
     // Звездное поле
     void drawStarField(float time, float speed = 1.0f) {
-        static std::vector<struct Star {
+        struct Star {
             float x, y, z;
             float brightness;
-        }> stars;
+        };
+        static std::vector<Star> stars;
         
         // Инициализация звезд
         if (stars.empty()) {
@@ -30,7 +31,14 @@ namespace ParticleEffects {
             }
         }
         
-        // Рендер звезд
+        // Рендер звезд одним пакетом кругов
+        static std::vector<float> starX, starY, starSize;
+        static std::vector<uint32_t> starColors;
+        starX.clear();
+        starY.clear();
+        starSize.clear();
+        starColors.clear();
+        
         for (auto& star : stars) {
             star.z -= speed * 0.01f;
             if (star.z <= 0) {
@@ -46,10 +54,14 @@ namespace ParticleEffects {
                 uint8_t alpha = (uint8_t)(255 * star.brightness * star.z);
                 Color starColor(255, 255, 255, alpha);
                 
-                float size = (1.0f - star.z) * 3 + 1;
-                GFX->drawCircle(screenX, screenY, size, starColor);
+                starX.push_back(screenX);
+                starY.push_back(screenY);
+                starSize.push_back((1.0f - star.z) * 3 + 1);
+                starColors.push_back(starColor.toRGBA());
             }
         }
+        
+        GFX->drawCircles(starX.data(), starY.data(), starSize.data(), starColors.data(), (int)starColors.size());
     }
     
     // Плавающие геометрические фигуры
@@ -80,12 +92,19 @@ namespace ParticleEffects {
                     GFX->drawRoundedRect(x - 15 * scale, y - 15 * scale, 
                                        30 * scale, 30 * scale, 5, shapeColor);
                     break;
-                case 2: // Треугольник (упрощенный как ромб)
-                    GFX->drawCircle(x, y, 18 * scale, shapeColor);
-                    break;
-                case 3: // Шестиугольник (упрощенный как круг)
-                    GFX->drawCircle(x, y, 25 * scale, shapeColor);
+                case 2: // Треугольник
+                case 3: { // Шестиугольник
+                    int sides = (i % 4 == 2) ? 3 : 6;
+                    float radius = (sides == 3 ? 22 : 25) * scale;
+                    float xs[6], ys[6];
+                    for (int k = 0; k < sides; k++) {
+                        float angle = rotation + k * 2 * M_PI / sides;
+                        xs[k] = x + cos(angle) * radius;
+                        ys[k] = y + sin(angle) * radius;
+                    }
+                    GFX->drawPolygon(xs, ys, sides, shapeColor);
                     break;
+                }
             }
         }
     }
@@ -189,11 +208,12 @@ namespace ParticleEffects {
     
     // Matrix-подобный эффект дождя
     void drawMatrixRain(float time) {
-        static std::vector<struct Drop {
+        struct Drop {
             float x, y, speed;
             char character;
             float life;
-        }> drops;
+        };
+        static std::vector<Drop> drops;
         
         // Инициализация капель
         if (drops.size() < 50) {
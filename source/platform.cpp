@@ -0,0 +1,83 @@
+#include "platform.h"
+#include "headless_platform.h"
+
+#ifdef __SWITCH__
+namespace {
+
+    // libnx: двойной буфер gfx, системный счетчик тиков и первый контроллер
+    class SwitchPlatform : public Platform {
+    public:
+        SwitchPlatform() : padReady(false) {}
+        
+        bool initialize(uint32_t width, uint32_t height) override {
+            Result rc = gfxInitDefault();
+            if (R_FAILED(rc)) return false;
+            gfxConfigureResolution(width, height);
+            return true;
+        }
+        
+        void shutdown() override {
+            gfxExit();
+        }
+        
+        uint32_t* getFramebuffer(uint32_t* width, uint32_t* height) override {
+            return (uint32_t*)gfxGetFramebuffer(width, height);
+        }
+        
+        void present() override {
+            gfxFlushBuffers();
+            gfxSwapBuffers();
+            gfxWaitForVsync();
+        }
+        
+        void waitForVsync() override {
+            gfxWaitForVsync();
+        }
+        
+        uint64_t getTicks() override { return armGetSystemTick(); }
+        uint64_t getTickFrequency() override { return armGetSystemTickFreq(); }
+        
+        bool mainLoop() override {
+            return appletMainLoop();
+        }
+        
+        u64 pollButtonsDown() override {
+            // Контроллер настраивается при первом опросе - ввод нужен
+            // и тогда, когда графика не инициализировалась
+            if (!padReady) {
+                padConfigureInput(1, HidNpadStyleSet_NpadStandard);
+                padInitializeDefault(&pad);
+                padReady = true;
+            }
+            padUpdate(&pad);
+            return padGetButtonsDown(&pad);
+        }
+        
+        Result createDirectory(const std::string& path) override {
+            Result rc = fsFsCreateDirectory(fsdevGetDeviceFileSystem("sdmc"), path.c_str());
+            return rc == 0x402 ? 0 : rc;    // 0x402 - уже существует
+        }
+    
+    private:
+        PadState pad;
+        bool padReady;
+    };
+}
+#endif
+
+Platform* Platform::instance = nullptr;
+
+Platform* Platform::getInstance() {
+    if (!instance) {
+#ifdef __SWITCH__
+        instance = new SwitchPlatform();
+#else
+        instance = new HeadlessPlatform();
+#endif
+    }
+    return instance;
+}
+
+void Platform::setInstance(Platform* platform) {
+    instance = platform;
+}
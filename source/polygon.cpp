@@ -0,0 +1,155 @@
+#include "rasterizer.h"
+#include "blend.h"
+#include <algorithm>
+#include <cmath>
+
+// Выпуклые многоугольники через функции ребер.
+// Для каждого ребра d(x, y) = a * x + b * y + c - расстояние до ребра в пикселях,
+// положительное внутри. Вдоль строки d линейна по x, поэтому границы отрезка
+// строки находятся одним делением на ребро, а b * y + c считается один раз на строку.
+namespace {
+
+    struct Edge {
+        float a, b, c;
+        float t;        // b * y + c для текущей строки
+        int64_t d;      // d + 0.5 в 8.24 в центре опорного столбца строки
+        int64_t step;   // a в 8.24
+    };
+    
+    // Диапазон пикселей строки [lo, hi), центры которых дают d >= k для всех ребер
+    void spanAbove(const Edge* edges, int count, float k, int& lo, int& hi) {
+        for (int i = 0; i < count && lo < hi; i++) {
+            const Edge& e = edges[i];
+            if (e.a > 1e-6f) {
+                lo = std::max(lo, (int)ceilf((k - e.t) / e.a - 0.5f));
+            } else if (e.a < -1e-6f) {
+                hi = std::min(hi, (int)floorf((k - e.t) / e.a - 0.5f) + 1);
+            } else if (e.t < k) {
+                hi = lo;
+            }
+        }
+    }
+    
+    // Сглаженные пиксели [lo, hi) строки py: покрытие - минимум d + 0.5 по ребрам.
+    // Оно ведется в целых 8.24 от опорного столбца anchor, одного для всех тайлов,
+    // поэтому тайлы и прямое рисование получают одинаковые значения.
+    template<class F>
+    void coverageBand(const Raster::BasicTarget<F>& target, const Edge* edges, int count, int anchor, int py,
+                      int lo, int hi, uint32_t pixel) {
+        if (lo >= hi) return;
+        
+        int64_t d[Raster::MAX_POLYGON_VERTICES];
+        for (int i = 0; i < count; i++) {
+            d[i] = edges[i].d + edges[i].step * (lo - anchor);
+        }
+        
+        for (int px = lo; px < hi; px++) {
+            int64_t coverage = 1 << 24;
+            for (int i = 0; i < count; i++) {
+                coverage = std::min(coverage, d[i]);
+                d[i] += edges[i].step;
+            }
+            if (coverage > 0) {
+                uint32_t byte = (uint32_t)((coverage * 255 + (1 << 23)) >> 24);
+                Raster::plot(target, px, py, Blend::scalePixel(pixel, byte));
+            }
+        }
+    }
+}
+
+namespace Raster {
+
+    template<class F>
+    void fillPolygon(const BasicTarget<F>& target, const Fixed* points, int count, uint32_t pixel, bool antialias) {
+        if (count < 3 || count > MAX_POLYGON_VERTICES || (pixel & 0xFF) == 0) return;
+        
+        const float scale = 1.0f / FIXED_ONE;
+        
+        // Обход может быть в любую сторону: знак площади задает сторону "внутри"
+        int64_t area = 0;
+        float minX = 1e30f, minY = 1e30f, maxX = -1e30f, maxY = -1e30f;
+        for (int i = 0; i < count; i++) {
+            int j = (i + 1) % count;
+            area += (int64_t)points[2 * i] * points[2 * j + 1] - (int64_t)points[2 * j] * points[2 * i + 1];
+            minX = std::min(minX, points[2 * i] * scale);
+            maxX = std::max(maxX, points[2 * i] * scale);
+            minY = std::min(minY, points[2 * i + 1] * scale);
+            maxY = std::max(maxY, points[2 * i + 1] * scale);
+        }
+        if (area == 0) return;
+        float sign = area > 0 ? 1.0f : -1.0f;
+        
+        Edge edges[MAX_POLYGON_VERTICES];
+        int edgeCount = 0;
+        for (int i = 0; i < count; i++) {
+            int j = (i + 1) % count;
+            float x0 = points[2 * i] * scale, y0 = points[2 * i + 1] * scale;
+            float dx = points[2 * j] * scale - x0, dy = points[2 * j + 1] * scale - y0;
+            float length = sqrtf(dx * dx + dy * dy);
+            if (length == 0.0f) continue;
+            
+            Edge& e = edges[edgeCount++];
+            e.a = -dy * sign / length;
+            e.b = dx * sign / length;
+            e.c = -(e.a * x0 + e.b * y0);
+        }
+        
+        // Со сглаживанием захватываются все пиксели, которых касается фигура
+        int y0 = antialias ? (int)floorf(minY) : (int)ceilf(minY - 0.5f);
+        int y1 = antialias ? (int)ceilf(maxY) : (int)ceilf(maxY - 0.5f);
+        int x0 = antialias ? (int)floorf(minX) : (int)ceilf(minX - 0.5f);
+        int x1 = antialias ? (int)ceilf(maxX) : (int)ceilf(maxX - 0.5f);
+        int anchor = x0;
+        y0 = std::max(y0, target.y0);
+        y1 = std::min(y1, target.y1);
+        x0 = std::max(x0, target.x0);
+        x1 = std::min(x1, target.x1);
+        if (x0 >= x1 || y0 >= y1) return;
+        
+        for (int i = 0; i < edgeCount; i++) {
+            edges[i].step = llrintf(edges[i].a * (1 << 24));
+        }
+        
+        for (int py = y0; py < y1; py++) {
+            // b * y + c - заново на каждой строке, а не накоплением от первой видимой:
+            // так значение строки не зависит от того, где ее обрезали
+            for (int i = 0; i < edgeCount; i++) {
+                Edge& e = edges[i];
+                e.t = e.b * (py + 0.5f) + e.c;
+                e.d = llrintf((e.a * (anchor + 0.5f) + e.t + 0.5f) * (1 << 24));
+            }
+            
+            if (!antialias) {
+                int lo = x0, hi = x1;
+                spanAbove(edges, edgeCount, 0.0f, lo, hi);
+                fillSpan(target, py, lo, hi, pixel);
+            } else {
+                // Внутренний отрезок (все ребра дальше полупикселя) - сплошная заливка,
+                // полоса вдоль ребер - покрытие по расстоянию до ближайшего ребра
+                int innerLo = x0, innerHi = x1;
+                int outerLo = x0, outerHi = x1;
+                spanAbove(edges, edgeCount, 0.5f, innerLo, innerHi);
+                spanAbove(edges, edgeCount, -0.5f, outerLo, outerHi);
+                if (innerLo >= innerHi) {
+                    innerLo = innerHi = outerHi;
+                }
+                fillSpan(target, py, innerLo, innerHi, pixel);
+                
+                coverageBand(target, edges, edgeCount, anchor, py, outerLo, innerLo, pixel);
+                coverageBand(target, edges, edgeCount, anchor, py, innerHi, outerHi, pixel);
+            }
+        }
+    }
+    
+    template<class F>
+    void fillTriangle(const BasicTarget<F>& target, const Fixed* points, uint32_t pixel, bool antialias) {
+        fillPolygon(target, points, 3, pixel, antialias);
+    }
+
+#define INSTANTIATE(F) \
+    template void fillPolygon(const BasicTarget<F>&, const Fixed*, int, uint32_t, bool); \
+    template void fillTriangle(const BasicTarget<F>&, const Fixed*, uint32_t, bool);
+    
+    PIXEL_FORMATS(INSTANTIATE)
+#undef INSTANTIATE
+}
@@ -0,0 +1,480 @@
+#include "rasterizer.h"
+#include "graphics.h"
+#include "blend.h"
+#include "corner_mask.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+    // Строки круга не длиннее этой рисуются одним отрезком маски вместе
+    // со сплошной частью; в длинных сплошная часть дешевле простой заливкой
+    const int SHORT_ROW = 32;
+    
+    // Скругленные прямоугольники не больше этой площади (круги до радиуса
+    // SNAP_RADIUS) в целой позиции смешиваются за один вызов
+    const int SMALL_AREA = 4 * Raster::SNAP_RADIUS * Raster::SNAP_RADIUS;
+    
+    // Покрытие по стороне пикселя в 1/256 -> байт покрытия 0..255
+    inline uint32_t coverageByte(int c) {
+        return (uint32_t)(c - (c >> Raster::FIXED_SHIFT));
+    }
+    
+    // Строка j скругленного прямоугольника w x h, стоящего в углу пикселя (0, 0):
+    // покрытие ее пикселей по столбцам без повторного разбора строки
+    struct RoundedRow {
+        const uint8_t* corner;  // Строка маски угла, nullptr - строка без скругления
+        int w, r;
+        bool inside;
+        
+        RoundedRow(const CornerMask& mask, int width, int h, int radius, int j)
+            : corner(nullptr), w(width), r(radius), inside(j >= 0 && j < h) {
+            int row = std::min(j, h - 1 - j);
+            if (inside && row < r) corner = mask.row(r - 1 - row);
+        }
+        
+        uint32_t at(int i) const {
+            if (!inside || i < 0 || i >= w) return 0;
+            if (!corner) return 255;
+            if (i < r) return corner[r - 1 - i];
+            if (i >= w - r) return corner[i - (w - r)];
+            return 255;
+        }
+    };
+    
+    // Сплошная и ненулевая части строки j того же прямоугольника: [solidLo, solidHi), [lo, hi)
+    inline void roundedRowSpans(const CornerMask& mask, int w, int h, int r, int j,
+                                int& solidLo, int& solidHi, int& lo, int& hi) {
+        if (j < 0 || j >= h) {
+            solidLo = lo = w;
+            solidHi = hi = 0;
+            return;
+        }
+        int row = std::min(j, h - 1 - j);
+        int solid = r, extent = r;
+        if (row < r) {
+            solid = mask.solid[r - 1 - row];
+            extent = mask.extent[r - 1 - row];
+        }
+        solidLo = r - solid;
+        solidHi = w - r + solid;
+        lo = r - extent;
+        hi = w - r + extent;
+    }
+}
+
+namespace Raster {
+
+    template<class F>
+    void plot(const BasicTarget<F>& target, int x, int y, uint32_t pixel) {
+        if (!target.contains(x, y)) return;
+        F::plot(target.row(y) + x, pixel);
+    }
+    
+    // Заливка отрезка [x0, x1) строки y. После обрезки внутренний цикл
+    // не делает ни одной проверки границ.
+    template<class F>
+    void fillSpan(const BasicTarget<F>& target, int y, int x0, int x1, uint32_t pixel) {
+        if (y < target.y0 || y >= target.y1) return;
+        x0 = std::max(x0, target.x0);
+        x1 = std::min(x1, target.x1);
+        if (x0 >= x1) return;
+        
+        if (pixel & 0xFF) {
+            F::fill(target.row(y) + x0, x1 - x0, pixel);
+        }
+    }
+    
+    template<class F>
+    void blendSpan(const BasicTarget<F>& target, int x, int y, const uint32_t* pixels, int count, uint32_t opacity) {
+        if (y < target.y0 || y >= target.y1 || opacity == 0) return;
+        int x0 = std::max(x, target.x0);
+        int x1 = std::min(x + count, target.x1);
+        if (x0 >= x1) return;
+        
+        F::blend(target.row(y) + x0, pixels + (x0 - x), x1 - x0, opacity);
+    }
+    
+    // Постоянный цвет с покрытием coverage на отрезке [x, x + count) строки y
+    template<class F>
+    inline void maskSpan(const BasicTarget<F>& target, int y, int x, const uint8_t* coverage, int count, uint32_t pixel) {
+        if (y < target.y0 || y >= target.y1) return;
+        int x0 = std::max(x, target.x0);
+        int x1 = std::min(x + count, target.x1);
+        if (x0 >= x1) return;
+        
+        F::mask(target.row(y) + x0, coverage + (x0 - x), x1 - x0, pixel);
+    }
+    
+    template<class F>
+    void fillRect(const BasicTarget<F>& target, int x, int y, int w, int h, uint32_t pixel) {
+        if ((pixel & 0xFF) == 0) return;
+        
+        int y0 = std::max(y, target.y0);
+        int y1 = std::min(y + h, target.y1);
+        for (int py = y0; py < y1; py++) {
+            fillSpan(target, py, x, x + w, pixel);
+        }
+    }
+    
+    template<class F>
+    void fillRectFixed(const BasicTarget<F>& target, Fixed x, Fixed y, Fixed w, Fixed h, uint32_t pixel) {
+        if ((pixel & 0xFF) == 0 || w <= 0 || h <= 0) return;
+        
+        // Края на границах пикселей - обычная заливка
+        if (((x | y | w | h) & (FIXED_ONE - 1)) == 0) {
+            fillRect(target, fixedFloor(x), fixedFloor(y), fixedFloor(w), fixedFloor(h), pixel);
+            return;
+        }
+        
+        Fixed right = x + w, bottom = y + h;
+        int left = fixedFloor(x), innerLeft = fixedCeil(x);
+        int innerRight = fixedFloor(right), rightEnd = fixedCeil(right);
+        
+        int y0 = std::max(fixedFloor(y), target.y0);
+        int y1 = std::min(fixedCeil(bottom), target.y1);
+        for (int py = y0; py < y1; py++) {
+            // Закрытая доля строки по вертикали, 0..256
+            int cy = std::min(bottom, toFixed(py + 1)) - std::max(y, toFixed(py));
+            
+            if (innerLeft > innerRight) {
+                // Оба края в одном столбце
+                plot(target, left, py, Blend::scalePixel(pixel, coverageByte(w * cy >> FIXED_SHIFT)));
+                continue;
+            }
+            
+            fillSpan(target, py, innerLeft, innerRight, Blend::scalePixel(pixel, coverageByte(cy)));
+            if (left < innerLeft) {
+                int cx = toFixed(innerLeft) - x;
+                plot(target, left, py, Blend::scalePixel(pixel, coverageByte(cx * cy >> FIXED_SHIFT)));
+            }
+            if (innerRight < rightEnd) {
+                int cx = right - toFixed(innerRight);
+                plot(target, innerRight, py, Blend::scalePixel(pixel, coverageByte(cx * cy >> FIXED_SHIFT)));
+            }
+        }
+    }
+    
+    // Строка скругленного прямоугольника. В целой позиции покрытие берется из маски
+    // как есть: одна заливка полностью закрытой части и несколько краевых пикселей.
+    // Дробный сдвиг (fx, fy) дает билинейную смесь покрытий четырех соседних пикселей
+    // целой фигуры: для прямых краев это точная площадь, для дуг - гладкое приближение,
+    // поэтому фигура движется плавно, без скачков на целый пиксель.
+    template<class F>
+    void fillRoundedRectRow(const BasicTarget<F>& target, int py, Fixed x, Fixed y, int w, int h, int radius,
+                            const CornerMask& mask, uint32_t pixel) {
+        int ix = fixedFloor(x), iy = fixedFloor(y);
+        int fx = x & (FIXED_ONE - 1), fy = y & (FIXED_ONE - 1);
+        int r = radius;
+        int j = py - iy;
+        
+        int solidLo, solidHi, lo, hi;
+        roundedRowSpans(mask, w, h, r, j, solidLo, solidHi, lo, hi);
+        
+        if (fx == 0 && fy == 0) {
+            if (lo >= hi) return;
+            int row = r - 1 - std::min(j, h - 1 - j);
+            
+            // Короткая строка круга - один отрезок маски: зеркальная и прямая
+            // строки угла лежат подряд и закрывают ее целиком
+            if (w == 2 * r && row >= 0 && hi - lo <= SHORT_ROW) {
+                maskSpan(target, py, ix + lo, mask.mirroredRow(row) + lo, hi - lo, pixel);
+                return;
+            }
+            
+            fillSpan(target, py, ix + solidLo, ix + solidHi, pixel);
+            if (solidLo == lo) return;
+            
+            // Края угла - по одному отрезку маски с каждой стороны
+            maskSpan(target, py, ix + lo, mask.mirroredRow(row) + lo, solidLo - lo, pixel);
+            maskSpan(target, py, ix + solidHi, mask.row(row) + (solidHi - (w - r)), hi - solidHi, pixel);
+            return;
+        }
+        
+        // Сдвиг вниз смешивает строки j и j - 1, вправо - столбцы i и i - 1
+        if (fy) {
+            int prevSolidLo, prevSolidHi, prevLo, prevHi;
+            roundedRowSpans(mask, w, h, r, j - 1, prevSolidLo, prevSolidHi, prevLo, prevHi);
+            solidLo = std::max(solidLo, prevSolidLo);
+            solidHi = std::min(solidHi, prevSolidHi);
+            lo = std::min(lo, prevLo);
+            hi = std::max(hi, prevHi);
+        }
+        if (fx) {
+            solidLo++;
+            hi++;
+        }
+        if (lo >= hi) return;
+        
+        // Верхняя и нижняя строки сплошной части не имеют, но между углами
+        // покрытие у них одно на всю строку - это тоже одна заливка
+        uint32_t fill = pixel;
+        if (solidLo >= solidHi) {
+            solidLo = r + (fx ? 1 : 0);
+            solidHi = w - r;
+            uint32_t coverage = ((j >= 0 && j < h ? FIXED_ONE - fy : 0) + (j >= 1 && j <= h ? fy : 0)) * 255;
+            fill = Blend::scalePixel(pixel, coverage >> FIXED_SHIFT);
+            if (solidLo >= solidHi) {
+                solidLo = solidHi = hi;
+            }
+        }
+        
+        fillSpan(target, py, ix + solidLo, ix + solidHi, fill);
+        
+        // Смесь разделима: столбец смешивается по вертикали один раз,
+        // а по горизонтали - с предыдущим столбцом. Полосы обрезаются
+        // по цели заранее, пиксели пишутся без проверок.
+        if (py < target.y0 || py >= target.y1) return;
+        int clipLo = target.x0 - ix, clipHi = target.x1 - ix;
+        typename F::Pixel* dst = target.row(py) + ix;
+        
+        RoundedRow current(mask, w, h, r, j), previous(mask, w, h, r, j - 1);
+        uint32_t wy = FIXED_ONE - fy;
+        for (int band = 0; band < 2; band++) {
+            int i = std::max(band ? solidHi : lo, clipLo);
+            int end = std::min(band ? hi : solidLo, clipHi);
+            if (i >= end) continue;
+            
+            uint32_t left = wy * current.at(i - 1) + fy * previous.at(i - 1);
+            for (; i < end; i++) {
+                uint32_t column = wy * current.at(i) + fy * previous.at(i);
+                uint32_t coverage = ((FIXED_ONE - fx) * column + fx * left) >> (2 * FIXED_SHIFT);
+                left = column;
+                if (coverage) {
+                    F::plot(dst + i, Blend::scalePixel(pixel, coverage));
+                }
+            }
+        }
+    }
+    
+    // Мелкий скругленный прямоугольник в целой позиции, по горизонтали целиком
+    // внутри цели; строки вне цели пропускаются. Пиксели те же, что у построчной
+    // заливки, но краевые отрезки всех строк (у полупрозрачного цвета - строки
+    // целиком) собираются в один буфер и смешиваются одним вызовом: пара отрезков
+    // по 1-3 пикселя на строку обходится дороже самого смешивания
+    template<class F>
+    void fillSmallRoundedRect(const BasicTarget<F>& target, int x, int y, int w, int h,
+                              const CornerMask& mask, uint32_t pixel) {
+        typedef typename F::Pixel Pixel;
+        struct Segment {
+            Pixel* dst;
+            int count;
+        };
+        
+        bool opaque = (pixel & 0xFF) == 255;
+        int r = mask.radius;
+        uint32_t buffer[SMALL_AREA];
+        uint8_t coverage[SMALL_AREA];
+        Segment segments[SMALL_AREA];
+        int count = 0, segmentCount = 0;
+        
+        // Пиксели [dst, dst + n) с покрытием c (nullptr - полное) в буфер простым
+        // циклом: отрезки в несколько пикселей дешевле без memcpy. Смежные
+        // отрезки одной строки сливаются.
+        auto gather = [&](Pixel* dst, const uint8_t* c, int n) {
+            if (n <= 0) return;
+            for (int i = 0; i < n; i++) {
+                buffer[count + i] = F::unpack(dst[i]);
+                coverage[count + i] = c ? c[i] : 255;
+            }
+            count += n;
+            
+            if (segmentCount > 0 && segments[segmentCount - 1].dst + segments[segmentCount - 1].count == dst) {
+                segments[segmentCount - 1].count += n;
+            } else {
+                segments[segmentCount++] = { dst, n };
+            }
+        };
+        
+        int j0 = std::max(0, target.y0 - y), j1 = std::min(h, target.y1 - y);
+        for (int j = j0; j < j1; j++) {
+            Pixel* dst = target.row(y + j) + x;
+            int row = r - 1 - std::min(j, h - 1 - j);
+            if (row < 0) {
+                // Строка между углами: сплошная целиком
+                if (opaque) {
+                    F::fill(dst, w, pixel);
+                } else {
+                    gather(dst, nullptr, w);
+                }
+                continue;
+            }
+            
+            // Левый угол [lo, a), середина [a, b), правый угол [b, hi). У непрозрачного
+            // цвета середина - закрытая часть строки и заливается сразу.
+            int solid = mask.solid[row], extent = mask.extent[row];
+            int lo = r - extent, hi = w - r + extent;
+            int a = opaque ? r - solid : r, b = opaque ? w - r + solid : w - r;
+            if (opaque && a < b) {
+                F::fill(dst + a, b - a, pixel);
+            }
+            gather(dst + lo, mask.mirroredRow(row) + lo, a - lo);
+            if (!opaque) {
+                gather(dst + a, nullptr, b - a);
+            }
+            gather(dst + b, mask.row(row) + (b - (w - r)), hi - b);
+        }
+        if (count == 0) return;
+        
+        Blend::blendMask(buffer, coverage, count, pixel);
+        const uint32_t* src = buffer;
+        for (int k = 0; k < segmentCount; k++) {
+            for (int i = 0; i < segments[k].count; i++) {
+                segments[k].dst[i] = F::pack(*src++);
+            }
+        }
+    }
+    
+    // Малый круг (радиус до CornerMask::DISC_RADIUS) в целой позиции (x, y) - левом
+    // верхнем углу, по горизонтали целиком внутри цели. Покрытие всех строк
+    // уже лежит в mask.disc подряд: собираются только пиксели, смешивание одно
+    // и у полупрозрачного, и у непрозрачного цвета (полное покрытие дает сам цвет).
+    template<class F>
+    void fillSmallCircle(const BasicTarget<F>& target, int x, int y, const CornerMask& mask, uint32_t pixel) {
+        typedef typename F::Pixel Pixel;
+        int r = mask.radius;
+        int j0 = std::max(0, target.y0 - y), j1 = std::min(2 * r, target.y1 - y);
+        if (j0 >= j1) return;
+        
+        uint32_t buffer[4 * CornerMask::DISC_RADIUS * CornerMask::DISC_RADIUS];
+        int count = 0;
+        for (int j = j0; j < j1; j++) {
+            int n = mask.discRow[j + 1] - mask.discRow[j];
+            const Pixel* dst = target.row(y + j) + x + r - n / 2;
+            for (int i = 0; i < n; i++) {
+                buffer[count++] = F::unpack(dst[i]);
+            }
+        }
+        
+        Blend::blendMask(buffer, mask.disc.data() + mask.discRow[j0], count, pixel);
+        const uint32_t* src = buffer;
+        for (int j = j0; j < j1; j++) {
+            int n = mask.discRow[j + 1] - mask.discRow[j];
+            Pixel* dst = target.row(y + j) + x + r - n / 2;
+            for (int i = 0; i < n; i++) {
+                dst[i] = F::pack(*src++);
+            }
+        }
+    }
+    
+    template<class F>
+    void fillRoundedRectWithMask(const BasicTarget<F>& target, Fixed x, Fixed y, int w, int h,
+                                 const CornerMask& mask, uint32_t pixel) {
+        int y0 = std::max(fixedFloor(y), target.y0);
+        int y1 = std::min(fixedCeil(y + toFixed(h)), target.y1);
+        if (y0 >= y1 || fixedFloor(x) >= target.x1 || fixedCeil(x + toFixed(w)) <= target.x0) return;
+        
+        int ix = fixedFloor(x);
+        if (w * h <= SMALL_AREA && ((x | y) & (FIXED_ONE - 1)) == 0 && ix >= target.x0 && ix + w <= target.x1) {
+            if (w == 2 * mask.radius && h == w && !mask.disc.empty()) {
+                fillSmallCircle(target, ix, fixedFloor(y), mask, pixel);
+            } else {
+                fillSmallRoundedRect(target, ix, fixedFloor(y), w, h, mask, pixel);
+            }
+            return;
+        }
+        for (int py = y0; py < y1; py++) {
+            fillRoundedRectRow(target, py, x, y, w, h, mask.radius, mask, pixel);
+        }
+    }
+    
+    // Сглаженный скругленный прямоугольник: w x h пикселей от точки (x, y).
+    // Центры углов лежат в углах пикселей целой фигуры, дробная часть
+    // положения переходит в покрытие краев (fillRoundedRectRow).
+    template<class F>
+    void fillRoundedRect(const BasicTarget<F>& target, Fixed x, Fixed y, int w, int h, int radius, uint32_t pixel) {
+        if ((pixel & 0xFF) == 0 || w <= 0 || h <= 0) return;
+        
+        int r = std::max(0, std::min(radius, std::min(w, h) / 2));
+        if (r == 0) {
+            fillRectFixed(target, x, y, toFixed(w), toFixed(h), pixel);
+            return;
+        }
+        
+        int y0 = std::max(fixedFloor(y), target.y0);
+        int y1 = std::min(fixedCeil(y + toFixed(h)), target.y1);
+        if (y0 >= y1 || fixedFloor(x) >= target.x1 || fixedCeil(x + toFixed(w)) <= target.x0) return;
+        
+        std::shared_ptr<const CornerMask> holder;
+        fillRoundedRectWithMask(target, x, y, w, h, *CORNER_MASKS->get(r, holder), pixel);
+    }
+    
+    // Круг радиуса radius с центром в точке (cx, cy)
+    template<class F>
+    void fillCircle(const BasicTarget<F>& target, Fixed cx, Fixed cy, int radius, uint32_t pixel) {
+        if (radius <= 0) return;
+        
+        fillRoundedRect(target, cx - toFixed(radius), cy - toFixed(radius), 2 * radius, 2 * radius, radius, pixel);
+    }
+    
+    template<class F>
+    void blit(const BasicTarget<F>& target, const uint32_t* pixels, int srcStride, int w, int h,
+              int x, int y, uint32_t opacity, bool opaque) {
+        tile(target, pixels, srcStride, w, h, x, y, w, h, opacity, opaque);
+    }
+    
+    template<class F>
+    void tile(const BasicTarget<F>& target, const uint32_t* pixels, int srcStride, int srcW, int srcH,
+              int x, int y, int w, int h, uint32_t opacity, bool opaque) {
+        if (opacity == 0 || srcW <= 0 || srcH <= 0) return;
+        
+        int x0 = std::max(x, target.x0);
+        int y0 = std::max(y, target.y0);
+        int x1 = std::min(x + w, target.x1);
+        int y1 = std::min(y + h, target.y1);
+        if (x0 >= x1 || y0 >= y1) return;
+        
+        bool copy = opaque && opacity == 255;
+        for (int py = y0; py < y1; py++) {
+            const uint32_t* src = pixels + ((py - y) % srcH) * srcStride;
+            if (srcW == 1) {
+                fillSpan(target, py, x0, x1, Blend::scalePixel(src[0], opacity));
+                continue;
+            }
+            
+            typename F::Pixel* dst = target.row(py);
+            for (int px = x0; px < x1; ) {
+                int sx = (px - x) % srcW;
+                int count = std::min(srcW - sx, x1 - px);
+                if (copy) {
+                    F::copy(dst + px, src + sx, count);
+                } else {
+                    F::blend(dst + px, src + sx, count, opacity);
+                }
+                px += count;
+            }
+        }
+    }
+
+    template<class F>
+    void fillMask(const BasicTarget<F>& target, const uint8_t* mask, int maskStride, int w, int h,
+                  int x, int y, uint32_t pixel) {
+        if ((pixel & 0xFF) == 0) return;
+        
+        int x0 = std::max(x, target.x0);
+        int y0 = std::max(y, target.y0);
+        int x1 = std::min(x + w, target.x1);
+        int y1 = std::min(y + h, target.y1);
+        if (x0 >= x1 || y0 >= y1) return;
+        
+        for (int py = y0; py < y1; py++) {
+            F::mask(target.row(py) + x0, mask + (py - y) * maskStride + (x0 - x), x1 - x0, pixel);
+        }
+    }
+
+#define INSTANTIATE(F) \
+    template void plot(const BasicTarget<F>&, int, int, uint32_t); \
+    template void fillSpan(const BasicTarget<F>&, int, int, int, uint32_t); \
+    template void blendSpan(const BasicTarget<F>&, int, int, const uint32_t*, int, uint32_t); \
+    template void fillRect(const BasicTarget<F>&, int, int, int, int, uint32_t); \
+    template void fillRectFixed(const BasicTarget<F>&, Fixed, Fixed, Fixed, Fixed, uint32_t); \
+    template void fillRoundedRect(const BasicTarget<F>&, Fixed, Fixed, int, int, int, uint32_t); \
+    template void fillCircle(const BasicTarget<F>&, Fixed, Fixed, int, uint32_t); \
+    template void fillRoundedRectWithMask(const BasicTarget<F>&, Fixed, Fixed, int, int, const CornerMask&, uint32_t); \
+    template void blit(const BasicTarget<F>&, const uint32_t*, int, int, int, int, int, uint32_t, bool); \
+    template void tile(const BasicTarget<F>&, const uint32_t*, int, int, int, int, int, int, int, uint32_t, bool); \
+    template void fillMask(const BasicTarget<F>&, const uint8_t*, int, int, int, int, int, uint32_t);
+    
+    PIXEL_FORMATS(INSTANTIATE)
+#undef INSTANTIATE
+}
@@ -0,0 +1,110 @@
+#include "shadow_cache.h"
+#include "rasterizer.h"
+#include "blend.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+ShadowCache::ShadowCache() : clock(0), frame(1) {
+    for (int i = 0; i < MAX_ENTRIES; i++) {
+        entries[i].used = false;
+    }
+}
+
+const NinePatch* ShadowCache::get(int radius, int blur, uint32_t color) {
+    Entry* victim = nullptr;
+    for (int i = 0; i < MAX_ENTRIES; i++) {
+        Entry& entry = entries[i];
+        if (entry.used && entry.radius == radius && entry.blur == blur && entry.color == color) {
+            entry.lastUse = ++clock;
+            entry.lastFrame = frame;
+            return &entry.patch;
+        }
+        
+        // Свободная запись или давно не использованная, но не из текущего кадра
+        if (!entry.used) {
+            if (!victim || victim->used) victim = &entry;
+        } else if (entry.lastFrame != frame && (!victim || (victim->used && entry.lastUse < victim->lastUse))) {
+            victim = &entry;
+        }
+    }
+    
+    if (!victim) return nullptr;
+    
+    victim->used = build(victim->patch, radius, blur, color);
+    if (!victim->used) return nullptr;
+    
+    victim->radius = radius;
+    victim->blur = blur;
+    victim->color = color;
+    victim->lastUse = ++clock;
+    victim->lastFrame = frame;
+    return &victim->patch;
+}
+
+// Маска фигуры со стороной 2 * (r + blur) + 1 и отступом blur со всех сторон
+// размывается по строкам, затем по столбцам. Центральные строка и столбец
+// результата уже не зависят от скругления, поэтому их можно растягивать.
+bool ShadowCache::build(NinePatch& patch, int radius, int blur, uint32_t color) {
+    int pad = blur;
+    int extent = radius + blur;
+    int corner = pad + extent;
+    int size = 2 * corner + 1;
+    if (!patch.surface.create(size, size)) return false;
+    
+    patch.corner = corner;
+    patch.pad = pad;
+    
+    // Фигура рисуется тем же сглаженным fillRoundedRect, альфа становится маской
+    int side = 2 * extent + 1;
+    Raster::fillRoundedRect(patch.surface.target(), Raster::toFixed(pad), Raster::toFixed(pad),
+                            side, side, radius, 0xFFFFFFFF);
+    
+    std::vector<float> mask(size * size);
+    for (int y = 0; y < size; y++) {
+        const uint32_t* row = patch.surface.row(y);
+        for (int x = 0; x < size; x++) {
+            mask[y * size + x] = (row[x] & 0xFF) / 255.0f;
+        }
+    }
+    
+    if (blur > 0) {
+        // Гауссово ядро радиуса blur, sigma = blur / 2
+        std::vector<float> kernel(2 * blur + 1);
+        float sigma = blur * 0.5f;
+        float sum = 0.0f;
+        for (int i = -blur; i <= blur; i++) {
+            kernel[i + blur] = expf(-(float)(i * i) / (2.0f * sigma * sigma));
+            sum += kernel[i + blur];
+        }
+        for (float& k : kernel) k /= sum;
+        
+        std::vector<float> temp(size * size, 0.0f);
+        for (int y = 0; y < size; y++) {
+            for (int x = 0; x < size; x++) {
+                float value = 0.0f;
+                for (int i = std::max(-blur, -x); i <= std::min(blur, size - 1 - x); i++) {
+                    value += mask[y * size + x + i] * kernel[i + blur];
+                }
+                temp[y * size + x] = value;
+            }
+        }
+        for (int y = 0; y < size; y++) {
+            for (int x = 0; x < size; x++) {
+                float value = 0.0f;
+                for (int i = std::max(-blur, -y); i <= std::min(blur, size - 1 - y); i++) {
+                    value += temp[(y + i) * size + x] * kernel[i + blur];
+                }
+                mask[y * size + x] = value;
+            }
+        }
+    }
+    
+    for (int y = 0; y < size; y++) {
+        uint32_t* row = patch.surface.row(y);
+        for (int x = 0; x < size; x++) {
+            row[x] = Blend::scalePixel(color, Blend::opacityByte(mask[y * size + x]));
+        }
+    }
+    return true;
+}
@@ -1,29 +1,33 @@
 #include "simple_interface.h"
 #include "neocore.h"
+#include "blend.h"
+#include "font.h"
+#include "text_layout.h"
+#include <algorithm>
 #include <cstring>
 #include <fstream>
 
 SimpleInterface::SimpleInterface() 
     : currentScreen(Screen::MAIN), selectedItem(0), hasUserIcon(false), 
-      framebuffer(nullptr), width(0), height(0) {
+      framebuffer(nullptr), width(0), height(0),
+      clipX0(0), clipY0(0), clipX1(0), clipY1(0), layouts(new TextLayoutCache()) {
 }
 
 SimpleInterface::~SimpleInterface() {
     cleanup();
+    delete layouts;
 }
 
 bool SimpleInterface::initialize() {
     logToGraphics("Interface", "Initializing NEOVIA graphics interface...");
     
     // Инициализация графики
-    Result rc = gfxInitDefault();
-    if (R_FAILED(rc)) {
+    if (!PLATFORM->initialize(1280, 720)) {
         logToGraphics("Interface", "Failed to initialize graphics");
         return false;
     }
     
-    gfxConfigureResolution(1280, 720);
-    framebuffer = (uint32_t*)gfxGetFramebuffer(&width, &height);
+    framebuffer = PLATFORM->getFramebuffer(&width, &height);
     if (!framebuffer) {
         logToGraphics("Interface", "Failed to get framebuffer");
         return false;
@@ -31,6 +35,12 @@ bool SimpleInterface::initialize() {
     
     logToGraphics("Interface", "Graphics initialized: 1280x720");
     
+    // Первые два кадра рисуются целиком - по одному на каждый буфер
+    damage.setBounds(width, height);
+    previousDamage.setBounds(width, height);
+    previousDamage.clear();
+    invalidateAll();
+    
     // Инициализация NeoCore
     if (!g_neoCore.initialize()) {
         logToGraphics("Interface", "NeoCore not initialized, continuing without it");
@@ -47,7 +57,7 @@ bool SimpleInterface::initialize() {
 
 void SimpleInterface::cleanup() {
     logToGraphics("Interface", "Cleaning up graphics interface...");
-    gfxExit();
+    PLATFORM->shutdown();
     logToGraphics("Interface", "Graphics interface terminated");
 }
 
@@ -64,14 +74,42 @@ void SimpleInterface::checkForIcon() {
 }
 
 void SimpleInterface::render() {
-    framebuffer = (uint32_t*)gfxGetFramebuffer(&width, &height);
+    // Ни в этом, ни в прошлом кадре ничего не менялось - оба буфера актуальны,
+    // композиция и переключение буферов не нужны
+    if (damage.empty() && previousDamage.empty()) {
+        PLATFORM->waitForVsync();
+        return;
+    }
+    
+    framebuffer = PLATFORM->getFramebuffer(&width, &height);
+    layouts->beginFrame();
+    
+    // libnx чередует два буфера, и текущий задний буфер не видел изменений
+    // прошлого кадра - перерисовываем объединение обоих повреждений
+    DirtyRegion repaint = damage;
+    repaint.add(previousDamage);
     
-    // Очистка экрана (серый фон как в Switch)
     uint32_t bgColor = Colors::SWITCH_GRAY.toRGBA();
-    for (uint32_t i = 0; i < width * height; i++) {
-        framebuffer[i] = bgColor;
+    for (int i = 0; i < repaint.size(); i++) {
+        const DirtyRect& rect = repaint[i];
+        setClip(rect);
+        
+        // Очистка области (серый фон как в Switch)
+        for (int py = rect.y0; py < rect.y1; py++) {
+            std::fill(framebuffer + py * width + rect.x0, framebuffer + py * width + rect.x1, bgColor);
+        }
+        
+        renderScreen();
     }
     
+    setClip(DirtyRect{ 0, 0, (int)width, (int)height });
+    previousDamage = damage;
+    damage.clear();
+    
+    PLATFORM->present();
+}
+
+void SimpleInterface::renderScreen() {
     switch (currentScreen) {
         case Screen::MAIN:
             renderMainScreen();
@@ -86,10 +124,34 @@ void SimpleInterface::render() {
             renderAbout();
             break;
     }
-    
-    gfxFlushBuffers();
-    gfxSwapBuffers();
-    gfxWaitForVsync();
+}
+
+void SimpleInterface::invalidate(int x, int y, int w, int h) {
+    damage.add(x, y, w, h);
+}
+
+void SimpleInterface::invalidateAll() {
+    damage.addAll();
+}
+
+// Границы выделяемых элементов - совпадают с координатами в render*()
+void SimpleInterface::invalidateItem(Screen screen, int item) {
+    if (screen == Screen::MAIN) {
+        if (item == 0) {
+            invalidate(540, 350, 200, 60);
+        } else {
+            invalidate(50, 50, (int)strlen("☰") * 12, 24);
+        }
+    } else if (screen == Screen::MENU) {
+        invalidate(150, item == 0 ? 280 : 350, 300, 50);
+    }
+}
+
+void SimpleInterface::setClip(const DirtyRect& rect) {
+    clipX0 = rect.x0;
+    clipY0 = rect.y0;
+    clipX1 = rect.x1;
+    clipY1 = rect.y1;
 }
 
 void SimpleInterface::renderMainScreen() {
@@ -143,7 +205,7 @@ void SimpleInterface::renderAbout() {
     
     // Статус NeoCore
     std::string status = "NeoCore Engine: ";
-    Colors::Color statusColor = Colors::TEXT_GRAY;
+    Color statusColor = Colors::TEXT_GRAY;
     if (g_neoCore.isReady()) {
         status += "Готов";
         statusColor = Colors::GREEN_SUCCESS;
@@ -164,6 +226,9 @@ bool SimpleInterface::handleInput(u64 kDown) {
         return false;
     }
     
+    Screen previousScreen = currentScreen;
+    int previousItem = selectedItem;
+    
     switch (currentScreen) {
         case Screen::MAIN:
             if (kDown & HidNpadButton_Up) {
@@ -179,7 +244,7 @@ bool SimpleInterface::handleInput(u64 kDown) {
                 }
             }
             break;
-            
+        
         case Screen::MENU:
             if (kDown & HidNpadButton_B) {
                 currentScreen = Screen::MAIN;
@@ -195,7 +260,7 @@ bool SimpleInterface::handleInput(u64 kDown) {
                 }
             }
             break;
-            
+        
         case Screen::SETTINGS:
         case Screen::ABOUT:
             if (kDown & HidNpadButton_B) {
@@ -204,6 +269,14 @@ bool SimpleInterface::handleInput(u64 kDown) {
             break;
     }
     
+    // Смена экрана перерисовывает все, смена выделения - только два элемента
+    if (currentScreen != previousScreen) {
+        invalidateAll();
+    } else if (selectedItem != previousItem) {
+        invalidateItem(previousScreen, previousItem);
+        invalidateItem(currentScreen, selectedItem);
+    }
+    
     return true;
 }
 
@@ -215,9 +288,9 @@ void SimpleInterface::onEnhance() {
         logToGraphics("Interface", "NeoCore ready, starting graphics enhancement...");
         
         // Создаем информацию об игре (пример)
-        GameInfo gameInfo;
-        gameInfo.gameId = "current_game";
-        gameInfo.gameName = "Detected Game";
+        GameInfo gameInfo = {};
+        gameInfo.titleId = "current_game";
+        gameInfo.name = "Detected Game";
         gameInfo.hasCustomProfile = false;
         gameInfo.activeMods = {"shadows", "fxaa"};
         
@@ -244,117 +317,23 @@ void SimpleInterface::onAbout() {
 // Простые функции рисования
 void SimpleInterface::drawRect(float x, float y, float w, float h, const Color& color) {
     uint32_t col = color.toRGBA();
-    int x1 = (int)x, y1 = (int)y;
-    int x2 = (int)(x + w), y2 = (int)(y + h);
+    int x1 = std::max((int)x, clipX0), y1 = std::max((int)y, clipY0);
+    int x2 = std::min((int)(x + w), clipX1), y2 = std::min((int)(y + h), clipY1);
     
-    for (int py = y1; py < y2 && py < (int)height; py++) {
-        for (int px = x1; px < x2 && px < (int)width; px++) {
-            if (px >= 0 && py >= 0) {
-                framebuffer[py * width + px] = col;
-            }
+    for (int py = y1; py < y2; py++) {
+        for (int px = x1; px < x2; px++) {
+            framebuffer[py * width + px] = col;
         }
     }
 }
 
 void SimpleInterface::drawText(const std::string& text, float x, float y, const Color& color, int size) {
-    // Простой растровый шрифт 8x8
-    static const uint8_t font8x8[128][8] = {
-        {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // ' '
-        {0x18, 0x3C, 0x3C, 0x18, 0x18, 0x00, 0x18, 0x00}, // '!'
-        {0x36, 0x36, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // '"'
-        {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // '#'
-        {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // '$'
-        {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // '%'
-        {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // '&'
-        {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // '''
-        {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // '('
-        {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // ')'
-        {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // '*'
-        {0x00, 0x18, 0x18, 0x7E, 0x18, 0x18, 0x00, 0x00}, // '+'
-        {0x00, 0x00, 0x00, 0x00, 0x18, 0x18, 0x30, 0x00}, // ','
-        {0x00, 0x00, 0x00, 0x7E, 0x00, 0x00, 0x00, 0x00}, // '-'
-        {0x00, 0x00, 0x00, 0x00, 0x00, 0x18, 0x18, 0x00}, // '.'
-        {0x00, 0x03, 0x06, 0x0C, 0x18, 0x30, 0x60, 0x00}, // '/'
-        {0x3C, 0x66, 0x6E, 0x76, 0x66, 0x66, 0x3C, 0x00}, // '0'
-        {0x18, 0x18, 0x38, 0x18, 0x18, 0x18, 0x7E, 0x00}, // '1'
-        {0x3C, 0x66, 0x06, 0x0C, 0x30, 0x60, 0x7E, 0x00}, // '2'
-        {0x3C, 0x66, 0x06, 0x1C, 0x06, 0x66, 0x3C, 0x00}, // '3'
-        {0x06, 0x0E, 0x1E, 0x66, 0x7F, 0x06, 0x06, 0x00}, // '4'
-        {0x7E, 0x60, 0x7C, 0x06, 0x06, 0x66, 0x3C, 0x00}, // '5'
-        {0x3C, 0x66, 0x60, 0x7C, 0x66, 0x66, 0x3C, 0x00}, // '6'
-        {0x7E, 0x66, 0x0C, 0x18, 0x18, 0x18, 0x18, 0x00}, // '7'
-        {0x3C, 0x66, 0x66, 0x3C, 0x66, 0x66, 0x3C, 0x00}, // '8'
-        {0x3C, 0x66, 0x66, 0x3E, 0x06, 0x66, 0x3C, 0x00}, // '9'
-        {0x00, 0x00, 0x18, 0x00, 0x00, 0x18, 0x00, 0x00}, // ':'
-        {0x00, 0x00, 0x18, 0x00, 0x00, 0x18, 0x30, 0x00}, // ';'
-        {0x0E, 0x18, 0x30, 0x60, 0x30, 0x18, 0x0E, 0x00}, // '<'
-        {0x00, 0x00, 0x7E, 0x00, 0x7E, 0x00, 0x00, 0x00}, // '='
-        {0x70, 0x18, 0x0C, 0x06, 0x0C, 0x18, 0x70, 0x00}, // '>'
-        {0x3C, 0x66, 0x06, 0x0C, 0x18, 0x00, 0x18, 0x00}, // '?'
-        {0x3C, 0x66, 0x6E, 0x6E, 0x60, 0x62, 0x3C, 0x00}, // '@'
-        {0x18, 0x3C, 0x66, 0x7E, 0x66, 0x66, 0x66, 0x00}, // 'A'
-        {0x7C, 0x66, 0x66, 0x7C, 0x66, 0x66, 0x7C, 0x00}, // 'B'
-        {0x3C, 0x66, 0x60, 0x60, 0x60, 0x66, 0x3C, 0x00}, // 'C'
-        {0x78, 0x6C, 0x66, 0x66, 0x66, 0x6C, 0x78, 0x00}, // 'D'
-        {0x7E, 0x60, 0x60, 0x78, 0x60, 0x60, 0x7E, 0x00}, // 'E'
-        {0x7E, 0x60, 0x60, 0x78, 0x60, 0x60, 0x60, 0x00}, // 'F'
-        {0x3C, 0x66, 0x60, 0x6E, 0x66, 0x66, 0x3C, 0x00}, // 'G'
-        {0x66, 0x66, 0x66, 0x7E, 0x66, 0x66, 0x66, 0x00}, // 'H'
-        {0x3C, 0x18, 0x18, 0x18, 0x18, 0x18, 0x3C, 0x00}, // 'I'
-        {0x1E, 0x0C, 0x0C, 0x0C, 0x0C, 0x6C, 0x38, 0x00}, // 'J'
-        {0x66, 0x6C, 0x78, 0x70, 0x78, 0x6C, 0x66, 0x00}, // 'K'
-        {0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x7E, 0x00}, // 'L'
-        {0x63, 0x77, 0x7F, 0x6B, 0x63, 0x63, 0x63, 0x00}, // 'M'
-        {0x66, 0x76, 0x7E, 0x7E, 0x6E, 0x66, 0x66, 0x00}, // 'N'
-        {0x3C, 0x66, 0x66, 0x66, 0x66, 0x66, 0x3C, 0x00}, // 'O'
-        {0x7C, 0x66, 0x66, 0x7C, 0x60, 0x60, 0x60, 0x00}, // 'P'
-        {0x3C, 0x66, 0x66, 0x66, 0x66, 0x3C, 0x0E, 0x00}, // 'Q'
-        {0x7C, 0x66, 0x66, 0x7C, 0x78, 0x6C, 0x66, 0x00}, // 'R'
-        {0x3C, 0x66, 0x60, 0x3C, 0x06, 0x66, 0x3C, 0x00}, // 'S'
-        {0x7E, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x00}, // 'T'
-        {0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x3C, 0x00}, // 'U'
-        {0x66, 0x66, 0x66, 0x66, 0x66, 0x3C, 0x18, 0x00}, // 'V'
-        {0x63, 0x63, 0x63, 0x6B, 0x7F, 0x77, 0x63, 0x00}, // 'W'
-        {0x66, 0x66, 0x3C, 0x18, 0x3C, 0x66, 0x66, 0x00}, // 'X'
-        {0x66, 0x66, 0x66, 0x3C, 0x18, 0x18, 0x18, 0x00}, // 'Y'
-        {0x7E, 0x06, 0x0C, 0x18, 0x30, 0x60, 0x7E, 0x00}, // 'Z'
-    };
+    if (color.a == 0) return;
     
-    int charWidth = size / 2;
-    int charHeight = size;
-    
-    for (size_t i = 0; i < text.length(); i++) {
-        unsigned char c = text[i];
-        
-        // Простая поддержка кириллицы
-        if (c >= 192 && c <= 255) {
-            // Русские буквы - используем латинские аналоги
-            static const char cyrillicMap[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
-            c = cyrillicMap[(c - 192) % 26];
-        } else if (c < 32 || c > 126) {
-            c = '?';
-        }
-        
-        const uint8_t* fontData = font8x8[c];
-        
-        for (int py = 0; py < 8; py++) {
-            uint8_t row = fontData[py];
-            for (int px = 0; px < 8; px++) {
-                if (row & (1 << (7 - px))) {
-                    // Масштабирование пикселя
-                    for (int sy = 0; sy < charHeight / 8; sy++) {
-                        for (int sx = 0; sx < charWidth / 8; sx++) {
-                            int drawX = x + i * charWidth + px * (charWidth / 8) + sx;
-                            int drawY = y + py * (charHeight / 8) + sy;
-                            if (drawX >= 0 && drawX < (int)width && drawY >= 0 && drawY < (int)height) {
-                                framebuffer[drawY * width + drawX] = color.toRGBA();
-                            }
-                        }
-                    }
-                }
-            }
-        }
-    }
+    // Кадровый буфер интерфейса - RGBA8 с шагом строки width
+    Raster::Target target(framebuffer, width, 0, 0, width, height);
+    layouts->get(text, size)->draw(target.clip(clipX0, clipY0, clipX1, clipY1), (int)x, (int)y,
+                                   Blend::premultiply(color.toRGBA()));
 }
 
 void SimpleInterface::drawButton(const std::string& text, float x, float y, float w, float h, bool selected) {
@@ -362,7 +341,7 @@ void SimpleInterface::drawButton(const std::string& text, float x, float y, floa
     Color textColor = selected ? Colors::WHITE : Colors::BLACK;
     
     drawRect(x, y, w, h, bgColor);
-    drawText(text, x + w/2 - text.length() * 4, y + h/2 - 8, textColor, 16);
+    drawText(text, x + (w - layouts->get(text, 16)->width) / 2, y + h/2 - 8, textColor, 16);
 }
 
 void SimpleInterface::drawIcon(float x, float y, float size) {
@@ -0,0 +1,49 @@
+#include "surface.h"
+#include "blend.h"
+#include <algorithm>
+#include <cstdlib>
+
+Surface::Surface() : pixels(nullptr), width(0), height(0), stride(0), opaque(false) {
+}
+
+Surface::Surface(int w, int h) : Surface() {
+    create(w, h);
+}
+
+Surface::~Surface() {
+    release();
+}
+
+bool Surface::create(int w, int h) {
+    release();
+    if (w <= 0 || h <= 0) return false;
+    
+    // Шаг строки кратен 16 пикселям (64 байтам), размер буфера - тоже
+    int pitch = (w + 15) & ~15;
+    pixels = (uint32_t*)aligned_alloc(64, (size_t)pitch * h * sizeof(uint32_t));
+    if (!pixels) return false;
+    
+    width = w;
+    height = h;
+    stride = pitch;
+    clear();
+    return true;
+}
+
+void Surface::release() {
+    free(pixels);
+    pixels = nullptr;
+    width = height = stride = 0;
+}
+
+void Surface::clear(uint32_t pixel) {
+    if (!pixels) return;
+    std::fill(pixels, pixels + stride * height, pixel);
+}
+
+void Surface::blit(const Surface& source, int x, int y, float opacity) {
+    if (!pixels || !source.valid()) return;
+    
+    Raster::blit(target(), source.getPixels(), source.getStride(), source.getWidth(), source.getHeight(),
+                 x, y, Blend::opacityByte(opacity), source.isOpaque());
+}
@@ -0,0 +1,123 @@
+#include "text_layout.h"
+#include "utf8.h"
+#include <algorithm>
+
+void TextLayout::build(const FontFace* fontFace, const char* text, size_t length) {
+    face = fontFace;
+    glyphs.clear();
+    x.clear();
+    lines.clear();
+    width = 0;
+    
+    const unsigned char* p = (const unsigned char*)text;
+    const unsigned char* end = p + length;
+    Line line = { 0, 0, 0 };
+    while (p < end) {
+        uint32_t c = Utf8::next(p, end);
+        if (c == '\n') {
+            lines.push_back(line);
+            width = std::max(width, line.width);
+            line = { (int)glyphs.size(), 0, 0 };
+            continue;
+        }
+        uint16_t index = face->glyphIndex(c);
+        glyphs.push_back(index);
+        x.push_back(line.width);
+        line.count++;
+        line.width += face->glyphAt(index).advance;
+    }
+    lines.push_back(line);
+    width = std::max(width, line.width);
+    height = (int)lines.size() * face->getSize();
+}
+
+template<class F>
+void TextLayout::draw(const Raster::BasicTarget<F>& target, int x0, int y, uint32_t pixel) const {
+    int size = face->getSize();
+    for (const Line& line : lines) {
+        // Нижние выносные заходят на пиксель ниже строки
+        if (y >= target.y1) break;
+        if (y + size + 1 > target.y0) {
+            for (int i = line.first; i < line.first + line.count; i++) {
+                const Glyph& g = face->glyphAt(glyphs[i]);
+                int gx = x0 + x[i];
+                if (gx >= target.x1) break;
+                if (g.width && gx + g.width > target.x0) {
+                    Raster::fillMask(target, face->coverage(g), g.width, g.width, g.height, gx, y + g.top, pixel);
+                }
+            }
+        }
+        y += size;
+    }
+}
+
+size_t TextLayout::memoryBytes() const {
+    return glyphs.capacity() * sizeof(uint16_t) + x.capacity() * sizeof(int32_t) + lines.capacity() * sizeof(Line);
+}
+
+#define INSTANTIATE(F) \
+    template void TextLayout::draw(const Raster::BasicTarget<F>&, int, int, uint32_t) const;
+
+PIXEL_FORMATS(INSTANTIATE)
+#undef INSTANTIATE
+
+TextLayoutCache::TextLayoutCache() : bytes(0), clock(0), hits(0), misses(0) {
+}
+
+// FNV-1a по байтам строки, начиная с размера шрифта
+uint64_t TextLayoutCache::hash(const std::string& text, int size) {
+    uint64_t h = 0xCBF29CE484222325ull ^ (uint64_t)size;
+    for (unsigned char c : text) {
+        h = (h ^ c) * 0x100000001B3ull;
+    }
+    return h;
+}
+
+void TextLayoutCache::beginFrame() {
+    hits = 0;
+    misses = 0;
+    if (bytes <= MAX_BYTES) return;
+    
+    // Удаляются самые старые записи, пока кэш не уменьшится до половины бюджета
+    std::vector<std::pair<unsigned, uint64_t>> order;
+    order.reserve(entries.size());
+    for (const auto& item : entries) {
+        order.push_back({ item.second.lastUse, item.first });
+    }
+    std::sort(order.begin(), order.end());
+    for (const auto& victim : order) {
+        if (bytes <= MAX_BYTES / 2) break;
+        auto range = entries.equal_range(victim.second);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->second.lastUse == victim.first) {
+                bytes -= it->second.bytes;
+                entries.erase(it);
+                break;
+            }
+        }
+    }
+}
+
+const TextLayout* TextLayoutCache::get(const std::string& text, int size) {
+    size = FontCache::clampSize(size);
+    uint64_t key = hash(text, size);
+    auto range = entries.equal_range(key);
+    for (auto it = range.first; it != range.second; ++it) {
+        Entry& entry = it->second;
+        if (entry.size == size && entry.text == text) {
+            entry.lastUse = ++clock;
+            hits++;
+            return &entry.layout;
+        }
+    }
+    
+    misses++;
+    Entry& entry = entries.emplace(key, Entry())->second;
+    entry.text = text;
+    entry.size = size;
+    entry.lastUse = ++clock;
+    entry.layout.build(FONTS->get(size), text.data(), text.size());
+    entry.bytes = sizeof(Entry) + entry.text.capacity() + entry.layout.memoryBytes();
+    bytes += entry.bytes;
+    return &entry.layout;
+}
@@ -0,0 +1,131 @@
+#include "rasterizer.h"
+#include "blend.h"
+#include <algorithm>
+
+namespace {
+
+    const int64_t ONE = 65536;
+    
+    // Выборки строки собираются кусками такой длины и смешиваются одним вызовом
+    const int CHUNK = 256;
+    
+    // Деление с округлением вниз на положительное d
+    int64_t floorDiv(int64_t a, int64_t d) {
+        return a >= 0 ? a / d : -((d - 1 - a) / d);
+    }
+    
+    // Сужение шагов [first, last) до тех, при которых lo <= u + i * du < hi.
+    // Пустой результат - first >= last.
+    void narrow(int64_t u, int64_t du, int64_t lo, int64_t hi, int& first, int& last) {
+        if (du == 0) {
+            if (u < lo || u >= hi) last = first;
+            return;
+        }
+        int64_t a, b;
+        if (du > 0) {
+            a = -floorDiv(u - lo, du);
+            b = -floorDiv(u - hi, du);
+        } else {
+            a = floorDiv(u - hi, -du) + 1;
+            b = floorDiv(u - lo, -du) + 1;
+        }
+        first = (int)std::max<int64_t>(first, a);
+        last = (int)std::min<int64_t>(last, b);
+    }
+    
+    // Пиксель источника; за его пределами - прозрачный
+    inline uint32_t texel(const uint32_t* pixels, int stride, int w, int h, int x, int y) {
+        return (unsigned)x < (unsigned)w && (unsigned)y < (unsigned)h ? pixels[y * stride + x] : 0;
+    }
+    
+    // Билинейная выборка у края, где часть соседей вне источника
+    void sampleEdge(uint32_t* dst, const uint32_t* pixels, int stride, int w, int h,
+                    int32_t u, int32_t v, int32_t du, int32_t dv, int count) {
+        for (int i = 0; i < count; i++, u += du, v += dv) {
+            int x = u >> 16, y = v >> 16;
+            dst[i] = Blend::bilinearPixel(texel(pixels, stride, w, h, x, y),
+                                          texel(pixels, stride, w, h, x + 1, y),
+                                          texel(pixels, stride, w, h, x, y + 1),
+                                          texel(pixels, stride, w, h, x + 1, y + 1),
+                                          (u >> 8) & 0xFF, (v >> 8) & 0xFF);
+        }
+    }
+    
+    void sampleNearest(uint32_t* dst, const uint32_t* pixels, int stride,
+                       int32_t u, int32_t v, int32_t du, int32_t dv, int count) {
+        for (int i = 0; i < count; i++, u += du, v += dv) {
+            dst[i] = pixels[(v >> 16) * stride + (u >> 16)];
+        }
+    }
+}
+
+namespace Raster {
+
+    // Координаты строки считаются от опорного пикселя отображения, а не от
+    // начала цели, поэтому тайлы отложенного рендера дают те же выборки
+    template<class F>
+    void blitAffine(const BasicTarget<F>& target, const uint32_t* pixels, int srcStride, int srcW, int srcH,
+                    const AffineMap& map, uint32_t opacity, bool bilinear) {
+        if (opacity == 0 || srcW <= 0 || srcH <= 0 || !target.valid()) return;
+        
+        // Билинейная выборка смешивает соседей точки, сдвинутой на полпикселя:
+        // пиксель задет, пока внутри источника хотя бы один сосед, а внутренний
+        // отрезок строки (все четыре соседа внутри) идет без проверок
+        int64_t bias = bilinear ? ONE / 2 : 0;
+        int64_t lo = bilinear ? 1 - ONE : 0;
+        int64_t uInner = (int64_t)(srcW - 1) * ONE, vInner = (int64_t)(srcH - 1) * ONE;
+        int n = target.x1 - target.x0;
+        uint32_t buffer[CHUNK];
+        
+        for (int py = target.y0; py < target.y1; py++) {
+            int64_t dx = target.x0 - map.x, dy = py - map.y;
+            int64_t u = map.u + dx * map.dudx + dy * map.dudy - bias;
+            int64_t v = map.v + dx * map.dvdx + dy * map.dvdy - bias;
+            
+            int first = 0, last = n;
+            narrow(u, map.dudx, lo, (int64_t)srcW * ONE, first, last);
+            narrow(v, map.dvdx, lo, (int64_t)srcH * ONE, first, last);
+            if (first >= last) continue;
+            
+            int innerFirst = first, innerLast = last;
+            if (bilinear) {
+                narrow(u, map.dudx, 0, uInner, innerFirst, innerLast);
+                narrow(v, map.dvdx, 0, vInner, innerFirst, innerLast);
+                if (innerFirst >= innerLast) innerFirst = innerLast = last;
+            }
+            
+            typename F::Pixel* dst = target.row(py) + target.x0;
+            for (int i = first; i < last; ) {
+                int end = std::min(last, i + CHUNK);
+                if (!bilinear) {
+                    int32_t su = (int32_t)(u + i * (int64_t)map.dudx);
+                    int32_t sv = (int32_t)(v + i * (int64_t)map.dvdx);
+                    sampleNearest(buffer, pixels, srcStride, su, sv, map.dudx, map.dvdx, end - i);
+                } else {
+                    // Край, внутренняя часть и снова край в пределах куска
+                    for (int k = i; k < end; ) {
+                        bool inner = k >= innerFirst && k < innerLast;
+                        int stop = inner ? std::min(end, innerLast) : k < innerFirst ? std::min(end, innerFirst) : end;
+                        int32_t ku = (int32_t)(u + k * (int64_t)map.dudx);
+                        int32_t kv = (int32_t)(v + k * (int64_t)map.dvdx);
+                        if (inner) {
+                            Blend::sampleBilinear(buffer + (k - i), pixels, srcStride, ku, kv, map.dudx, map.dvdx, stop - k);
+                        } else {
+                            sampleEdge(buffer + (k - i), pixels, srcStride, srcW, srcH, ku, kv, map.dudx, map.dvdx, stop - k);
+                        }
+                        k = stop;
+                    }
+                }
+                
+                F::blend(dst + i, buffer, end - i, opacity);
+                i = end;
+            }
+        }
+    }
+
+#define INSTANTIATE(F) \
+    template void blitAffine(const BasicTarget<F>&, const uint32_t*, int, int, int, const AffineMap&, uint32_t, bool);
+    
+    PIXEL_FORMATS(INSTANTIATE)
+#undef INSTANTIATE
+}
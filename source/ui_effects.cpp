@@ -1,8 +1,9 @@
 #include "graphics.h"
+#include <algorithm>
 #include <cmath>
 
 namespace UIEffects {
-    
+
     // Эффект появления элемента
     void drawFadeInEffect(float x, float y, float width, float height, float progress, const Color& color) {
         // progress от 0.0 до 1.0
@@ -44,24 +45,14 @@ namespace UIEffects {
     
     // Эффект свечения текста
     void drawGlowText(const std::string& text, float x, float y, const Color& color, int fontSize, float glowIntensity = 0.5f) {
-        // Рисуем свечение (несколько слоев с разной прозрачностью)
-        for (int offset = 3; offset > 0; offset--) {
-            uint8_t glowAlpha = (uint8_t)(color.a * glowIntensity * (float)offset / 3.0f);
-            Color glowColor(color.r, color.g, color.b, glowAlpha);
-            
-            // Рисуем текст со смещением во все стороны
-            GFX->drawText(text, x - offset, y, glowColor, fontSize);
-            GFX->drawText(text, x + offset, y, glowColor, fontSize);
-            GFX->drawText(text, x, y - offset, glowColor, fontSize);
-            GFX->drawText(text, x, y + offset, glowColor, fontSize);
-            GFX->drawText(text, x - offset, y - offset, glowColor, fontSize);
-            GFX->drawText(text, x + offset, y + offset, glowColor, fontSize);
-            GFX->drawText(text, x - offset, y + offset, glowColor, fontSize);
-            GFX->drawText(text, x + offset, y - offset, glowColor, fontSize);
-        }
-        
-        // Основной текст
-        GFX->drawText(text, x, y, color, fontSize);
+        // Текст и свечение радиусом 3 пикселя за один проход по полю расстояний
+        TextStyle style;
+        style.fill = color;
+        style.outline = Color(0, 0, 0, 0);
+        style.glow = Color(color.r, color.g, color.b, (uint8_t)(color.a * std::min(1.0f, glowIntensity)));
+        style.outlineWidth = 0.0f;
+        style.glowRadius = 3.0f;
+        GFX->drawStyledText(text, x, y, fontSize, style);
     }
     
     // Эффект искр
@@ -218,7 +209,7 @@ void Button::render(float deltaTime) {
     // Базовая анимация
     float scale = scaleAnimation.update(deltaTime);
     float press = pressAnimation.update(deltaTime);
-    float hover = hoverAnimation.update(deltaTime);
+    hoverAnimation.update(deltaTime);
     
     // Эффект свечения при наведении
     if (hovered || pressed) {
@@ -254,7 +245,9 @@ void Button::render(float deltaTime) {
     
     // Текст с эффектом свечения
     if (hovered || pressed) {
-        UIEffects::drawGlowText(text, renderX + renderW/2 - text.length() * 4, 
+        int textWidth, textHeight;
+        GFX->getTextSize(text, 16, textWidth, textHeight);
+        UIEffects::drawGlowText(text, renderX + (renderW - textWidth) / 2, 
                                renderY + renderH/2 - 8, textColor, 16, 0.3f);
     } else {
         GFX->drawTextCentered(text, renderX, renderY + renderH/2 - 8, renderW, textColor, 16);
@@ -0,0 +1,136 @@
+#include "worker_pool.h"
+#include <algorithm>
+
+WorkerPool::WorkerPool()
+    : threadCount(0), task(nullptr), generation(0), pending(0), stopping(false) {
+    for (int i = 0; i < MAX_WORKERS; i++) {
+        queues[i].next = 0;
+        queues[i].end = 0;
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    stop();
+}
+
+bool WorkerPool::start(int count) {
+    stop();
+    count = std::max(0, std::min(count, MAX_WORKERS));
+    stopping = false;
+    
+    for (int i = 0; i < count; i++) {
+        args[i].pool = this;
+        args[i].id = i;
+        args[i].generation = generation;
+#ifdef __SWITCH__
+        // Поток i закреплен за ядром i; приоритет как у основного потока
+        s32 priority = 0x2C;
+        svcGetThreadPriority(&priority, CUR_THREAD_HANDLE);
+        if (R_FAILED(threadCreate(&threads[i], threadEntry, &args[i], NULL, 0x10000, priority, i))) {
+            break;
+        }
+        if (R_FAILED(threadStart(&threads[i]))) {
+            threadClose(&threads[i]);
+            break;
+        }
+#else
+        threads[i] = std::thread(threadEntry, &args[i]);
+#endif
+        threadCount = i + 1;
+    }
+    
+    return threadCount == count;
+}
+
+int WorkerPool::getCoreCount() {
+#ifdef __SWITCH__
+    return MAX_WORKERS;
+#else
+    return std::max(1, (int)std::thread::hardware_concurrency());
+#endif
+}
+
+void WorkerPool::stop() {
+    if (threadCount == 0) return;
+    
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    
+    for (int i = 0; i < threadCount; i++) {
+#ifdef __SWITCH__
+        threadWaitForExit(&threads[i]);
+        threadClose(&threads[i]);
+#else
+        threads[i].join();
+#endif
+    }
+    threadCount = 0;
+}
+
+void WorkerPool::run(int count, const Task& fn) {
+    if (count <= 0) return;
+    
+    if (threadCount == 0) {
+        for (int i = 0; i < count; i++) {
+            fn(i, 0);
+        }
+        return;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        
+        // Каждому потоку - свой непрерывный диапазон
+        for (int i = 0; i < threadCount; i++) {
+            queues[i].next = count * i / threadCount;
+            queues[i].end = count * (i + 1) / threadCount;
+        }
+        task = &fn;
+        pending = threadCount;
+        generation++;
+    }
+    wake.notify_all();
+    
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] { return pending == 0; });
+    task = nullptr;
+}
+
+void WorkerPool::threadEntry(void* arg) {
+    WorkerArgs* workerArgs = (WorkerArgs*)arg;
+    workerArgs->pool->workerLoop(workerArgs->id, workerArgs->generation);
+}
+
+void WorkerPool::workerLoop(int id, unsigned seen) {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+        }
+        
+        process(id);
+        
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--pending == 0) {
+            done.notify_one();
+        }
+    }
+}
+
+// Сначала свой диапазон, затем кража из диапазонов соседей.
+// Индекс забирается атомарным инкрементом, поэтому каждый элемент
+// выполняется ровно одним потоком.
+void WorkerPool::process(int id) {
+    for (int k = 0; k < threadCount; k++) {
+        Queue& queue = queues[(id + k) % threadCount];
+        int index;
+        while ((index = queue.next.fetch_add(1)) < queue.end) {
+            (*task)(index, id);
+        }
+    }
+}